@@ -0,0 +1,1472 @@
+// MyMath Microbenchmarks
+// Standalone and dependency free (only the portable engine headers), times every MyMath primitive over large
+// randomized arrays and compares the scalar reference against the SIMD kernels (forced with setSimdLevel).
+//
+// Build (Linux, from the repository root):
+//   g++ -std=c++17 -O2 -march=native -pthread Benchmarks/MyMathBenchmark.cpp -o mymath-bench
+// C++17 is required for the aligned new of std::vector<Matrix> (Matrix is alignas(64)), MSVC builds it with /std:c++17.
+// Add -DMYMATH_EXPRESSION_TEMPLATES for a second binary that times the expression template build of
+// Vec3/Vec4/Colour (the vec3.lerp rows compare the operator syntax against a hand-fused loop).
+//
+// Usage: mymath-bench [--check] [--json] [--filter text] [--samples n] [--size n] [--models dir]
+//   --check    only compare the SIMD kernels, box packets and compressed animation sampling against the scalar ones,
+//              the Quaternion methods against their identities and warm GJK and narrowphase caches against cold ones,
+//              exits with 1 when any of them is out of tolerance
+//   --json     print the results as JSON instead of a table (for tracking over time)
+//   --filter   only run benchmarks whose name contains text
+//   --samples  timed repetitions per benchmark (default 31), the table reports median and percentiles
+//   --size     elements per input array (default 16384)
+//   --models   folder of the GEM models for the mesh raycast, hitbox and hull rows (default
+//              WM9M2Assignment5749205/Models, so run from the repository root), the rows are skipped when a model
+//              is missing
+//
+// Every sample runs the kernel over the whole array, ns/op is the sample time divided by the element count.
+// Results are written to output arrays and folded into a checksum that is passed through keep(), so the
+// compiler cannot drop the work.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../WM9M2Assignment5749205/MyMath.h"
+#include "../WM9M2Assignment5749205/Collision.h"
+#include "../WM9M2Assignment5749205/Animation.h"
+#include "../WM9M2Assignment5749205/MeshCollider.h"
+#include "../WM9M2Assignment5749205/HitboxRig.h"
+#include "../WM9M2Assignment5749205/ConvexHull.h"
+#include "../WM9M2Assignment5749205/Narrowphase.h"
+
+// Dead-Code Elimination Barriers
+#if defined(__GNUC__) || defined(__clang__)
+template<typename Type>
+static void keep(const Type& value) { asm volatile("" : : "r,m"(value) : "memory"); }
+static void clobber() { asm volatile("" : : : "memory"); }
+#else
+static volatile float keepSink;
+template<typename Type>
+static void keep(const Type& value) { keepSink = *reinterpret_cast<const volatile float*>(&value); }
+static void clobber() { _ReadWriteBarrier(); }
+#endif
+
+// Options
+struct Options {
+	bool check = false;
+	bool json = false;
+	std::string filter;
+	int samples = 31;
+	int size = 16384;
+	std::string models = "WM9M2Assignment5749205/Models";
+};
+
+static Options options;
+
+// Results
+struct Result {
+	std::string name;
+	std::string variant;
+	double minimum, p10, median, p90, p99;
+};
+
+static std::vector<Result> results;
+
+static double percentile(const std::vector<double>& sorted, double p) {
+	double index = p * (sorted.size() - 1);
+	size_t lo = (size_t)index;
+	size_t hi = std::min<size_t>(lo + 1, sorted.size() - 1);
+	return sorted[lo] + (sorted[hi] - sorted[lo]) * (index - lo);
+}
+
+// Times fn (which processes ops elements) options.samples times after one warm-up run
+template<typename Fn>
+static void run(const char* name, const char* variant, int ops, Fn fn) {
+	if (!options.filter.empty() && std::string(name).find(options.filter) == std::string::npos) return;
+
+	fn();
+	std::vector<double> ns(options.samples);
+	for (int s = 0; s < options.samples; s++) {
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		clobber();
+		auto end = std::chrono::steady_clock::now();
+		ns[s] = std::chrono::duration<double, std::nano>(end - start).count() / ops;
+	}
+	std::sort(ns.begin(), ns.end());
+
+	Result r = { name, variant, ns.front(), percentile(ns, 0.1), percentile(ns, 0.5), percentile(ns, 0.9), percentile(ns, 0.99) };
+	results.push_back(r);
+	if (!options.json)
+		printf("%-28s %-22s %10.3f %10.3f %10.3f %10.3f %12.2f\n", name, variant, r.median, r.p10, r.p90, r.p99, 1e3 / r.median);
+}
+
+// SIMD Levels
+static const char* simdName(SimdLevel level) {
+	return level == SimdAVX2 ? "avx2" : (level == SimdSSE ? "sse" : "scalar");
+}
+
+// Runs fn once for every SIMD level the CPU supports with the kernel tables switched to that level
+template<typename Fn>
+static void forEachSimdLevel(Fn fn) {
+	const SimdLevel levels[] = { SimdScalar, SimdSSE, SimdAVX2 };
+	for (SimdLevel level : levels)
+		if (setSimdLevel(level) == level) fn(simdName(level));
+	setSimdLevel(SimdAVX2);
+}
+
+// Random Inputs
+static std::mt19937 rng(5749205);
+
+static float randomFloat(float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(rng); }
+static Vec3 randomVec3(float range) { return Vec3(randomFloat(-range, range), randomFloat(-range, range), randomFloat(-range, range)); }
+
+static Quaternion randomQuaternion() {
+	return Quaternion(randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f)).normalize();
+}
+
+// Well conditioned affine transforms, like the world and bone matrices the engine builds
+static Matrix randomMatrix() {
+	return Matrix::fromTRS(randomVec3(100.f), randomQuaternion(), Vec3(randomFloat(0.5f, 2.f), randomFloat(0.5f, 2.f), randomFloat(0.5f, 2.f)));
+}
+
+// Set bits in a lane mask
+static int bitCount(int mask) {
+	int count = 0;
+	for (; mask; mask &= mask - 1) count++;
+	return count;
+}
+
+// Kernel Check
+// Every dispatched kernel at every SIMD level against the scalar level on the same random inputs. The levels may
+// only differ by rounding (FMA contraction of the scalar code, the 2x2 sub-determinant invert), errors are relative
+// to the magnitude of the scalar result
+struct KernelOutputs {
+	std::vector<Matrix> inverses;
+	std::vector<Vec3> points, vectors;
+	std::vector<Quaternion> slerps, nlerps;
+};
+
+static float relativeError(float value, float reference) { return fabsf(value - reference) / std::max<float>(1.f, fabsf(reference)); }
+
+static bool checkKernels(int n) {
+	std::vector<Matrix> matrices(n);
+	std::vector<Vec3> points(n);
+	std::vector<Quaternion> from(n), to(n);
+	for (int i = 0; i < n; i++) { matrices[i] = randomMatrix(); points[i] = randomVec3(100.f); from[i] = randomQuaternion(); to[i] = randomQuaternion(); }
+
+	auto evaluate = [&](KernelOutputs& out) {
+		out.inverses.resize(n); out.points.resize(n); out.vectors.resize(n); out.slerps.resize(n); out.nlerps.resize(n);
+		for (int i = 0; i < n; i++) out.inverses[i] = matrices[i].invert();
+		transformPoints(matrices[0], points.data(), out.points.data(), n);
+		transformVectors(matrices[0], points.data(), out.vectors.data(), n);
+		interpolateQuaternions(from.data(), to.data(), out.slerps.data(), n, 0.37f, QuaternionSlerp);
+		interpolateQuaternions(from.data(), to.data(), out.nlerps.data(), n, 0.37f, QuaternionNlerp);
+	};
+
+	KernelOutputs reference;
+	setSimdLevel(SimdScalar);
+	evaluate(reference);
+
+	bool passed = true;
+	printf("%-8s %12s %12s %12s %12s %12s\n", "level", "invert", "points", "vectors", "slerp", "nlerp");
+	forEachSimdLevel([&](const char* level) {
+		KernelOutputs out;
+		evaluate(out);
+		float errors[5] = {};
+		for (int i = 0; i < n; i++) {
+			for (int k = 0; k < 16; k++) errors[0] = std::max<float>(errors[0], relativeError(out.inverses[i].m[k], reference.inverses[i].m[k]));
+			for (int k = 0; k < 3; k++) {
+				errors[1] = std::max<float>(errors[1], relativeError(out.points[i].v[k], reference.points[i].v[k]));
+				errors[2] = std::max<float>(errors[2], relativeError(out.vectors[i].v[k], reference.vectors[i].v[k]));
+			}
+			for (int k = 0; k < 4; k++) {
+				errors[3] = std::max<float>(errors[3], relativeError(out.slerps[i].q[k], reference.slerps[i].q[k]));
+				errors[4] = std::max<float>(errors[4], relativeError(out.nlerps[i].q[k], reference.nlerps[i].q[k]));
+			}
+		}
+		const float tolerances[5] = { 1e-4f, 1e-5f, 1e-5f, 1e-4f, 1e-5f };
+		bool levelPassed = true;
+		for (int k = 0; k < 5; k++) levelPassed &= errors[k] <= tolerances[k];
+		printf("%-8s %12.3g %12.3g %12.3g %12.3g %12.3g  %s\n", level, errors[0], errors[1], errors[2], errors[3], errors[4], levelPassed ? "ok" : "FAILED");
+		passed &= levelPassed;
+	});
+	return passed;
+}
+
+// Quaternion Check
+// The Quaternion methods build their results with the (d, a, b, c) constructor, each is checked against what it has to
+// satisfy: q q* = |q|^2, q^-1 q = 1 (for quaternions that are not unit length too), the member, operator and free
+// products agree, and the axis-angle rotation keeps its axis and turns a perpendicular vector by the angle
+static bool checkQuaternions(int n) {
+	float errors[5] = {};
+	for (int i = 0; i < n; i++) {
+		Quaternion q = randomQuaternion(), r = randomQuaternion();
+		float scale = randomFloat(0.5f, 2.f);
+		Quaternion s(q.d * scale, q.a * scale, q.b * scale, q.c * scale);
+
+		Quaternion norm = s * s.conjugate();
+		float square = scale * scale;
+		errors[0] = std::max<float>(errors[0], std::max<float>(fabsf(norm.d - square) / square, fabsf(norm.a) + fabsf(norm.b) + fabsf(norm.c)));
+		Quaternion identity = s.inverse() * s;
+		errors[1] = std::max<float>(errors[1], fabsf(identity.d - 1.f) + fabsf(identity.a) + fabsf(identity.b) + fabsf(identity.c));
+		Quaternion product = q * r, member = q.multiply(r), free = multiply(q, r);
+		for (int k = 0; k < 4; k++) errors[2] = std::max<float>(errors[2], std::max<float>(fabsf(member.q[k] - product.q[k]), fabsf(free.q[k] - product.q[k])));
+		Quaternion negated = -q, normalized = s.normalize();
+		for (int k = 0; k < 4; k++) errors[3] = std::max<float>(errors[3], std::max<float>(fabsf(negated.q[k] + q.q[k]), fabsf(normalized.q[k] - q.q[k])));
+
+		Vec3 axis = randomVec3(1.f).normalize();
+		Vec3 perpendicular = Cross(axis, randomVec3(1.f)).normalize();
+		float angle = randomFloat(-3.f, 3.f);
+		Matrix rotation = Quaternion().fromAxisAngle(axis, angle).toMatrix();
+		float turned = Dot(rotation.mulVec(perpendicular), perpendicular);
+		errors[4] = std::max<float>(errors[4], std::max<float>((rotation.mulVec(axis) - axis).length(), fabsf(turned - cosf(angle))));
+	}
+	const char* names[5] = { "conjugate", "inverse", "multiply", "negate", "axis-angle" };
+	bool passed = true;
+	for (int k = 0; k < 5; k++) {
+		printf("quaternion %-10s max error %9.3g  %s\n", names[k], errors[k], errors[k] <= 1e-4f ? "ok" : "FAILED");
+		passed &= errors[k] <= 1e-4f;
+	}
+	return passed;
+}
+
+// Packet Check
+// AABBx4/AABBx8 lane masks and entry distances against AABB::rayBox and collisionSphereAabb for the same boxes. The box
+// count leaves the last packet part empty, those lanes (boxes at +infinity) must never be hit. Rays start anywhere,
+// inside boxes too, and are clipped to random tMax
+template<typename Packet>
+static int comparePackets(const std::vector<AABB>& boxes, const std::vector<Ray>& rays, const std::vector<float>& tMaxes, const std::vector<BoundingSphere>& spheres) {
+	std::vector<Packet> packets;
+	packAABBs(&boxes[0], (int)boxes.size(), packets);
+	int count = (int)boxes.size(), mismatches = 0;
+	float entries[Packet::width];
+	for (size_t r = 0; r < rays.size(); r++) {
+		for (int p = 0; p < (int)packets.size(); p++) {
+			decltype(packets[p].minX) tEntry;
+			int mask = packets[p].rayAABB(rays[r], tMaxes[r], tEntry);
+			tEntry.store(entries);
+			int sphereMask = packets[p].sphereAABB(spheres[r]);
+			for (int lane = 0; lane < Packet::width; lane++) {
+				int box = p * Packet::width + lane;
+				bool rayHit = (mask >> lane) & 1, sphereHit = (sphereMask >> lane) & 1;
+				if (box >= count) {
+					mismatches += rayHit || sphereHit;
+					continue;
+				}
+				float t;
+				bool reference = AABB::rayBox(boxes[box].min, boxes[box].max, rays[r], tMaxes[r], t);
+				mismatches += rayHit != reference || (reference && entries[lane] != t);
+				mismatches += sphereHit != collisionSphereAabb(spheres[r], boxes[box]);
+			}
+		}
+	}
+	return mismatches;
+}
+
+static bool checkPackets(int n) {
+	std::vector<AABB> boxes(n + 3);
+	for (AABB& box : boxes) {
+		Vec3 c = randomVec3(50.f), e(randomFloat(0.1f, 5.f), randomFloat(0.1f, 5.f), randomFloat(0.1f, 5.f));
+		box.min = c - e;
+		box.max = c + e;
+	}
+	const int queries = 64;
+	std::vector<Ray> rays(queries);
+	std::vector<float> tMaxes(queries);
+	std::vector<BoundingSphere> spheres(queries);
+	for (int i = 0; i < queries; i++) {
+		Vec3 origin = i % 4 == 0 ? (boxes[i].min + boxes[i].max) * 0.5f : randomVec3(60.f);
+		rays[i] = Ray(origin, randomVec3(1.f).normalize());
+		tMaxes[i] = i % 2 ? FLT_MAX : randomFloat(0.f, 100.f);
+		spheres[i].centre = randomVec3(50.f);
+		spheres[i].radius = randomFloat(0.f, 15.f);
+	}
+	// One sphere that reaches every real box and one ray through the origin, so an empty lane left anywhere finite
+	// would be hit
+	spheres[1].radius = 1e18f;
+	rays[2] = Ray(rays[2].o, -rays[2].o.normalize());
+	int mismatches4 = comparePackets<AABBx4>(boxes, rays, tMaxes, spheres);
+	int mismatches8 = comparePackets<AABBx8>(boxes, rays, tMaxes, spheres);
+	printf("aabbx4 packets     %d lane mismatches over %d boxes x %d rays and spheres  %s\n", mismatches4, n + 3, queries, mismatches4 ? "FAILED" : "ok");
+	printf("aabbx8 packets     %d lane mismatches over %d boxes x %d rays and spheres  %s\n", mismatches8, n + 3, queries, mismatches8 ? "FAILED" : "ok");
+	return mismatches4 == 0 && mismatches8 == 0;
+}
+
+// Cache Check
+// The GJK cache only picks where a query starts, so a warm cache has to give the answer of a cold one. Each trial warms
+// the cache of a shape against a rotated box where they touch, moves the shape (mostly apart, a few frames of motion to
+// far away) and queries again with the warm and an empty cache. Answers within a small distance of touching may differ
+// by rounding
+static bool checkGJKCache(int n) {
+	int mismatches[3] = {};
+	const char* names[3] = { "sphere", "capsule", "box" };
+	for (int i = 0; i < n; i++) {
+		AABB local;
+		local.min = -Vec3(randomFloat(0.2f, 2.f), randomFloat(0.2f, 2.f), randomFloat(0.2f, 2.f));
+		local.max = -local.min;
+		ConvexShape box = ConvexShape::fromOBB(OBB(local, Matrix::fromTRS(randomVec3(1.f), randomQuaternion(), Vec3(1.f, 1.f, 1.f))));
+		int kind = i % 3;
+		auto place = [&](const Vec3& centre, const Vec3& axis) {
+			if (kind == 0) { BoundingSphere sphere; sphere.centre = centre; sphere.radius = 0.5f; return ConvexShape::fromSphere(sphere); }
+			if (kind == 1) { Capsule capsule; capsule.a = centre - axis; capsule.b = centre + axis; capsule.radius = 0.5f; return ConvexShape::fromCapsule(capsule); }
+			AABB half;
+			half.min = -Vec3(0.5f, 0.5f, 0.5f);
+			half.max = Vec3(0.5f, 0.5f, 0.5f);
+			return ConvexShape::fromOBB(OBB(half, Matrix::fromTRS(centre, randomQuaternion(), Vec3(1.f, 1.f, 1.f))));
+		};
+		Vec3 axis = randomVec3(1.f).normalize() * randomFloat(0.f, 1.f);
+		Vec3 near = box.centre() + randomVec3(1.f).normalize() * randomFloat(0.f, 2.5f);
+		ConvexShape before = place(near, axis);
+		ConvexShape after = place(near + randomVec3(1.f).normalize() * randomFloat(0.f, 10.f), axis);
+
+		GJKCache cache;
+		ConvexContact contact, warmContact, coldContact;
+		gjkPenetration(before, box, contact, &cache);
+		GJKCache penetrationCache = cache, overlapCache = cache, distanceCache = cache;
+		bool warmHit = gjkPenetration(after, box, warmContact, &penetrationCache);
+		bool coldHit = gjkPenetration(after, box, coldContact);
+		bool warmOverlap = gjkOverlap(after, box, &overlapCache);
+		bool coldOverlap = gjkOverlap(after, box);
+		Vec3 pointA, pointB;
+		float warmDistance = gjkDistance(after, box, pointA, pointB, &distanceCache);
+		float coldDistance = gjkDistance(after, box, pointA, pointB);
+
+		bool touching = coldDistance <= 1e-3f && (!coldHit || coldContact.depth <= 1e-3f);
+		bool same = fabsf(warmDistance - coldDistance) <= 1e-3f;
+		if (!touching) same &= warmHit == coldHit && warmOverlap == coldOverlap;
+		if (warmHit && coldHit) same &= fabsf(warmContact.depth - coldContact.depth) <= 1e-3f;
+		mismatches[kind] += !same;
+	}
+	bool passed = true;
+	for (int kind = 0; kind < 3; kind++) {
+		printf("gjk cache %-8s %d of %d warm queries differ from cold  %s\n", names[kind], mismatches[kind], (n + 2 - kind) / 3, mismatches[kind] ? "FAILED" : "ok");
+		passed &= mismatches[kind] == 0;
+	}
+	return passed;
+}
+
+// Every shape pair over two frames of a Narrowphase: touching (or close) in the first, moved in the second (mostly
+// apart). The second frame starts from the entry the first left behind and has to find the contact of a fresh collide
+static bool checkNarrowphaseCache(int n) {
+	auto randomShape = [](int type, const Vec3& centre) {
+		Vec3 half(randomFloat(0.2f, 1.5f), randomFloat(0.2f, 1.5f), randomFloat(0.2f, 1.5f));
+		AABB box;
+		box.min = centre - half;
+		box.max = centre + half;
+		switch (type) {
+			case ShapeSphere: { BoundingSphere sphere; sphere.centre = centre; sphere.radius = randomFloat(0.2f, 1.f); return Shape::fromSphere(sphere); }
+			case ShapeCapsule: { Capsule capsule; capsule.a = centre; capsule.b = centre + randomVec3(1.f).normalize() * randomFloat(0.f, 2.f); capsule.radius = randomFloat(0.2f, 1.f); return Shape::fromCapsule(capsule); }
+			case ShapeAABB: return Shape::fromAABB(box);
+			default: {
+				AABB local;
+				local.min = -half;
+				local.max = half;
+				return Shape::fromOBB(OBB(local, Matrix::fromTRS(centre, randomQuaternion(), Vec3(1.f, 1.f, 1.f))));
+			}
+		}
+	};
+	auto moveShape = [](Shape& shape, const Vec3& step) {
+		switch (shape.type) {
+			case ShapeSphere: shape.sphere.centre += step; break;
+			case ShapeCapsule: shape.capsule.a += step; shape.capsule.b += step; break;
+			case ShapeAABB: shape.box.min += step; shape.box.max += step; break;
+			default: shape.obb.centre += step;
+		}
+	};
+
+	std::vector<DynamicAABBTree::Pair> pairs(1);
+	pairs[0].a = 0;
+	pairs[0].b = 1;
+	int mismatches = 0;
+	for (int i = 0; i < n; i++) {
+		Shape shapes[2] = { randomShape(i % 4, Vec3(0.f, 0.f, 0.f)), randomShape((i / 4) % 4, randomVec3(1.f).normalize() * randomFloat(0.f, 2.5f)) };
+		Narrowphase narrowphase;
+		narrowphase.update(shapes, 2, pairs, 1);
+		moveShape(shapes[1], randomVec3(1.f).normalize() * randomFloat(0.f, 10.f));
+		narrowphase.update(shapes, 2, pairs, 1);
+
+		ConvexContact contact;
+		bool touching = Narrowphase::collide(shapes[0], shapes[1], contact);
+		bool same = touching == !narrowphase.contacts.empty();
+		if (same && touching) same = fabsf(narrowphase.contacts[0].depth - contact.depth) <= 1e-3f;
+		if (!same && touching && contact.depth <= 1e-3f) same = true;		// Grazing, either answer is rounding
+		mismatches += !same;
+	}
+	printf("narrowphase cache  %d of %d second frames differ from a fresh collide  %s\n", mismatches, n, mismatches ? "FAILED" : "ok");
+	return mismatches == 0;
+}
+
+// Compression Check
+// A synthetic clip with every track form (constant, identity, quantized and raw tracks, the raw ones from bones with a
+// budget quantization can't meet) sampled at every SIMD level, bone by bone with sampleBone and rotations alone with
+// interpolateRotations, against samplePose at the scalar level
+static bool checkCompression(int n) {
+	const int boneCount = 48, frameCount = 40;
+	Skeleton skeleton;
+	std::vector<float> shells(boneCount, 1.f), maxErrors(boneCount);
+	for (int i = 0; i < boneCount; i++) {
+		Bone bone;
+		bone.parentIndex = i % 8 == 0 ? -1 : i - 1;
+		skeleton.bones.push_back(bone);
+		maxErrors[i] = i % 6 == 3 ? 1e-7f : 0.01f;
+	}
+	AnimationSequence clip;
+	clip.ticksPerSecond = 30.f;
+	clip.resize(frameCount, boneCount);
+	for (int bone = 0; bone < boneCount; bone++) {
+		Quaternion rest = randomQuaternion();
+		Vec3 axis = randomVec3(1.f).normalize(), offset = randomVec3(2.f);
+		for (int f = 0; f < frameCount; f++) {
+			int key = f * boneCount + bone;
+			// Still, turning at a constant rate or noisy
+			int kind = bone % 3;
+			clip.rotations[key] = kind == 0 ? rest : (kind == 1 ? Quaternion().fromAxisAngle(axis, 0.05f * (float)f) : randomQuaternion());
+			clip.positions[key] = bone % 2 == 0 ? offset : offset + randomVec3(0.5f);
+			clip.scales[key] = bone % 5 == 0 ? Vec3(1.f, 1.f, 1.f) + randomVec3(0.2f) : (bone % 5 == 1 ? Vec3(2.f, 2.f, 2.f) : Vec3(1.f, 1.f, 1.f));
+		}
+	}
+	clip.compress(skeleton, shells, maxErrors);
+
+	int samples = std::max<int>(64, n / 16);
+	std::vector<int> frames(samples);
+	std::vector<float> facts(samples);
+	for (int s = 0; s < samples; s++) {
+		frames[s] = s * frameCount / samples;
+		facts[s] = randomFloat(0.f, 1.f);
+	}
+	std::vector<Vec3> positions(boneCount * samples), scales(boneCount * samples), outPositions(boneCount), outScales(boneCount);
+	std::vector<Quaternion> rotations(boneCount * samples), outRotations(boneCount);
+	setSimdLevel(SimdScalar);
+	for (int s = 0; s < samples; s++) clip.samplePose(frames[s], facts[s], &positions[s * boneCount], &rotations[s * boneCount], &scales[s * boneCount]);
+
+	float error = 0.f;
+	auto compare = [&](int s, int bone, const Vec3& position, const Quaternion& rotation, const Vec3& scale) {
+		int i = s * boneCount + bone;
+		for (int k = 0; k < 3; k++) error = std::max<float>(error, std::max<float>(relativeError(position.v[k], positions[i].v[k]), relativeError(scale.v[k], scales[i].v[k])));
+		for (int k = 0; k < 4; k++) error = std::max<float>(error, relativeError(rotation.q[k], rotations[i].q[k]));
+	};
+	forEachSimdLevel([&](const char*) {
+		for (int s = 0; s < samples; s++) {
+			clip.samplePose(frames[s], facts[s], &outPositions[0], &outRotations[0], &outScales[0]);
+			for (int bone = 0; bone < boneCount; bone++) compare(s, bone, outPositions[bone], outRotations[bone], outScales[bone]);
+			clip.interpolateRotations(frames[s], facts[s], &outRotations[0]);
+			for (int bone = 0; bone < boneCount; bone++) compare(s, bone, outPositions[bone], outRotations[bone], outScales[bone]);
+		}
+	});
+	for (int s = 0; s < samples; s++) {
+		for (int bone = 0; bone < boneCount; bone++) {
+			Vec3 position, scale;
+			Quaternion rotation;
+			clip.compressed.sampleBone(bone, frames[s], clip.nextFrame(frames[s]), facts[s], position, rotation, scale);
+			compare(s, bone, position, rotation, scale);
+		}
+	}
+	const CompressedClip& compressed = clip.compressed;
+	bool allForms = !compressed.rotations.constantBones.empty() && !compressed.rotations.quantizedBones.empty() && !compressed.rotations.rawBones.empty() &&
+		!compressed.positions.quantizedBones.empty() && !compressed.scales.identityBones.empty();
+	bool released = !clip.framePositions(0) && !clip.frameRotations(0) && !clip.frameScales(0);
+	bool passed = error <= 1e-4f && allForms && released;
+	printf("compression max error %9.3g over %d poses%s%s  %s\n", error, samples, allForms ? "" : ", a track form is missing",
+		released ? "" : ", float keys still readable", passed ? "ok" : "FAILED");
+	return passed;
+}
+
+// Benchmarks
+static void benchmarkMatrix(int n) {
+	std::vector<Matrix> a(n), b(n), out(n);
+	std::vector<Affine> affA(n), affB(n), affOut(n);
+	std::vector<Vec3> points(n), pointsOut(n);
+	for (int i = 0; i < n; i++) {
+		a[i] = randomMatrix(); b[i] = randomMatrix();
+		affA[i] = Affine(a[i]); affB[i] = Affine(b[i]);
+		points[i] = randomVec3(100.f);
+	}
+
+	run("matrix.mul", "inline", n, [&] { for (int i = 0; i < n; i++) out[i] = a[i].mul(b[i]); keep(out[n - 1].m[5]); });
+	run("matrix.mul", "affine-3x4", n, [&] { for (int i = 0; i < n; i++) affOut[i] = affA[i].mul(affB[i]); keep(affOut[n - 1].m[5]); });
+
+	forEachSimdLevel([&](const char* level) {
+		run("matrix.invert", level, n, [&] { for (int i = 0; i < n; i++) out[i] = a[i].invert(); keep(out[n - 1].m[5]); });
+	});
+	run("matrix.invert", "affine-inverse", n, [&] { for (int i = 0; i < n; i++) affOut[i] = affA[i].inverse(); keep(affOut[n - 1].m[5]); });
+	run("matrix.invert", "affine-inverseTRS", n, [&] { for (int i = 0; i < n; i++) affOut[i] = affA[i].inverseTRS(); keep(affOut[n - 1].m[5]); });
+
+	run("matrix.mulPoint", "inline", n, [&] { for (int i = 0; i < n; i++) pointsOut[i] = a[i].mulPoint(points[i]); keep(pointsOut[n - 1].x); });
+	forEachSimdLevel([&](const char* level) {
+		run("matrix.transformPoints", level, n, [&] { transformPoints(a[0], &points[0], &pointsOut[0], n); keep(pointsOut[n - 1].x); });
+	});
+}
+
+static void benchmarkTRS(int n) {
+	std::vector<Vec3> t(n), s(n);
+	std::vector<Quaternion> r(n);
+	std::vector<Matrix> out(n);
+	for (int i = 0; i < n; i++) {
+		t[i] = randomVec3(100.f); r[i] = randomQuaternion(); s[i] = Vec3(randomFloat(0.5f, 2.f), randomFloat(0.5f, 2.f), randomFloat(0.5f, 2.f));
+	}
+
+	run("matrix.trs", "products", n, [&] {
+		for (int i = 0; i < n; i++) out[i] = Matrix::scale(s[i]) * r[i].toMatrix() * Matrix::translate(t[i]);
+		keep(out[n - 1].m[5]);
+	});
+	run("matrix.trs", "fromTRS", n, [&] { for (int i = 0; i < n; i++) out[i] = Matrix::fromTRS(t[i], r[i], s[i]); keep(out[n - 1].m[5]); });
+
+	Vec3 dt, ds;
+	Quaternion dr;
+	float checksum = 0.f;
+	run("matrix.decompose", "affine", n, [&] {
+		for (int i = 0; i < n; i++) { out[i].decompose(dt, dr, ds); checksum += dr.d; }
+		keep(checksum);
+	});
+}
+
+static void benchmarkQuaternion(int n) {
+	std::vector<Quaternion> from(n), to(n), out(n);
+	std::vector<float> t(n);
+	for (int i = 0; i < n; i++) { from[i] = randomQuaternion(); to[i] = randomQuaternion(); t[i] = randomFloat(0.f, 1.f); }
+
+	run("quaternion.slerp", "precise", n, [&] { for (int i = 0; i < n; i++) out[i] = Quaternion::slerp(from[i], to[i], t[i]); keep(out[n - 1].d); });
+	run("quaternion.slerp", "fast", n, [&] { for (int i = 0; i < n; i++) out[i] = Quaternion::slerp<FastMath>(from[i], to[i], t[i]); keep(out[n - 1].d); });
+
+	forEachSimdLevel([&](const char* level) {
+		run("quaternion.batchSlerp", level, n, [&] { interpolateQuaternions(&from[0], &to[0], &out[0], n, 0.37f, QuaternionSlerp); keep(out[n - 1].d); });
+	});
+	forEachSimdLevel([&](const char* level) {
+		run("quaternion.batchNlerp", level, n, [&] { interpolateQuaternions(&from[0], &to[0], &out[0], n, 0.37f, QuaternionNlerp); keep(out[n - 1].d); });
+	});
+}
+
+static void benchmarkVector(int n) {
+	std::vector<Vec3> in(n), other(n), out(n);
+	for (int i = 0; i < n; i++) { in[i] = randomVec3(10.f); other[i] = randomVec3(10.f); }
+	int packets = n / 8;
+
+	run("vec3.normalize", "scalar", n, [&] { for (int i = 0; i < n; i++) out[i] = in[i].normalize(); keep(out[n - 1].x); });
+	run("vec3.normalize", "vec3x8", packets * 8, [&] {
+		for (int i = 0; i < packets; i++) Vec3x8::load(&in[i * 8]).normalize().store(&out[i * 8]);
+		keep(out[n - 1].x);
+	});
+
+	float checksum = 0.f;
+	run("vec3.dot", "scalar", n, [&] { for (int i = 0; i < n; i++) checksum += Dot(in[i], other[i]); keep(checksum); });
+	run("vec3.dot", "vec3x8", packets * 8, [&] {
+		Floatx8 sum(0.f);
+		for (int i = 0; i < packets; i++) sum = sum + Dot(Vec3x8::load(&in[i * 8]), Vec3x8::load(&other[i * 8]));
+		keep(sum);
+	});
+
+	// The same lerp written with operators (fused when built with MYMATH_EXPRESSION_TEMPLATES) and by hand
+#if defined(MYMATH_EXPRESSION_TEMPLATES)
+	const char* operators = "operators-expr";
+#else
+	const char* operators = "operators";
+#endif
+	const float t = 0.37f;
+	run("vec3.lerp", operators, n, [&] { for (int i = 0; i < n; i++) out[i] = (in[i] * (1.f - t)) + (other[i] * t); keep(out[n - 1].x); });
+	run("vec3.lerp", "hand-fused", n, [&] {
+		for (int i = 0; i < n; i++) {
+			out[i].x = in[i].x * (1.f - t) + other[i].x * t;
+			out[i].y = in[i].y * (1.f - t) + other[i].y * t;
+			out[i].z = in[i].z * (1.f - t) + other[i].z * t;
+		}
+		keep(out[n - 1].x);
+	});
+
+	std::vector<Frame> frames(n);
+	run("frame.fromVector", "scalar", n, [&] { for (int i = 0; i < n; i++) frames[i].fromVector(in[i]); keep(frames[n - 1].u.x); });
+}
+
+static void benchmarkTrigonometry(int n) {
+	std::vector<float> x(n), unit(n), out(n), out2(n);
+	for (int i = 0; i < n; i++) { x[i] = randomFloat(-10.f, 10.f); unit[i] = randomFloat(-1.f, 1.f); }
+
+	run("trig.sincos", "precise", n, [&] { for (int i = 0; i < n; i++) PreciseMath::sincos(x[i], out[i], out2[i]); keep(out[n - 1]); });
+	run("trig.sincos", "fast", n, [&] { for (int i = 0; i < n; i++) FastMath::sincos(x[i], out[i], out2[i]); keep(out[n - 1]); });
+	run("trig.acos", "precise", n, [&] { for (int i = 0; i < n; i++) out[i] = PreciseMath::acos(unit[i]); keep(out[n - 1]); });
+	run("trig.acos", "fast", n, [&] { for (int i = 0; i < n; i++) out[i] = FastMath::acos(unit[i]); keep(out[n - 1]); });
+	run("trig.atan2", "precise", n, [&] { for (int i = 0; i < n; i++) out[i] = PreciseMath::atan2(unit[i], x[i]); keep(out[n - 1]); });
+	run("trig.atan2", "fast", n, [&] { for (int i = 0; i < n; i++) out[i] = FastMath::atan2(unit[i], x[i]); keep(out[n - 1]); });
+	run("matrix.rotateAxis", "precise", n, [&] {
+		Vec3 axis(0.3f, 0.9f, 0.1f);
+		Matrix m;
+		for (int i = 0; i < n; i++) { m = Matrix::rotateAxis(axis, x[i]); keep(m.m[0]); }
+	});
+	run("matrix.rotateAxis", "fast", n, [&] {
+		Vec3 axis(0.3f, 0.9f, 0.1f);
+		Matrix m;
+		for (int i = 0; i < n; i++) { m = Matrix::rotateAxis<FastMath>(axis, x[i]); keep(m.m[0]); }
+	});
+}
+
+static void benchmarkCollision(int n) {
+	std::vector<Matrix> worlds(n);
+	std::vector<AABB> boxes(n), out(n);
+	for (int i = 0; i < n; i++) {
+		worlds[i] = randomMatrix();
+		Vec3 c = randomVec3(50.f), e(randomFloat(0.1f, 5.f), randomFloat(0.1f, 5.f), randomFloat(0.1f, 5.f));
+		boxes[i].min = c - e; boxes[i].max = c + e;
+	}
+
+	run("aabb.transform", "8-corners", n, [&] {
+		for (int i = 0; i < n; i++) {
+			AABB box;
+			for (int c = 0; c < 8; c++)
+				box.extend(worlds[i].mulPoint(Vec3((c & 1) ? boxes[i].max.x : boxes[i].min.x, (c & 2) ? boxes[i].max.y : boxes[i].min.y, (c & 4) ? boxes[i].max.z : boxes[i].min.z)));
+			out[i] = box;
+		}
+		keep(out[n - 1].max.x);
+	});
+	run("aabb.transform", "arvo", n, [&] { for (int i = 0; i < n; i++) out[i] = boxes[i].transform(worlds[i]); keep(out[n - 1].max.x); });
+	run("aabb.transform", "batched", n, [&] { transformAABBs(&boxes[0], &worlds[0], &out[0], n); keep(out[n - 1].max.x); });
+
+	// One ray / sphere against every box, ns per box
+	std::vector<AABBx4> packets4;
+	std::vector<AABBx8> packets8;
+	packAABBs(&boxes[0], n, packets4);
+	packAABBs(&boxes[0], n, packets8);
+	Ray ray(randomVec3(60.f), randomVec3(1.f).normalize());
+	BoundingSphere sphere;
+	sphere.centre = randomVec3(20.f);
+	sphere.radius = 15.f;
+
+	run("aabb.ray", "scalar", n, [&] {
+		int hits = 0;
+		float t;
+		for (int i = 0; i < n; i++) hits += boxes[i].rayAABB(ray, t);
+		keep(hits);
+	});
+	run("aabb.ray", "aabbx4", n, [&] {
+		int hits = 0;
+		Floatx4 t;
+		for (const AABBx4& packet : packets4) hits += bitCount(packet.rayAABB(ray, FLT_MAX, t));
+		keep(hits);
+	});
+	run("aabb.ray", "aabbx8", n, [&] {
+		int hits = 0;
+		Floatx8 t;
+		for (const AABBx8& packet : packets8) hits += bitCount(packet.rayAABB(ray, FLT_MAX, t));
+		keep(hits);
+	});
+
+	run("aabb.sphere", "scalar", n, [&] {
+		int hits = 0;
+		for (int i = 0; i < n; i++) hits += collisionSphereAabb(sphere, boxes[i]);
+		keep(hits);
+	});
+	run("aabb.sphere", "aabbx4", n, [&] {
+		int hits = 0;
+		for (const AABBx4& packet : packets4) hits += bitCount(packet.sphereAABB(sphere));
+		keep(hits);
+	});
+	run("aabb.sphere", "aabbx8", n, [&] {
+		int hits = 0;
+		for (const AABBx8& packet : packets8) hits += bitCount(packet.sphereAABB(sphere));
+		keep(hits);
+	});
+
+	// Rotated boxes against their neighbour, OBB SAT against the AABBs of the transformed boxes (out, from above)
+	std::vector<OBB> obbs(n);
+	run("obb.initialize", "scalar", n, [&] { for (int i = 0; i < n; i++) obbs[i].initialize(boxes[i], worlds[i]); keep(obbs[n - 1].radius); });
+	run("obb.pair", "aabb", n, [&] {
+		int hits = 0;
+		for (int i = 0; i < n; i++) hits += collisionAabbAabb(out[i], out[(i + 1) % n]);
+		keep(hits);
+	});
+	run("obb.pair", "sat", n, [&] {
+		int hits = 0;
+		for (int i = 0; i < n; i++) hits += collisionObbObb(obbs[i], obbs[(i + 1) % n]);
+		keep(hits);
+	});
+	run("obb.sphere", "scalar", n, [&] {
+		int hits = 0;
+		for (int i = 0; i < n; i++) hits += collisionSphereObb(sphere, obbs[i]);
+		keep(hits);
+	});
+	run("obb.ray", "scalar", n, [&] {
+		int hits = 0;
+		float t;
+		for (int i = 0; i < n; i++) hits += obbs[i].rayOBB(ray, t);
+		keep(hits);
+	});
+}
+
+// BVH queries against testing every box, on a flat scattered world like the instanced trees (boxes spread
+// over a square that grows with the count, so density stays the same)
+static void benchmarkBVH() {
+	const int sizes[] = { 256, 10000, 100000 };
+	for (int n : sizes) {
+		float range = sqrtf((float)n) * 10.f;
+		std::vector<AABB> boxes(n);
+		for (int i = 0; i < n; i++) {
+			Vec3 c(randomFloat(-range, range), randomFloat(0.f, 20.f), randomFloat(-range, range));
+			Vec3 e(randomFloat(0.5f, 3.f), randomFloat(1.f, 10.f), randomFloat(0.5f, 3.f));
+			boxes[i].min = c - e; boxes[i].max = c + e;
+		}
+
+		const int queries = 1024;
+		std::vector<Ray> rays(queries);
+		std::vector<AABB> regions(queries);
+		std::vector<BoundingSphere> spheres(queries);
+		for (int q = 0; q < queries; q++) {
+			Vec3 o(randomFloat(-range, range), randomFloat(0.f, 20.f), randomFloat(-range, range));
+			rays[q].initialize(o, Vec3(randomFloat(-1.f, 1.f), randomFloat(-0.1f, 0.1f), randomFloat(-1.f, 1.f)).normalize());
+			regions[q].min = o - Vec3(15.f, 15.f, 15.f); regions[q].max = o + Vec3(15.f, 15.f, 15.f);
+			spheres[q].centre = o; spheres[q].radius = 15.f;
+		}
+
+		// Brute force runs fewer queries on the large sets so a sample stays short
+		int bruteQueries = std::max<int>(16, std::min<int>(queries, 2560000 / n));
+		std::string size = std::to_string(n);
+		BVH bvh;
+		run(("bvh.build/" + size).c_str(), "binned-sah", n, [&] { bvh.build(boxes); keep(bvh.nodes[0].max.x); });
+
+		run(("bvh.closestHit/" + size).c_str(), "brute-force", bruteQueries, [&] {
+			int hits = 0;
+			for (int q = 0; q < bruteQueries; q++) {
+				float best = FLT_MAX, t;
+				int index = -1;
+				for (int i = 0; i < n; i++)
+					if (boxes[i].rayAABB(rays[q], t, best) && (index < 0 || t < best)) { best = t; index = i; }
+				hits += index;
+			}
+			keep(hits);
+		});
+		run(("bvh.closestHit/" + size).c_str(), "bvh", queries, [&] {
+			int hits = 0;
+			for (int q = 0; q < queries; q++) {
+				int index;
+				float t;
+				if (bvh.closestHit(rays[q], index, t)) hits += index;
+			}
+			keep(hits);
+		});
+
+		run(("bvh.anyHit/" + size).c_str(), "brute-force", bruteQueries, [&] {
+			int hits = 0;
+			for (int q = 0; q < bruteQueries; q++) {
+				float t;
+				for (int i = 0; i < n; i++)
+					if (boxes[i].rayAABB(rays[q], t, 50.f)) { hits++; break; }
+			}
+			keep(hits);
+		});
+		run(("bvh.anyHit/" + size).c_str(), "bvh", queries, [&] {
+			int hits = 0;
+			for (int q = 0; q < queries; q++) hits += bvh.anyHit(rays[q], 50.f);
+			keep(hits);
+		});
+
+		std::vector<int> found;
+		run(("bvh.queryAABB/" + size).c_str(), "brute-force", bruteQueries, [&] {
+			found.clear();
+			for (int q = 0; q < bruteQueries; q++)
+				for (int i = 0; i < n; i++)
+					if (collisionAabbAabb(boxes[i], regions[q])) found.push_back(i);
+			keep(found.size());
+		});
+		run(("bvh.queryAABB/" + size).c_str(), "bvh", queries, [&] {
+			found.clear();
+			for (int q = 0; q < queries; q++) bvh.queryAABB(regions[q], found);
+			keep(found.size());
+		});
+
+		run(("bvh.querySphere/" + size).c_str(), "brute-force", bruteQueries, [&] {
+			found.clear();
+			for (int q = 0; q < bruteQueries; q++)
+				for (int i = 0; i < n; i++)
+					if (boxes[i].distanceSquare(spheres[q].centre) <= spheres[q].radius * spheres[q].radius) found.push_back(i);
+			keep(found.size());
+		});
+		run(("bvh.querySphere/" + size).c_str(), "bvh", queries, [&] {
+			found.clear();
+			for (int q = 0; q < queries; q++) bvh.querySphere(spheres[q], found);
+			keep(found.size());
+		});
+	}
+}
+
+// A broadphase frame (move every collider a little, then find all overlapping pairs) at constant density, so
+// ns per object stays flat when the hash scales linearly. Brute force tests every pair
+static void benchmarkSpatialHash() {
+	const int sizes[] = { 1000, 10000, 50000 };
+	for (int n : sizes) {
+		float range = sqrtf((float)n) * 4.f;
+		std::vector<BoundingSphere> spheres(n);
+		std::vector<Vec3> velocities(n);
+		SpatialHash hash(4.f, n);
+		std::vector<int> ids(n);
+		for (int i = 0; i < n; i++) {
+			spheres[i].centre = Vec3(randomFloat(-range, range), randomFloat(0.f, 4.f), randomFloat(-range, range));
+			spheres[i].radius = randomFloat(0.5f, 1.5f);
+			velocities[i] = Vec3(randomFloat(-0.1f, 0.1f), 0.f, randomFloat(-0.1f, 0.1f));
+			ids[i] = hash.insert(spheres[i]);
+		}
+
+		std::string size = std::to_string(n);
+		std::vector<SpatialHash::Pair> pairs;
+		int frame = 0;
+		run(("spatialHash.frame/" + size).c_str(), "hash", n, [&] {
+			float direction = (frame++ & 32) ? -1.f : 1.f;
+			for (int i = 0; i < n; i++) {
+				spheres[i].centre = spheres[i].centre + velocities[i] * direction;
+				hash.move(ids[i], spheres[i]);
+			}
+			hash.computePairs(pairs);
+			keep(pairs.size());
+		});
+
+		std::vector<int> found;
+		run(("spatialHash.queryRadius/" + size).c_str(), "hash", n, [&] {
+			found.clear();
+			for (int i = 0; i < n; i++) hash.queryRadius(spheres[i].centre, 3.f, found);
+			keep(found.size());
+		});
+
+		if (n > 10000) continue;
+		run(("spatialHash.frame/" + size).c_str(), "brute-force", n, [&] {
+			pairs.clear();
+			for (int i = 0; i < n; i++)
+				for (int j = i + 1; j < n; j++) {
+					float r = spheres[i].radius + spheres[j].radius;
+					if ((spheres[i].centre - spheres[j].centre).lengthSquare() <= r * r) pairs.push_back({ i, j });
+				}
+			keep(pairs.size());
+		});
+	}
+}
+
+// Per frame cost of the dynamic tree with spheres moving at a steady velocity (60 Hz steps), against rebuilding
+// the static BVH every frame
+static void benchmarkDynamicTree() {
+	const int sizes[] = { 1000, 10000 };
+	for (int n : sizes) {
+		float range = sqrtf((float)n) * 4.f;
+		const float dt = 1.f / 60.f;
+		std::vector<BoundingSphere> spheres(n);
+		std::vector<Vec3> velocities(n);
+		std::vector<AABB> boxes(n);
+		DynamicAABBTree tree;
+		std::vector<int> proxies(n);
+		for (int i = 0; i < n; i++) {
+			spheres[i].centre = Vec3(randomFloat(-range, range), randomFloat(0.f, 4.f), randomFloat(-range, range));
+			spheres[i].radius = randomFloat(0.5f, 1.5f);
+			velocities[i] = Vec3(randomFloat(-5.f, 5.f), 0.f, randomFloat(-5.f, 5.f));
+			proxies[i] = tree.insert(spheres[i]);
+		}
+
+		// Steps every sphere, turning round at the edge of the area
+		auto step = [&] {
+			for (int i = 0; i < n; i++) {
+				Vec3& c = spheres[i].centre;
+				if (c.x < -range || c.x > range) velocities[i].x = -velocities[i].x;
+				if (c.z < -range || c.z > range) velocities[i].z = -velocities[i].z;
+				c = c + velocities[i] * dt;
+			}
+		};
+
+		std::string size = std::to_string(n);
+		std::vector<DynamicAABBTree::Pair> pairs;
+		run(("dynamicTree.frame/" + size).c_str(), "move", n, [&] {
+			step();
+			int reinserted = 0;
+			for (int i = 0; i < n; i++) reinserted += tree.move(proxies[i], spheres[i], velocities[i] * dt);
+			keep(reinserted);
+		});
+		run(("dynamicTree.frame/" + size).c_str(), "move+pairs", n, [&] {
+			step();
+			for (int i = 0; i < n; i++) tree.move(proxies[i], spheres[i], velocities[i] * dt);
+			tree.computePairs(pairs);
+			keep(pairs.size());
+		});
+
+		BVH bvh;
+		run(("dynamicTree.frame/" + size).c_str(), "bvh-rebuild", n, [&] {
+			step();
+			for (int i = 0; i < n; i++) {
+				Vec3 r(spheres[i].radius, spheres[i].radius, spheres[i].radius);
+				boxes[i].min = spheres[i].centre - r;
+				boxes[i].max = spheres[i].centre + r;
+			}
+			bvh.build(boxes);
+			keep(bvh.nodes[0].max.x);
+		});
+	}
+}
+
+// Player sized spheres walking through a grid of tree trunk boxes, one slide per player per frame
+static void benchmarkSweep() {
+	const int side = 16, players = 256;
+	const float spacing = 6.f, dt = 1.f / 60.f;
+	std::vector<AABB> trees;
+	for (int i = 0; i < side; i++) {
+		for (int j = 0; j < side; j++) {
+			Vec3 c(i * spacing + randomFloat(-1.f, 1.f), 0.f, j * spacing + randomFloat(-1.f, 1.f));
+			Vec3 e(randomFloat(0.5f, 1.5f), 9.f, randomFloat(0.5f, 1.5f));
+			AABB box;
+			box.min = c - e;
+			box.max = c + e;
+			trees.push_back(box);
+		}
+	}
+	BVH bvh;
+	bvh.build(trees);
+
+	std::vector<BoundingSphere> spheres(players);
+	std::vector<Vec3> motions(players);
+	for (int i = 0; i < players; i++) {
+		spheres[i].centre = Vec3(randomFloat(0.f, side * spacing), 0.f, randomFloat(0.f, side * spacing));
+		spheres[i].radius = 1.f;
+		motions[i] = Vec3(randomFloat(-10.f, 10.f), 0.f, randomFloat(-10.f, 10.f)) * dt;
+	}
+
+	std::string size = std::to_string(trees.size());
+	run(("sweep.sphereAabb/" + size).c_str(), "scalar", players * (int)trees.size(), [&] {
+		int hits = 0;
+		for (int i = 0; i < players; i++) {
+			Vec3 motion = motions[i] * 60.f;
+			for (const AABB& box : trees) {
+				float t;
+				Vec3 normal;
+				hits += sweepSphereAabb(spheres[i], motion, box, t, normal);
+			}
+		}
+		keep(hits);
+	});
+	run(("sweep.slide/" + size).c_str(), "array", players, [&] {
+		for (int i = 0; i < players; i++) keep(slideSphere(spheres[i], motions[i], &trees[0], (int)trees.size()));
+	});
+	run(("sweep.slide/" + size).c_str(), "bvh", players, [&] {
+		for (int i = 0; i < players; i++) keep(slideSphere(spheres[i], motions[i], bvh));
+	});
+}
+
+// Loads a GEM model from options.models, false (and a note) when it is missing, GEMLoader would exit instead
+static bool loadModel(const char* filename, std::vector<GEMLoader::GEMMesh>& meshes) {
+	std::string path = options.models + "/" + filename;
+	if (!std::ifstream(path, std::ios::binary).good()) {
+		fprintf(stderr, "%s not found, skipping its rows (see --models)\n", path.c_str());
+		return false;
+	}
+	GEMLoader::GEMModelLoader loader;
+	loader.load(path, meshes);
+	return true;
+}
+
+// The same for an animated model, copying the skeleton and clips into animation as AnimatedModel::load does
+static bool loadModel(const char* filename, std::vector<GEMLoader::GEMMesh>& meshes, Animation& animation) {
+	std::string path = options.models + "/" + filename;
+	if (!std::ifstream(path, std::ios::binary).good()) {
+		fprintf(stderr, "%s not found, skipping its rows (see --models)\n", path.c_str());
+		return false;
+	}
+	GEMLoader::GEMModelLoader loader;
+	GEMLoader::GEMAnimation gemanimation;
+	loader.load(path, meshes, gemanimation);
+	std::copy(gemanimation.globalInverse.m, gemanimation.globalInverse.m + 16, animation.skeleton.globalInverse.m);
+	for (const GEMLoader::GEMBone& gembone : gemanimation.bones) {
+		Bone bone;
+		bone.name = gembone.name;
+		std::copy(gembone.offset.m, gembone.offset.m + 16, bone.offset.m);
+		bone.parentIndex = gembone.parentIndex;
+		animation.skeleton.bones.push_back(bone);
+	}
+	for (const GEMLoader::GEMAnimationSequence& gemsequence : gemanimation.animations) {
+		AnimationSequence sequence;
+		sequence.ticksPerSecond = gemsequence.ticksPerSecond;
+		sequence.resize((int)gemsequence.frames.size(), gemsequence.frames.empty() ? 0 : (int)gemsequence.frames[0].positions.size());
+		for (int n = 0; n < sequence.frameCount; n++) {
+			const GEMLoader::GEMAnimationFrame& frame = gemsequence.frames[n];
+			for (int bone = 0; bone < sequence.boneCount; bone++) {
+				int key = n * sequence.boneCount + bone;
+				sequence.positions[key] = Vec3(frame.positions[bone].x, frame.positions[bone].y, frame.positions[bone].z);
+				std::copy(frame.rotations[bone].q, frame.rotations[bone].q + 4, sequence.rotations[key].q);
+				sequence.scales[key] = Vec3(frame.scales[bone].x, frame.scales[bone].y, frame.scales[bone].z);
+			}
+		}
+		animation.animations.insert({ gemsequence.name, sequence });
+	}
+	return true;
+}
+
+// Rays against the truck's triangles, from around its bounding sphere towards points inside its bounds (most
+// of them hit), Mops/s is millions of rays per second. Also times fitting bounds to the truck's vertices
+static void benchmarkMeshRaycast() {
+	std::vector<GEMLoader::GEMMesh> meshes;
+	if (!loadModel("Truck_02b.gem", meshes)) return;
+
+	MeshCollider collider;
+	run("mesh.build/truck", "triangle-bvh", 1, [&] { collider.build(meshes); keep(collider.triangles.packets.size()); });
+
+	std::vector<Vec3> positions;
+	std::vector<unsigned int> indices;
+	for (const GEMLoader::GEMMesh& mesh : meshes) {
+		unsigned int base = (unsigned int)positions.size();
+		for (const GEMLoader::GEMStaticVertex& vertex : mesh.verticesStatic) positions.push_back(Vec3(vertex.position.x, vertex.position.y, vertex.position.z));
+		for (unsigned int index : mesh.indices) indices.push_back(base + index);
+	}
+
+	const int rayCount = 1024;
+	AABB bounds = computeAABB(&positions[0], (int)positions.size());
+	Vec3 centre = bounds.centre(), extent = (bounds.max - bounds.min) * 0.5f;
+	std::vector<Ray> rays(rayCount);
+	for (int i = 0; i < rayCount; i++) {
+		Vec3 o = centre + randomVec3(1.f).normalize() * extent.length() * 1.5f;
+		Vec3 target = centre + Vec3(randomFloat(-1.f, 1.f) * extent.x, randomFloat(-1.f, 1.f) * extent.y, randomFloat(-1.f, 1.f) * extent.z);
+		rays[i] = Ray(o, (target - o).normalize());
+	}
+
+	// Load time bounds of the truck's vertices, ns per vertex
+	std::string vertices = std::to_string(positions.size());
+	int vertexCount = (int)positions.size();
+	run(("bounds.aabb/" + vertices).c_str(), "extend", vertexCount, [&] {
+		AABB box;
+		for (const Vec3& p : positions) box.extend(p);
+		keep(box.max.x);
+	});
+	run(("bounds.aabb/" + vertices).c_str(), "computeAABB", vertexCount, [&] { keep(computeAABB(&positions[0], vertexCount).max.x); });
+	run(("bounds.sphere/" + vertices).c_str(), "ritter", vertexCount, [&] { keep(ritterSphere(&positions[0], vertexCount).radius); });
+	run(("bounds.sphere/" + vertices).c_str(), "welzl", vertexCount, [&] { keep(welzlSphere(&positions[0], vertexCount).radius); });
+
+	std::string size = std::to_string(indices.size() / 3);
+	run(("mesh.ray/" + size).c_str(), "bvh", rayCount, [&] {
+		int hits = 0;
+		TriangleHit hit;
+		for (const Ray& ray : rays) hits += collider.raycast(ray, hit);
+		keep(hits);
+	});
+	run(("mesh.ray/" + size).c_str(), "bvh-any", rayCount, [&] {
+		int hits = 0;
+		for (const Ray& ray : rays) hits += collider.triangles.anyHit(ray);
+		keep(hits);
+	});
+	run(("mesh.ray/" + size).c_str(), "brute-force", 64, [&] {
+		int hits = 0;
+		for (int r = 0; r < 64; r++) {
+			const Ray& ray = rays[r];
+			float best = FLT_MAX;
+			for (size_t i = 0; i < indices.size(); i += 3) {
+				Vec3 a = positions[indices[i]], e1 = positions[indices[i + 1]] - a, e2 = positions[indices[i + 2]] - a;
+				Vec3 p = Cross(ray.dir, e2);
+				float det = Dot(e1, p);
+				if (det == 0.f) continue;
+				Vec3 s = ray.o - a;
+				float u = Dot(s, p) / det;
+				if (u < 0.f || u > 1.f) continue;
+				Vec3 q = Cross(s, e1);
+				float v = Dot(ray.dir, q) / det, t = Dot(e2, q) / det;
+				if (v >= 0.f && u + v <= 1.f && t >= 0.f && t < best) best = t;
+			}
+			hits += best < FLT_MAX;
+		}
+		keep(hits);
+	});
+}
+
+// Hitbox rigs of a crowd of TRex NPCs spread over a field, each in its own pose. rig.update is ns per NPC (pose
+// every capsule and refit the broad sphere), rig.ray is ns per bullet tested against the whole crowd, with the broad
+// sphere rejection and without it
+static void benchmarkHitboxRig() {
+	std::vector<GEMLoader::GEMMesh> meshes;
+	Animation animation;
+	if (!loadModel("TRex.gem", meshes, animation)) return;
+
+	HitboxRig rig;
+	rig.build(animation.skeleton, meshes);
+
+	const int npcCount = 64, side = 8;
+	const float spacing = 10.f;
+	std::vector<AnimationInstance> instances(npcCount);
+	std::vector<Matrix> worlds(npcCount);
+	std::vector<HitboxRig> rigs(npcCount, rig);
+	for (int i = 0; i < npcCount; i++) {
+		instances[i].initialize(&animation, 0);
+		instances[i].update("run", 0.f);
+		instances[i].update("run", randomFloat(0.f, 1.f));
+		worlds[i] = Matrix::scale(Vec3(0.01f, 0.01f, 0.01f)) * Matrix::rotateOnYAxis(randomFloat(0.f, 6.28f)) * Matrix::translate(Vec3((i % side) * spacing, 0.f, (i / side) * spacing));
+		rigs[i].update(instances[i].matrices, worlds[i]);
+	}
+
+	const int rayCount = 256;
+	std::vector<Ray> rays(rayCount);
+	for (int i = 0; i < rayCount; i++) {
+		Vec3 o(randomFloat(0.f, side * spacing), randomFloat(1.f, 4.f), -10.f);
+		Vec3 target(randomFloat(0.f, side * spacing), randomFloat(0.f, 4.f), randomFloat(0.f, side * spacing));
+		rays[i] = Ray(o, (target - o).normalize());
+	}
+
+	std::string capsules = std::to_string(rig.capsules.size());
+	run(("rig.update/" + capsules).c_str(), "single-pass", npcCount, [&] {
+		for (int i = 0; i < npcCount; i++) rigs[i].update(instances[i].matrices, worlds[i]);
+		keep(rigs[npcCount - 1].broad.radius);
+	});
+	run(("rig.ray/" + std::to_string(npcCount) + "npc").c_str(), "broad-sphere", rayCount, [&] {
+		int hits = 0;
+		RigHit hit;
+		for (const Ray& ray : rays)
+			for (const HitboxRig& r : rigs) hits += r.raycast(ray, hit);
+		keep(hits);
+	});
+	run(("rig.ray/" + std::to_string(npcCount) + "npc").c_str(), "every-capsule", rayCount, [&] {
+		int hits = 0;
+		for (const Ray& ray : rays) {
+			for (const HitboxRig& r : rigs) {
+				float t, best = FLT_MAX;
+				bool hit = false;
+				for (const Capsule& capsule : r.capsules)
+					if (capsule.rayCapsule(ray, t, best)) { best = t; hit = true; }
+				hits += hit;
+			}
+		}
+		keep(hits);
+	});
+}
+
+// Convex hulls of the truck and the food warmer (64 vertex budget), ns per pair query. Pairs are placed around the truck so about half
+// of them overlap. "cold" starts every query from scratch, "cached" keeps a GJKCache per pair across samples as a
+// pair that rests from one frame to the next would
+static void benchmarkConvex() {
+	std::vector<GEMLoader::GEMMesh> truckMeshes, warmerMeshes;
+	if (!loadModel("Truck_02b.gem", truckMeshes) || !loadModel("Food_Warmer_07a.gem", warmerMeshes)) return;
+
+	ConvexHull truck, warmer, rebuilt;
+	truck.build(truckMeshes);
+	warmer.build(warmerMeshes);
+	run("hull.build/truck", "quickhull-64", 1, [&] { rebuilt.build(truckMeshes); keep(rebuilt.vertices.size()); });
+	run("hull.build/truck", "quickhull-full", 1, [&] { rebuilt.build(truckMeshes, 1 << 30); keep(rebuilt.vertices.size()); });
+
+	const int pairCount = 256;
+	std::vector<ConvexShape> trucks(pairCount), warmers(pairCount), spheres(pairCount), capsules(pairCount);
+	for (int i = 0; i < pairCount; i++) {
+		Matrix truckWorld = Matrix::fromTRS(randomVec3(1.f), randomQuaternion(), Vec3(1.f, 1.f, 1.f));
+		Vec3 offset = randomVec3(1.f).normalize() * randomFloat(0.5f, 1.4f) * (truck.sphere.radius + warmer.sphere.radius);
+		trucks[i] = ConvexShape::fromHull(truck, truckWorld);
+		warmers[i] = ConvexShape::fromHull(warmer, Matrix::fromTRS(offset, randomQuaternion(), Vec3(1.f, 1.f, 1.f)));
+		BoundingSphere sphere;
+		sphere.centre = offset;
+		sphere.radius = 0.5f;
+		spheres[i] = ConvexShape::fromSphere(sphere);
+		Capsule capsule;
+		capsule.a = offset;
+		capsule.b = offset + randomVec3(1.f).normalize() * 2.f;
+		capsule.radius = 0.5f;
+		capsules[i] = ConvexShape::fromCapsule(capsule);
+	}
+
+	std::vector<GJKCache> caches(pairCount);
+	auto pairRows = [&](const char* name, const std::vector<ConvexShape>& others) {
+		run((std::string("gjk.overlap/") + name).c_str(), "cold", pairCount, [&] {
+			int hits = 0;
+			for (int i = 0; i < pairCount; i++) hits += gjkOverlap(trucks[i], others[i]);
+			keep(hits);
+		});
+		for (GJKCache& cache : caches) cache = GJKCache();
+		run((std::string("gjk.overlap/") + name).c_str(), "cached", pairCount, [&] {
+			int hits = 0;
+			for (int i = 0; i < pairCount; i++) hits += gjkOverlap(trucks[i], others[i], &caches[i]);
+			keep(hits);
+		});
+		run((std::string("gjk.distance/") + name).c_str(), "cached", pairCount, [&] {
+			float total = 0.f;
+			Vec3 pointA, pointB;
+			for (int i = 0; i < pairCount; i++) total += gjkDistance(trucks[i], others[i], pointA, pointB, &caches[i]);
+			keep(total);
+		});
+		run((std::string("gjk.penetration/") + name).c_str(), "cached", pairCount, [&] {
+			float total = 0.f;
+			ConvexContact contact;
+			for (int i = 0; i < pairCount; i++)
+				if (gjkPenetration(trucks[i], others[i], contact, &caches[i])) total += contact.depth;
+			keep(total);
+		});
+	};
+	pairRows("hull-hull", warmers);
+	pairRows("hull-sphere", spheres);
+	pairRows("hull-capsule", capsules);
+}
+
+// A crowd of spheres, capsules, boxes and rotated boxes packed tight enough that about a third of the broadphase pairs
+// touch, ns per pair. "cold" starts from an empty cache every frame, "resting" runs the same frame again (every contact
+// reused), "moving" moves a quarter of the shapes between frames so their pairs are recomputed from the cached SAT
+// axis or GJK direction. The thread count variants split the pairs into chunks, they only pay off with more than one
+// core
+static void benchmarkNarrowphase() {
+	const int n = 2000;
+	float range = sqrtf((float)n) * 1.2f;
+	std::vector<Shape> shapes(n), moved;
+	std::vector<AABB> bounds(n);
+	for (int i = 0; i < n; i++) {
+		Vec3 c(randomFloat(-range, range), randomFloat(0.f, 2.f), randomFloat(-range, range));
+		Vec3 half(randomFloat(0.2f, 0.8f), randomFloat(0.2f, 0.8f), randomFloat(0.2f, 0.8f));
+		AABB box;
+		box.min = c - half;
+		box.max = c + half;
+		switch (i % 4) {
+			case 0: { BoundingSphere sphere; sphere.centre = c; sphere.radius = randomFloat(0.3f, 0.8f); shapes[i] = Shape::fromSphere(sphere); break; }
+			case 1: { Capsule capsule; capsule.a = c; capsule.b = c + randomVec3(1.f).normalize(); capsule.radius = randomFloat(0.2f, 0.5f); shapes[i] = Shape::fromCapsule(capsule); break; }
+			case 2: shapes[i] = Shape::fromAABB(box); break;
+			default: {
+				AABB local;
+				local.min = -half;
+				local.max = half;
+				shapes[i] = Shape::fromOBB(OBB(local, Matrix::fromTRS(c, randomQuaternion(), Vec3(1.f, 1.f, 1.f))));
+			}
+		}
+		const Shape& shape = shapes[i];
+		if (shape.type == ShapeSphere) {
+			Vec3 reach(shape.sphere.radius, shape.sphere.radius, shape.sphere.radius);
+			bounds[i].min = shape.sphere.centre - reach;
+			bounds[i].max = shape.sphere.centre + reach;
+		}
+		else if (shape.type == ShapeCapsule) {
+			Vec3 reach(shape.capsule.radius, shape.capsule.radius, shape.capsule.radius);
+			bounds[i].min = Min(shape.capsule.a, shape.capsule.b) - reach;
+			bounds[i].max = Max(shape.capsule.a, shape.capsule.b) + reach;
+		}
+		else if (shape.type == ShapeAABB) bounds[i] = shape.box;
+		else {
+			Vec3 reach(0.f, 0.f, 0.f);
+			for (int axis = 0; axis < 3; axis++) reach += Vec3(fabsf(shape.obb.axis[axis].x), fabsf(shape.obb.axis[axis].y), fabsf(shape.obb.axis[axis].z)) * shape.obb.extent.v[axis];
+			bounds[i].min = shape.obb.centre - reach;
+			bounds[i].max = shape.obb.centre + reach;
+		}
+	}
+	moved = shapes;
+	for (int i = 0; i < n; i += 4) {
+		Vec3 step = randomVec3(0.02f);
+		Shape& shape = moved[i + (i / 4) % 4];
+		switch (shape.type) {
+			case ShapeSphere: shape.sphere.centre += step; break;
+			case ShapeCapsule: shape.capsule.a += step; shape.capsule.b += step; break;
+			case ShapeAABB: shape.box.min += step; shape.box.max += step; break;
+			default: shape.obb.centre += step;
+		}
+	}
+
+	DynamicAABBTree tree;
+	for (int i = 0; i < n; i++) tree.insert(bounds[i]);
+	std::vector<DynamicAABBTree::Pair> pairs;
+	tree.computePairs(pairs);
+	int pairCount = std::max<int>(1, (int)pairs.size());
+
+	run("narrowphase/2000", "cold", pairCount, [&] {
+		Narrowphase narrowphase;
+		narrowphase.update(&shapes[0], n, pairs, 1);
+		keep(narrowphase.contacts.size());
+	});
+	Narrowphase warm;
+	run("narrowphase/2000", "resting", pairCount, [&] {
+		warm.update(&shapes[0], n, pairs, 1);
+		keep(warm.contacts.size());
+	});
+	const int threadCounts[] = { 1, 4 };
+	for (int threads : threadCounts) {
+		std::string variant = "moving/" + std::to_string(threads) + "-thread";
+		bool odd = false;
+		run("narrowphase/2000", variant.c_str(), pairCount, [&] {
+			odd = !odd;
+			warm.update(odd ? &moved[0] : &shapes[0], n, pairs, threads);
+			keep(warm.contacts.size());
+		});
+	}
+	if (!options.json) printf("%-28s %d pairs, %zu contacts\n", "", (int)pairs.size(), warm.contacts.size());
+}
+
+static void benchmarkRasterization(int n) {
+	std::vector<Vec4> v0(n), v1(n), v2(n), p(n), tr(n), bl(n);
+	std::vector<float> out(n);
+	for (int i = 0; i < n; i++) {
+		v0[i] = Vec4(randomFloat(0.f, 1920.f), randomFloat(0.f, 1080.f), randomFloat(0.f, 1.f), 1.f);
+		v1[i] = Vec4(randomFloat(0.f, 1920.f), randomFloat(0.f, 1080.f), randomFloat(0.f, 1.f), 1.f);
+		v2[i] = Vec4(randomFloat(0.f, 1920.f), randomFloat(0.f, 1080.f), randomFloat(0.f, 1.f), 1.f);
+		p[i] = Vec4(randomFloat(0.f, 1920.f), randomFloat(0.f, 1080.f), 0.f, 1.f);
+	}
+
+	run("raster.edgeFunction", "scalar", n, [&] { for (int i = 0; i < n; i++) out[i] = edgeFunction(v0[i], v1[i], p[i]); keep(out[n - 1]); });
+	run("raster.findBounds", "scalar", n, [&] { for (int i = 0; i < n; i++) findBounds(1920, 1080, v0[i], v1[i], v2[i], tr[i], bl[i]); keep(tr[n - 1].x); });
+}
+
+static void benchmarkBezier(int n) {
+	std::vector<Vec3> controlPoints;
+	for (int i = 0; i < 4; i++) controlPoints.push_back(randomVec3(100.f));
+	BezierCurve curve;
+	curve.loadControlPoints(controlPoints);
+	std::vector<Vec3> out(n);
+
+	run("bezier.cubic", "evaluateT", n, [&] { for (int i = 0; i < n; i++) out[i] = curve.evaluateT((float)i / (n - 1)); keep(out[n - 1].x); });
+	run("bezier.cubic", "sample", n, [&] { curve.sample(&out[0], n); keep(out[n - 1].x); });
+	run("bezier.cubic", "sampleUniform", n, [&] { curve.sampleUniform(&out[0], n); keep(out[n - 1].x); });
+}
+
+// Bones per second for a full AnimationInstance::update on a synthetic skeleton (chain of 4-bone limbs)
+static void benchmarkAnimation() {
+	const int boneCount = 64, frameCount = 32;
+	Animation animation;
+	for (int i = 0; i < boneCount; i++) {
+		Bone bone;
+		bone.name = "bone" + std::to_string(i);
+		bone.offset = randomMatrix();
+		bone.parentIndex = (i % 4 == 0) ? i / 4 - 1 : i - 1;
+		animation.skeleton.bones.push_back(bone);
+	}
+
+	AnimationSequence sequence;
+	sequence.ticksPerSecond = 30.f;
+	sequence.resize(frameCount, boneCount);
+	for (int i = 0; i < frameCount * boneCount; i++) {
+		sequence.positions[i] = randomVec3(10.f);
+		sequence.rotations[i] = randomQuaternion();
+		sequence.scales[i] = Vec3(1.f, 1.f, 1.f);
+	}
+	animation.animations["run"] = sequence;
+
+	AnimationInstance instance;
+	instance.initialize(&animation, 1);
+	instance.update("run", 0.f);
+
+	const int updates = 64;
+	run("animation.update", "bones", boneCount * updates, [&] {
+		for (int u = 0; u < updates; u++) {
+			instance.update("run", 0.0011f);
+			if (instance.animationFinished()) instance.resetAnimationTime();
+		}
+		keep(instance.matrices[boneCount - 1].m[3]);
+	});
+
+	// The T-Rex clips, a herd of instances each playing one of them from its own start time so consecutive updates
+	// read keyframes from different places in memory as a crowd of NPCs would. "float" samples the flat float keys,
+	// "packed" the clips compressed as AnimatedModel::load does by default (0.1 mesh units of skin error on the T-Rex)
+	std::vector<GEMLoader::GEMMesh> meshes;
+	Animation trex;
+	if (!loadModel("TRex.gem", meshes, trex)) return;
+	Animation packed = trex;
+	packed.compress(meshes, 0.1f);
+	std::vector<std::string> clips;
+	for (const auto& clip : trex.animations) clips.push_back(clip.first);
+	const int herd = 64;
+	int trexBones = (int)trex.skeleton.bones.size();
+	std::vector<float> starts(herd);
+	for (int i = 0; i < herd; i++) starts[i] = randomFloat(0.f, trex.animations[clips[i % clips.size()]].duration());
+
+	Animation* forms[] = { &trex, &packed };
+	const char* variants[] = { "herd-64/float", "herd-64/packed" };
+	for (int form = 0; form < 2; form++) {
+		Animation& clipSet = *forms[form];
+		std::vector<AnimationInstance> instances(herd);
+		for (int i = 0; i < herd; i++) {
+			instances[i].initialize(&clipSet, 0);
+			instances[i].update(clips[i % clips.size()], 0.f);
+			instances[i].t = starts[i];
+		}
+		run("animation.update/trex", variants[form], herd * trexBones, [&] {
+			for (int i = 0; i < herd; i++) {
+				AnimationInstance& herdInstance = instances[i];
+				herdInstance.update(herdInstance.currentAnimation, 1.f / 60.f);
+				if (herdInstance.animationFinished()) herdInstance.resetAnimationTime();
+			}
+			keep(instances[herd - 1].matrices[trexBones - 1].m[3]);
+		});
+
+		// Keyframe sampling alone (the local pose of every bone, no hierarchy or skinning matrices)
+		std::vector<AnimationSequence*> sequences(herd);
+		std::vector<float> times(starts);
+		for (int i = 0; i < herd; i++) sequences[i] = &clipSet.animations[clips[i % clips.size()]];
+		std::vector<Vec3> positions(trexBones), scales(trexBones);
+		std::vector<Quaternion> rotations(trexBones);
+		run("animation.sample/trex", variants[form], herd * trexBones, [&] {
+			for (int i = 0; i < herd; i++) {
+				AnimationSequence& sequence = *sequences[i];
+				times[i] += 1.f / 60.f;
+				if (!sequence.running(times[i])) times[i] = 0.f;
+				int frame;
+				float interpolationFact;
+				sequence.calcFrame(times[i], frame, interpolationFact);
+				sequence.samplePose(frame, interpolationFact, &positions[0], &rotations[0], &scales[0]);
+				keep(positions[trexBones - 1].x);
+			}
+		});
+		if (!options.json) {
+			size_t bytes = 0;
+			for (const auto& clip : clipSet.animations) bytes += clip.second.memoryBytes();
+			printf("%-28s %zu clips, %zu key bytes\n", "", clipSet.animations.size(), bytes);
+		}
+	}
+	run("animation.compress/trex", "0.1-units", 1, [&] {
+		Animation recompressed = trex;
+		recompressed.compress(meshes, 0.1f);
+		keep(recompressed.animations.size());
+	});
+}
+
+// JSON Output
+static void printJSON() {
+#if defined(MYMATH_EXPRESSION_TEMPLATES)
+	const char* expressionTemplates = "true";
+#else
+	const char* expressionTemplates = "false";
+#endif
+	printf("{\n  \"simd\": \"%s\",\n  \"expression_templates\": %s,\n  \"size\": %d,\n  \"samples\": %d,\n  \"results\": [\n",
+		simdName(detectSimdLevel()), expressionTemplates, options.size, options.samples);
+	for (size_t i = 0; i < results.size(); i++) {
+		const Result& r = results[i];
+		printf("    {\"name\": \"%s\", \"variant\": \"%s\", \"ns_per_op\": {\"min\": %.4f, \"p10\": %.4f, \"median\": %.4f, \"p90\": %.4f, \"p99\": %.4f}, \"ops_per_second\": %.1f}%s\n",
+			r.name.c_str(), r.variant.c_str(), r.minimum, r.p10, r.median, r.p90, r.p99, 1e9 / r.median, i + 1 < results.size() ? "," : "");
+	}
+	printf("  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--check") options.check = true;
+		else if (arg == "--json") options.json = true;
+		else if (arg == "--filter" && i + 1 < argc) options.filter = argv[++i];
+		else if (arg == "--samples" && i + 1 < argc) options.samples = std::max<int>(1, atoi(argv[++i]));
+		else if (arg == "--size" && i + 1 < argc) options.size = std::max<int>(16, atoi(argv[++i]));
+		else if (arg == "--models" && i + 1 < argc) options.models = argv[++i];
+		else {
+			printf("Usage: %s [--check] [--json] [--filter text] [--samples n] [--size n] [--models dir]\n", argv[0]);
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	if (options.check) {
+		bool passed = checkKernels(options.size);
+		passed &= checkQuaternions(options.size);
+		passed &= checkPackets(options.size);
+		passed &= checkGJKCache(options.size);
+		passed &= checkNarrowphaseCache(options.size);
+		passed &= checkCompression(options.size);
+		return passed ? 0 : 1;
+	}
+
+	if (!options.json) {
+		printf("MyMath benchmark: %d elements, %d samples, best SIMD level %s\n\n", options.size, options.samples, simdName(detectSimdLevel()));
+		printf("%-28s %-22s %10s %10s %10s %10s %12s\n", "benchmark", "variant", "median ns", "p10 ns", "p90 ns", "p99 ns", "Mops/s");
+	}
+
+	int n = options.size;
+	benchmarkMatrix(n);
+	benchmarkTRS(n);
+	benchmarkQuaternion(n);
+	benchmarkVector(n);
+	benchmarkTrigonometry(n);
+	benchmarkCollision(n);
+	benchmarkBVH();
+	benchmarkSpatialHash();
+	benchmarkDynamicTree();
+	benchmarkSweep();
+	benchmarkMeshRaycast();
+	benchmarkHitboxRig();
+	benchmarkConvex();
+	benchmarkNarrowphase();
+	benchmarkRasterization(n);
+	benchmarkBezier(n);
+	benchmarkAnimation();
+
+	if (options.json) printJSON();
+	return 0;
+}
@@ -3,7 +3,9 @@
 #include "Animation.h"
 #include "Core.h"
 #include "GEMLoader.h"
+#include "HitboxRig.h"
 #include "Mesh.h"
+#include "MeshCollider.h"
 #include "PSOManager.h"
 #include "Shaders.h"
 #include "Texture.h"
@@ -13,6 +15,9 @@ public:
 	Animation animation;
 	std::vector<Mesh*> meshes;
 	std::vector<std::string> albedoFilenames;
+	ModelBounds bounds;			// Bind pose
+	HitboxRig hitboxes;			// Bind pose capsules, copied by each character that needs its own posed rig
+	float keyError = 1.5e-4f;	// Animation compression budget as a fraction of the bind pose radius, 0 keeps the float keys (set before load)
 
 	std::string shadername;
 	std::string psoname;
@@ -23,6 +28,7 @@ public:
 		std::vector<GEMLoader::GEMMesh> gemmeshes;
 		GEMLoader::GEMAnimation gemanimation;
 		loader.load(filename, gemmeshes, gemanimation);
+		bounds.compute(gemmeshes);
 
 		for (int i = 0; i < gemmeshes.size(); i++) {
 			Mesh* mesh = new Mesh();
@@ -59,26 +65,28 @@ public:
 			std::string name = gemanimation.animations[i].name;
 			AnimationSequence aseq;
 			aseq.ticksPerSecond = gemanimation.animations[i].ticksPerSecond;
-			for (int n = 0; n < gemanimation.animations[i].frames.size(); n++) {
-				AnimationFrame frame;
-				for (int index = 0; index < gemanimation.animations[i].frames[n].positions.size(); index++) {
-					Vec3 p;
-					Quaternion q;
-					Vec3 s;
-					memcpy(&p, &gemanimation.animations[i].frames[n].positions[index], sizeof(Vec3));
-					frame.positions.push_back(p);
-					memcpy(&q, &gemanimation.animations[i].frames[n].rotations[index], sizeof(Quaternion));
-					frame.rotations.push_back(q);
-					memcpy(&s, &gemanimation.animations[i].frames[n].scales[index], sizeof(Vec3));
-					frame.scales.push_back(s);
+			const std::vector<GEMLoader::GEMAnimationFrame>& gemframes = gemanimation.animations[i].frames;
+			aseq.resize((int)gemframes.size(), gemframes.empty() ? 0 : (int)gemframes[0].positions.size());
+			for (int n = 0; n < gemframes.size(); n++) {
+				// Keys are written in place, frame after frame
+				for (int index = 0; index < aseq.boneCount; index++) {
+					int key = n * aseq.boneCount + index;
+					aseq.positions[key] = Vec3(gemframes[n].positions[index].x, gemframes[n].positions[index].y, gemframes[n].positions[index].z);
+					std::copy(gemframes[n].rotations[index].q, gemframes[n].rotations[index].q + 4, aseq.rotations[key].q);
+					aseq.scales[key] = Vec3(gemframes[n].scales[index].x, gemframes[n].scales[index].y, gemframes[n].scales[index].z);
 				}
-				aseq.frames.push_back(frame);
 			}
-			animation.animations.insert({ name, aseq });
+			animation.animations.insert({ name, std::move(aseq) });
 		}
+
+		hitboxes.build(animation.skeleton, gemmeshes);
+
+		// Compressed keys take about a seventh of the memory and sample faster than the float ones, no skinned vertex
+		// strays more than keyError of the model's size
+		if (keyError > 0.f) animation.compress(gemmeshes, keyError * bounds.sphere.radius);
 	}
 
-	void draw(Core* core, AnimationInstance* instance, TextureManager* textures, PSOManager* psos, ShaderManager* shaders, Matrix& vp, Matrix& w) {
+	void draw(Core* core, AnimationInstance* instance, TextureManager* textures, PSOManager* psos, ShaderManager* shaders, Matrix& vp, const Matrix& w) {
 		psos->bind(core, psoname);
 		shaders->updateConstantVertexShaderBuffer(shadername, "animatedMeshBuffer", "W", &w);
 		shaders->updateConstantVertexShaderBuffer(shadername, "animatedMeshBuffer", "VP", &vp);
@@ -4,6 +4,8 @@
 #include <map>
 #include <vector>
 
+#include "AnimationCompression.h"
+#include "GEMLoader.h"
 #include "MyMath.h"
 
 struct Bone {
@@ -23,54 +25,127 @@ struct Skeleton {
 	}
 };
 
-struct AnimationFrame {
+// Keyframes of one clip, one contiguous array per channel indexed [frame * boneCount + bone]. A frame of the whole
+// skeleton is a single run in each array and sampling reads the two frames it blends front to back. The arrays come
+// from operator new, which aligns them to 16 bytes on x64, so every rotation key starts on a 16 byte boundary
+// After compress the float keys are released and every sampler decodes compressed instead
+struct AnimationSequence {
 	std::vector<Vec3> positions;
 	std::vector<Quaternion> rotations;
 	std::vector<Vec3> scales;
-};
-
-struct AnimationSequence {
-	std::vector<AnimationFrame> frames;
+	CompressedClip compressed;
+	int frameCount = 0;
+	int boneCount = 0;
 	float ticksPerSecond;
-	
+
+	void resize(int frames, int bones) {
+		frameCount = frames;
+		boneCount = bones;
+		positions.resize(frames * bones);
+		rotations.resize(frames * bones);
+		scales.resize(frames * bones);
+	}
+
+	// The float keys of one frame, nullptr once the clip is compressed (sample with samplePose or interpolateBoneToGlobal)
+	const Vec3* framePositions(int frame) const { return isCompressed() ? nullptr : &positions[frame * boneCount]; }
+	const Quaternion* frameRotations(int frame) const { return isCompressed() ? nullptr : &rotations[frame * boneCount]; }
+	const Vec3* frameScales(int frame) const { return isCompressed() ? nullptr : &scales[frame * boneCount]; }
+
+	bool isCompressed() const { return compressed.frameCount > 0; }
+
+	// Replaces the float keys with a CompressedClip, see AnimationCompression.h for the forms and the error measure
+	void compress(const Skeleton& skeleton, const std::vector<float>& shells, const std::vector<float>& maxErrors) {
+		std::vector<int> parents(boneCount);
+		for (int i = 0; i < boneCount; i++) parents[i] = skeleton.bones[i].parentIndex;
+		compressed.build(positions.data(), rotations.data(), scales.data(), frameCount, boneCount, parents.data(), shells.data(), maxErrors.data());
+		std::vector<Vec3>().swap(positions);
+		std::vector<Quaternion>().swap(rotations);
+		std::vector<Vec3>().swap(scales);
+	}
+
+	// Heap bytes held by the keys
+	size_t memoryBytes() const {
+		return positions.capacity() * sizeof(Vec3) + rotations.capacity() * sizeof(Quaternion) + scales.capacity() * sizeof(Vec3) + compressed.memoryBytes();
+	}
+
 	Vec3 interpolate(Vec3 p1, Vec3 p2, float t) {
 		return ((p1 * (1.0f - t)) + (p2 * t));
 	}
 	
 	Quaternion interpolate(Quaternion q1, Quaternion q2, float t) {
-		return Quaternion::slerp(q1, q2, t);
+		return Quaternion::slerp<FastMath>(q1, q2, t);
 	}
 	
 	float duration() {
-		return ((float)frames.size() / ticksPerSecond);
+		return ((float)frameCount / ticksPerSecond);
 	}
 
 	void calcFrame(float t, int& frame, float& interpolationFact) {
 		interpolationFact = t * ticksPerSecond;
 		frame = (int)floorf(interpolationFact);
 		interpolationFact = interpolationFact - (float)frame;
-		frame = std::min<int>(frame, (int)(frames.size() - 1));
+		frame = std::min<int>(frame, frameCount - 1);
 	}
 
 	bool running(float t) {
-		return ((int)floorf(t * ticksPerSecond) < frames.size());
+		return ((int)floorf(t * ticksPerSecond) < frameCount);
 	}
 	
 	int nextFrame(int frame) {
-		return std::min<int>(frame + 1, (int)(frames.size() - 1));
+		return std::min<int>(frame + 1, frameCount - 1);
+	}
+
+	// Interpolate the rotations of every bone at once (batched SIMD slerp)
+	void interpolateRotations(int baseFrame, float interpolationFact, Quaternion* out) {
+		if (isCompressed()) {
+			compressed.sampleRotations(baseFrame, nextFrame(baseFrame), interpolationFact, out);
+			return;
+		}
+		interpolateQuaternions(frameRotations(baseFrame), frameRotations(nextFrame(baseFrame)), out, boneCount, interpolationFact);
+	}
+
+	// Local pose of every bone, one linear pass over each channel of the two frames
+	void samplePose(int baseFrame, float interpolationFact, Vec3* outPositions, Quaternion* outRotations, Vec3* outScales) {
+		int next = nextFrame(baseFrame);
+		if (isCompressed()) {
+			compressed.samplePose(baseFrame, next, interpolationFact, outPositions, outRotations, outScales);
+			return;
+		}
+		const Vec3* fromPositions = framePositions(baseFrame);
+		const Vec3* toPositions = framePositions(next);
+		const Vec3* fromScales = frameScales(baseFrame);
+		const Vec3* toScales = frameScales(next);
+		for (int i = 0; i < boneCount; i++) {
+			outPositions[i] = interpolate(fromPositions[i], toPositions[i], interpolationFact);
+			outScales[i] = interpolate(fromScales[i], toScales[i], interpolationFact);
+		}
+		interpolateRotations(baseFrame, interpolationFact, outRotations);
 	}
 
 	Matrix interpolateBoneToGlobal(Matrix* matrices, int baseFrame, float interpolationFact, Skeleton* skeleton, int boneIndex) {
-		Matrix scale = Matrix::scale(interpolate(frames[baseFrame].scales[boneIndex], frames[nextFrame(baseFrame)].scales[boneIndex], interpolationFact));
-		Matrix rotation = interpolate(frames[baseFrame].rotations[boneIndex], frames[nextFrame(baseFrame)].rotations[boneIndex], interpolationFact).toMatrix();
-		Matrix translation = Matrix::translate(interpolate(frames[baseFrame].positions[boneIndex], frames[nextFrame(baseFrame)].positions[boneIndex], interpolationFact));
-		Matrix local = scale * rotation * translation;
+		if (isCompressed()) {
+			Vec3 translation, scale;
+			Quaternion rotation;
+			compressed.sampleBone(boneIndex, baseFrame, nextFrame(baseFrame), interpolationFact, translation, rotation, scale);
+			return boneToGlobal(matrices, translation, rotation, scale, skeleton, boneIndex);
+		}
+		int from = baseFrame * boneCount + boneIndex, to = nextFrame(baseFrame) * boneCount + boneIndex;
+		Quaternion rotation = interpolate(rotations[from], rotations[to], interpolationFact);
+		Vec3 scale = interpolate(scales[from], scales[to], interpolationFact);
+		Vec3 translation = interpolate(positions[from], positions[to], interpolationFact);
+		return boneToGlobal(matrices, translation, rotation, scale, skeleton, boneIndex);
+	}
+
+	// Global transform of a bone from its local pose and its parent's global transform (already in matrices)
+	static Matrix boneToGlobal(Matrix* matrices, const Vec3& translation, const Quaternion& rotation, const Vec3& scale, Skeleton* skeleton, int boneIndex) {
+		// Bone transforms are affine, build the local one straight from T, R and S as 3x4 to skip the constant bottom row
+		Affine local = Affine::fromTRS(translation, rotation, scale);
 		
 		if (skeleton->bones[boneIndex].parentIndex > -1) {
-			Matrix global = local * matrices[skeleton->bones[boneIndex].parentIndex];
-			return global;
+			Affine global = local * Affine(matrices[skeleton->bones[boneIndex].parentIndex]);
+			return global.toMatrix();
 		}
-		return local;
+		return local.toMatrix();
 	}
 };
 
@@ -92,6 +167,26 @@ public:
 			matrices[i] = skeleton.bones[i].offset * matrices[i] * skeleton.globalInverse * coordTransform;
 	}
 
+	// Compresses every clip so no skinned vertex of meshes moves more than maxError (mesh units) from where the float
+	// keys put it. A bone's shell is its furthest vertex in bone space, over the vertices it or any bone below it has
+	// weight on, since an error in the bone moves all of them
+	void compress(const std::vector<GEMLoader::GEMMesh>& meshes, float maxError) {
+		std::vector<float> shells(skeleton.bones.size(), 0.f);
+		for (const GEMLoader::GEMMesh& mesh : meshes) {
+			for (const GEMLoader::GEMAnimatedVertex& vertex : mesh.verticesAnimated) {
+				Vec3 position(vertex.position.x, vertex.position.y, vertex.position.z);
+				for (int i = 0; i < 4; i++) {
+					unsigned int bone = vertex.bonesIDs[i];
+					if (vertex.boneWeights[i] <= 0.f || bone >= shells.size()) continue;
+					for (int b = (int)bone; b > -1; b = skeleton.bones[b].parentIndex)
+						shells[b] = std::max<float>(shells[b], skeleton.bones[b].offset.mulPoint(position).length());
+				}
+			}
+		}
+		std::vector<float> maxErrors(skeleton.bones.size(), maxError);
+		for (auto& clip : animations) clip.second.compress(skeleton, shells, maxErrors);
+	}
+
 	bool hasAnimation(std::string name) {
 		return !(animations.find(name) == animations.end());
 	}
@@ -104,6 +199,9 @@ public:
 	float t;
 	Matrix matrices[256];
 	Matrix matricesPose[256];
+	Vec3 posePositions[256];	// Local pose scratch for update
+	Quaternion poseRotations[256];
+	Vec3 poseScales[256];
 	Matrix coordTransform;
 
 	void initialize(Animation* _animation, int fromYZX) {
@@ -136,9 +234,13 @@ public:
 
 		int frame = 0;
 		float interpolationFact = 0;
-		animation->calcFrame(name, t, frame, interpolationFact);
+		AnimationSequence& sequence = animation->animations[name];
+		sequence.calcFrame(t, frame, interpolationFact);
+
+		// Local pose of the whole skeleton in one pass over the keys, then the per-bone hierarchy walk
+		sequence.samplePose(frame, interpolationFact, posePositions, poseRotations, poseScales);
 		for (int i = 0; i < animation->skeleton.bones.size(); i++)
-			matrices[i] = animation->interpolateBoneToGlobal(name, matrices, frame, interpolationFact, i);
+			matrices[i] = AnimationSequence::boneToGlobal(matrices, posePositions[i], poseRotations[i], poseScales[i], &animation->skeleton, i);
 		animation->calcFinalTransforms(matrices, coordTransform);
 	}
 
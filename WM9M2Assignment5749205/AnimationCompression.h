@@ -0,0 +1,615 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <vector>
+
+#include "MyMath.h"
+
+// Animation Compression
+// Keyframes of a clip stored per channel in the cheapest form that keeps every skinned vertex within an error budget
+// of where the float keys put it:
+// Constant: one value for the whole clip (bones that never move, or only roll a little, are most of a skeleton)
+// Identity: scale that stays (1, 1, 1), nothing is stored
+// Quantized: rotations as smallest three (the largest component is dropped and rebuilt from |q| = 1, the other three
+//            lie in [-1/sqrt(2), 1/sqrt(2)] and get 15 bits each, 48 bits a key), translations and scales as 16 bits
+//            per component over the track's own range
+// Raw: the float keys, for the few tracks the quantization is too coarse for
+// The error of a bone is measured where the skin is: points at the bone's shell distance (its furthest skinned vertex)
+// in bone space, transformed by the global pose of the float keys and of the compressed ones. Bones are compressed
+// parents first, so a bone is measured with the error its compressed ancestors already carry
+
+enum TrackFormat {
+	TrackConstant,
+	TrackIdentity,
+	TrackQuantized,
+	TrackRaw
+};
+
+// Smallest three, two bits name the dropped component (top bits of the first two words). The words of a key are
+// stride apart, so keys can be stored as three planes
+static void packRotation(const Quaternion& q, unsigned short* out, int stride = 1) {
+	int largest = 0;
+	for (int i = 1; i < 4; i++)
+		if (fabsf(q.q[i]) > fabsf(q.q[largest])) largest = i;
+	float sign = q.q[largest] < 0.f ? -1.f : 1.f;
+	int k = 0;
+	for (int i = 0; i < 4; i++) {
+		if (i == largest) continue;
+		float unit = clamp(q.q[i] * sign * 0.70710678f + 0.5f, 0.f, 1.f);		// [-1/sqrt(2), 1/sqrt(2)] to [0, 1]
+		out[stride * k++] = (unsigned short)(unit * 32767.f + 0.5f);
+	}
+	out[0] |= (unsigned short)((largest & 1) << 15);
+	out[stride] |= (unsigned short)((largest >> 1) << 15);
+}
+
+static Quaternion unpackRotation(const unsigned short* in, int stride = 1) {
+	float x = ((float)(in[0] & 0x7fff) * (1.f / 32767.f) - 0.5f) * 1.41421356f;
+	float y = ((float)(in[stride] & 0x7fff) * (1.f / 32767.f) - 0.5f) * 1.41421356f;
+	float z = ((float)in[stride * 2] * (1.f / 32767.f) - 0.5f) * 1.41421356f;
+	float w = sqrtf(std::max<float>(0.f, 1.f - x * x - y * y - z * z));
+	// The rebuilt component goes back where it was dropped from, with selects rather than a switch since which
+	// component is largest changes from track to track and the branch would miss
+	int largest = (in[0] >> 15) | ((in[stride] >> 15) << 1);
+	Quaternion q;
+	q.a = largest == 0 ? w : x;
+	q.b = largest == 0 ? x : (largest == 1 ? w : y);
+	q.c = largest <= 1 ? y : (largest == 2 ? w : z);
+	q.d = largest == 3 ? w : z;
+	return q;
+}
+
+#ifdef MYMATH_X86
+// unpackRotation for four keys at once, from their x, y and z words (one key a lane) straight into a/b/c/d lanes
+static inline void unpackRotationLanesSSE(__m128i xi, __m128i yi, __m128i zi, __m128& a, __m128& b, __m128& c, __m128& d) {
+	const __m128i zero = _mm_setzero_si128(), low = _mm_set1_epi32(0x7fff);
+	const __m128 scale = _mm_set1_ps(1.41421356f / 32767.f), offset = _mm_set1_ps(0.70710678f);
+	__m128i largest = _mm_or_si128(_mm_srli_epi32(xi, 15), _mm_slli_epi32(_mm_srli_epi32(yi, 15), 1));
+	__m128 x = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(xi, low)), scale), offset);
+	__m128 y = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(yi, low)), scale), offset);
+	__m128 z = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(zi), scale), offset);
+	__m128 w = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+	w = _mm_sqrt_ps(_mm_max_ps(_mm_setzero_ps(), _mm_sub_ps(_mm_set1_ps(1.f), w)));
+
+	__m128 is0 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, zero));
+	__m128 is1 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(1)));
+	__m128 is2 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(2)));
+	__m128 is3 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(3)));
+	auto select = [](__m128 mask, __m128 v, __m128 otherwise) { return _mm_or_ps(_mm_and_ps(mask, v), _mm_andnot_ps(mask, otherwise)); };
+	a = select(is0, w, x);
+	b = select(is0, x, select(is1, w, y));
+	c = select(_mm_or_ps(is0, is1), y, select(is2, w, z));
+	d = select(is3, w, z);
+}
+
+// Four consecutive keys of planes stored stride words apart
+static inline void unpackRotationsSSE(const unsigned short* in, int stride, __m128& a, __m128& b, __m128& c, __m128& d) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i xi = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)in), zero);
+	__m128i yi = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(in + stride)), zero);
+	__m128i zi = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(in + stride * 2)), zero);
+	unpackRotationLanesSSE(xi, yi, zi, a, b, c, d);
+}
+
+// Decodes count keys of each of two frames (planes stride words apart, padded to four tracks), slerps them and
+// writes each result to out[bones[i]]
+static void slerpPackedRotationsSSE(const unsigned short* fromKeys, const unsigned short* toKeys, int stride, const int* bones, int count, float t, Quaternion* out) {
+	const __m128 tt = _mm_set1_ps(t);
+	for (int i = 0; i < count; i += 4) {
+		__m128 a1, b1, c1, d1, a2, b2, c2, d2;
+		unpackRotationsSSE(fromKeys + i, stride, a1, b1, c1, d1);
+		unpackRotationsSSE(toKeys + i, stride, a2, b2, c2, d2);
+		quaternionBlendLanesSSE(a1, b1, c1, d1, a2, b2, c2, d2, tt, QuaternionSlerp);
+		_MM_TRANSPOSE4_PS(a2, b2, c2, d2);
+		_mm_storeu_ps(out[bones[i]].q, a2);
+		if (i + 1 < count) _mm_storeu_ps(out[bones[i + 1]].q, b2);
+		if (i + 2 < count) _mm_storeu_ps(out[bones[i + 2]].q, c2);
+		if (i + 3 < count) _mm_storeu_ps(out[bones[i + 3]].q, d2);
+	}
+}
+
+MYMATH_TARGET_AVX2 static inline void unpackRotationsAVX2(const unsigned short* in, int stride, __m256& a, __m256& b, __m256& c, __m256& d) {
+	const __m256i low = _mm256_set1_epi32(0x7fff);
+	const __m256 scale = _mm256_set1_ps(1.41421356f / 32767.f), offset = _mm256_set1_ps(0.70710678f);
+	__m256i xi = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)in));
+	__m256i yi = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(in + stride)));
+	__m256i zi = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(in + stride * 2)));
+	__m256i largest = _mm256_or_si256(_mm256_srli_epi32(xi, 15), _mm256_slli_epi32(_mm256_srli_epi32(yi, 15), 1));
+	__m256 x = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(xi, low)), scale), offset);
+	__m256 y = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(yi, low)), scale), offset);
+	__m256 z = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(zi), scale), offset);
+	__m256 w = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+	w = _mm256_sqrt_ps(_mm256_max_ps(_mm256_setzero_ps(), _mm256_sub_ps(_mm256_set1_ps(1.f), w)));
+
+	__m256 is0 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest, _mm256_setzero_si256()));
+	__m256 is1 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest, _mm256_set1_epi32(1)));
+	__m256 is2 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest, _mm256_set1_epi32(2)));
+	__m256 is3 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest, _mm256_set1_epi32(3)));
+	a = _mm256_blendv_ps(x, w, is0);
+	b = _mm256_blendv_ps(_mm256_blendv_ps(y, w, is1), x, is0);
+	c = _mm256_blendv_ps(_mm256_blendv_ps(z, w, is2), y, _mm256_or_ps(is0, is1));
+	d = _mm256_blendv_ps(z, w, is3);
+}
+
+// Eight tracks a step, the rest through the SSE path
+MYMATH_TARGET_AVX2 static void slerpPackedRotationsAVX2(const unsigned short* fromKeys, const unsigned short* toKeys, int stride, const int* bones, int count, float t, Quaternion* out) {
+	const __m256 tt = _mm256_set1_ps(t);
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 a1, b1, c1, d1, a2, b2, c2, d2;
+		unpackRotationsAVX2(fromKeys + i, stride, a1, b1, c1, d1);
+		unpackRotationsAVX2(toKeys + i, stride, a2, b2, c2, d2);
+		quaternionBlendLanesAVX2(a1, b1, c1, d1, a2, b2, c2, d2, tt, QuaternionSlerp);
+		MYMATH_TRANSPOSE4_256(a2, b2, c2, d2);
+		_mm_storeu_ps(out[bones[i]].q, _mm256_castps256_ps128(a2));
+		_mm_storeu_ps(out[bones[i + 1]].q, _mm256_castps256_ps128(b2));
+		_mm_storeu_ps(out[bones[i + 2]].q, _mm256_castps256_ps128(c2));
+		_mm_storeu_ps(out[bones[i + 3]].q, _mm256_castps256_ps128(d2));
+		_mm_storeu_ps(out[bones[i + 4]].q, _mm256_extractf128_ps(a2, 1));
+		_mm_storeu_ps(out[bones[i + 5]].q, _mm256_extractf128_ps(b2, 1));
+		_mm_storeu_ps(out[bones[i + 6]].q, _mm256_extractf128_ps(c2, 1));
+		_mm_storeu_ps(out[bones[i + 7]].q, _mm256_extractf128_ps(d2, 1));
+	}
+	slerpPackedRotationsSSE(fromKeys + i, toKeys + i, stride, bones + i, count - i, t, out);
+}
+
+// Raw rotation keys of two frames (padded to four tracks), a register of tracks at a time like the packed ones
+static void slerpRawRotationsSSE(const Quaternion* fromKeys, const Quaternion* toKeys, const int* bones, int count, float t, Quaternion* out) {
+	const __m128 tt = _mm_set1_ps(t);
+	for (int i = 0; i < count; i += 4) {
+		__m128 a1 = _mm_loadu_ps(fromKeys[i].q), b1 = _mm_loadu_ps(fromKeys[i + 1].q), c1 = _mm_loadu_ps(fromKeys[i + 2].q), d1 = _mm_loadu_ps(fromKeys[i + 3].q);
+		__m128 a2 = _mm_loadu_ps(toKeys[i].q), b2 = _mm_loadu_ps(toKeys[i + 1].q), c2 = _mm_loadu_ps(toKeys[i + 2].q), d2 = _mm_loadu_ps(toKeys[i + 3].q);
+		_MM_TRANSPOSE4_PS(a1, b1, c1, d1);
+		_MM_TRANSPOSE4_PS(a2, b2, c2, d2);
+		quaternionBlendLanesSSE(a1, b1, c1, d1, a2, b2, c2, d2, tt, QuaternionSlerp);
+		_MM_TRANSPOSE4_PS(a2, b2, c2, d2);
+		_mm_storeu_ps(out[bones[i]].q, a2);
+		if (i + 1 < count) _mm_storeu_ps(out[bones[i + 1]].q, b2);
+		if (i + 2 < count) _mm_storeu_ps(out[bones[i + 2]].q, c2);
+		if (i + 3 < count) _mm_storeu_ps(out[bones[i + 3]].q, d2);
+	}
+}
+#endif
+
+static void slerpRawRotations(const Quaternion* fromKeys, const Quaternion* toKeys, const int* bones, int count, float t, Quaternion* out) {
+#ifdef MYMATH_X86
+	if (matrixKernels().level >= SimdSSE) return slerpRawRotationsSSE(fromKeys, toKeys, bones, count, t, out);
+#endif
+	for (int i = 0; i < count; i++) interpolateQuaternions(fromKeys + i, toKeys + i, &out[bones[i]], 1, t);
+}
+
+static void slerpPackedRotations(const unsigned short* fromKeys, const unsigned short* toKeys, int stride, const int* bones, int count, float t, Quaternion* out) {
+#ifdef MYMATH_X86
+	if (matrixKernels().level >= SimdAVX2) return slerpPackedRotationsAVX2(fromKeys, toKeys, stride, bones, count, t, out);
+	if (matrixKernels().level >= SimdSSE) return slerpPackedRotationsSSE(fromKeys, toKeys, stride, bones, count, t, out);
+#endif
+	for (int i = 0; i < count; i++) {
+		Quaternion from = unpackRotation(fromKeys + i, stride), to = unpackRotation(toKeys + i, stride);
+		interpolateQuaternions(&from, &to, &out[bones[i]], 1, t);
+	}
+}
+
+// One quantized Vec3 track of two frames, from its x words and its x minimum (the other words, minimums and steps
+// follow stride apart)
+static Vec3 lerpPackedVec3(const unsigned short* fromKeys, const unsigned short* toKeys, int stride, const float* ranges, float t) {
+	Vec3 v;
+	for (int axis = 0; axis < 3; axis++) {
+		float from = (float)fromKeys[axis * stride], to = (float)toKeys[axis * stride];
+		v.v[axis] = ranges[axis * stride] + (from + (to - from) * t) * ranges[(axis + 3) * stride];
+	}
+	return v;
+}
+
+#ifdef MYMATH_X86
+// Quantized Vec3 keys of two frames (planes stride words apart, padded to four tracks) blended four tracks at a time:
+// the integers are blended, then one multiply-add per plane into the track's range. ranges holds the minimum planes
+// then the step planes. Results are written to out[bones[i]] as 8 + 4 bytes, a 16 byte store would reach the next bone
+static void lerpPackedVec3SSE(const unsigned short* fromKeys, const unsigned short* toKeys, int stride, const float* ranges, const int* bones, int count, float t, Vec3* out) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 tt = _mm_set1_ps(t);
+	for (int i = 0; i < count; i += 4) {
+		__m128 lanes[4];
+		for (int axis = 0; axis < 3; axis++) {
+			__m128 from = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(fromKeys + axis * stride + i)), zero));
+			__m128 to = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(toKeys + axis * stride + i)), zero));
+			__m128 unit = _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), tt));
+			lanes[axis] = _mm_add_ps(_mm_loadu_ps(ranges + axis * stride + i), _mm_mul_ps(unit, _mm_loadu_ps(ranges + (axis + 3) * stride + i)));
+		}
+		lanes[3] = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(lanes[0], lanes[1], lanes[2], lanes[3]);
+		for (int lane = 0; lane < 4 && i + lane < count; lane++) {
+			Vec3& v = out[bones[i + lane]];
+			_mm_storel_pi((__m64*)v.v, lanes[lane]);
+			_mm_store_ss(&v.z, _mm_movehl_ps(lanes[lane], lanes[lane]));
+		}
+	}
+}
+#endif
+
+static void lerpPackedVec3(const unsigned short* fromKeys, const unsigned short* toKeys, int stride, const float* ranges, const int* bones, int count, float t, Vec3* out) {
+#ifdef MYMATH_X86
+	if (matrixKernels().level >= SimdSSE) return lerpPackedVec3SSE(fromKeys, toKeys, stride, ranges, bones, count, t, out);
+#endif
+	for (int i = 0; i < count; i++) out[bones[i]] = lerpPackedVec3(fromKeys + i, toKeys + i, stride, ranges + i, t);
+}
+
+// One channel (positions, rotations or scales) of every bone. Tracks of each format are listed with the bone they
+// belong to and the animated ones keep their keys frame-major ([frame * tracks + track]), so sampling a frame reads
+// one contiguous run per format. Quantized keys are stored as three planes a frame (every x word, every y word, every
+// z word, each padded to a multiple of four tracks) so they decode four tracks to a register
+template<typename Value>
+struct CompressedChannel {
+	std::vector<unsigned char> formats;		// Per bone
+	std::vector<int> tracks;				// Per bone, position in the list of its format
+
+	std::vector<int> constantBones;
+	std::vector<Value> constants;
+	std::vector<Value> pose;				// Per bone, the constant and identity values in place, copied whole before sampling
+
+	std::vector<int> quantizedBones;
+	std::vector<Vec3> rangeMin, rangeExtent;	// Vec3 channels only
+	std::vector<unsigned short> quantizedKeys;	// Three words a key
+	std::vector<float> quantizedRanges;			// Vec3 channels only, rangeMin then rangeExtent / 65535 of the quantized tracks as planes
+	int quantizedStride = 0;					// Words between the planes of a frame
+
+	std::vector<int> rawBones;
+	std::vector<Value> rawKeys;
+	int rawStride = 0;							// Raw keys a frame, rotations padded to a multiple of four tracks
+
+	std::vector<int> identityBones;
+
+	size_t memoryBytes() const {
+		return formats.capacity() + (tracks.capacity() + constantBones.capacity() + quantizedBones.capacity() + rawBones.capacity() + identityBones.capacity()) * sizeof(int) +
+			(constants.capacity() + pose.capacity() + rawKeys.capacity()) * sizeof(Value) + (rangeMin.capacity() + rangeExtent.capacity()) * sizeof(Vec3) + quantizedRanges.capacity() * sizeof(float) + quantizedKeys.capacity() * sizeof(unsigned short);
+	}
+};
+
+static Vec3 unpackVec3(const unsigned short* in, const Vec3& rangeMin, const Vec3& rangeExtent) {
+	return Vec3(rangeMin.x + (float)in[0] * (1.f / 65535.f) * rangeExtent.x,
+				rangeMin.y + (float)in[1] * (1.f / 65535.f) * rangeExtent.y,
+				rangeMin.z + (float)in[2] * (1.f / 65535.f) * rangeExtent.z);
+}
+
+static void packVec3(const Vec3& v, const Vec3& rangeMin, const Vec3& rangeExtent, unsigned short* out) {
+	for (int i = 0; i < 3; i++) {
+		float unit = rangeExtent.v[i] > 0.f ? clamp((v.v[i] - rangeMin.v[i]) / rangeExtent.v[i], 0.f, 1.f) : 0.f;
+		out[i] = (unsigned short)(unit * 65535.f + 0.5f);
+	}
+}
+
+class CompressedClip {
+public:
+	int frameCount = 0;
+	int boneCount = 0;
+	CompressedChannel<Vec3> positions;
+	CompressedChannel<Quaternion> rotations;
+	CompressedChannel<Vec3> scales;
+
+	// Keys indexed [frame * boneCount + bone] as AnimationSequence stores them. parents lists the parent of every
+	// bone (-1 for roots), shells the distance from each bone to its furthest skinned vertex in bone space (0 for
+	// bones that skin nothing, their error still moves their children). maxErrors is the budget of every bone, in the
+	// units of the mesh
+	void build(const Vec3* keyPositions, const Quaternion* keyRotations, const Vec3* keyScales, int frames, int bones, const int* parents, const float* shells, const float* maxErrors) {
+		frameCount = frames;
+		boneCount = bones;
+		std::vector<int> order = parentsFirst(parents, bones);
+
+		// Global pose of every frame from the float keys, the reference the compressed one is measured against
+		std::vector<Affine> reference(frames * bones), compressed(frames * bones);
+		for (int f = 0; f < frames; f++) {
+			for (int bone : order) {
+				int key = f * bones + bone;
+				Affine local = Affine::fromTRS(keyPositions[key], keyRotations[key], keyScales[key]);
+				reference[key] = parents[bone] > -1 ? local * reference[f * bones + parents[bone]] : local;
+			}
+		}
+
+		std::vector<unsigned char> rotationFormats(bones), positionFormats(bones), scaleFormats(bones);
+		std::vector<Quaternion> rotationConstants(bones);
+		std::vector<Vec3> positionConstants(bones), scaleConstants(bones), positionMin(bones), positionExtent(bones), scaleMin(bones), scaleExtent(bones);
+		std::vector<int> tightened(bones, 0);		// Times a descendant missed the budget because of this bone
+		std::vector<Quaternion> trackRotations(frames), quantizedRotations(frames), trialRotations(frames);
+		std::vector<Vec3> trackPositions(frames), quantizedPositions(frames), trialPositions(frames);
+		std::vector<Vec3> trackScales(frames), quantizedScales(frames), trialScales(frames);
+
+		for (bool done = false; !done;) {
+			done = true;
+			for (int bone : order) {
+				// Skin error of the trial keys: the bone origin and points on its shell along the axes and the diagonals, under
+				// the compressed ancestors (or the float ones, to tell the bone's own error from what it inherits)
+				float shell = shells[bone], corner = shells[bone] * 0.57735027f;
+				const Vec3 points[15] = { Vec3(0.f, 0.f, 0.f), Vec3(shell, 0.f, 0.f), Vec3(-shell, 0.f, 0.f), Vec3(0.f, shell, 0.f), Vec3(0.f, -shell, 0.f), Vec3(0.f, 0.f, shell), Vec3(0.f, 0.f, -shell),
+					Vec3(corner, corner, corner), Vec3(-corner, corner, corner), Vec3(corner, -corner, corner), Vec3(-corner, -corner, corner),
+					Vec3(corner, corner, -corner), Vec3(-corner, corner, -corner), Vec3(corner, -corner, -corner), Vec3(-corner, -corner, -corner) };
+				auto error = [&](const std::vector<Affine>& ancestors) {
+					float worst = 0.f;
+					for (int f = 0; f < frames; f++) {
+						int key = f * bones + bone;
+						Affine local = Affine::fromTRS(trialPositions[f], trialRotations[f], trialScales[f]);
+						Affine global = parents[bone] > -1 ? local * ancestors[f * bones + parents[bone]] : local;
+						for (const Vec3& p : points) worst = std::max<float>(worst, (global.mulPoint(p) - reference[key].mulPoint(p)).lengthSquare());
+					}
+					return sqrtf(worst);
+				};
+
+				// Ancestors of bones that missed the budget get a smaller one, after eight halvings they stay raw
+				float budget = tightened[bone] >= 8 ? -1.f : maxErrors[bone] / (float)(1 << tightened[bone]);
+				fitRanges(keyRotations, keyPositions, keyScales, bone, rotationConstants[bone], positionConstants[bone], positionMin[bone], positionExtent[bone], scaleConstants[bone], scaleMin[bone], scaleExtent[bone]);
+				for (int f = 0; f < frames; f++) {
+					int key = f * bones + bone;
+					unsigned short packed[3];
+					trackRotations[f] = keyRotations[key];
+					packRotation(keyRotations[key], packed);
+					quantizedRotations[f] = unpackRotation(packed);
+					trackPositions[f] = keyPositions[key];
+					packVec3(keyPositions[key], positionMin[bone], positionExtent[bone], packed);
+					quantizedPositions[f] = unpackVec3(packed, positionMin[bone], positionExtent[bone]);
+					trackScales[f] = keyScales[key];
+					packVec3(keyScales[key], scaleMin[bone], scaleExtent[bone], packed);
+					quantizedScales[f] = unpackVec3(packed, scaleMin[bone], scaleExtent[bone]);
+				}
+
+				// Candidate keys of one channel in the form being tried, false when the form doesn't fit the budget
+				auto tryForm = [&](auto& trial, const auto& track, const auto& quantized, int format, const auto& constant) {
+					for (int f = 0; f < frames; f++) {
+						if (format == TrackIdentity || format == TrackConstant) trial[f] = constant;
+						else if (format == TrackQuantized) trial[f] = quantized[f];
+						else trial[f] = track[f];
+					}
+					return format == TrackRaw || error(compressed) <= budget;
+				};
+				// Cheapest form of each channel in turn, the channels not decided yet stay raw
+				trialRotations = trackRotations;
+				trialPositions = trackPositions;
+				trialScales = trackScales;
+				const int rotationTries[] = { TrackConstant, TrackQuantized, TrackRaw };
+				for (int format : rotationTries) {
+					rotationFormats[bone] = format;
+					if (tryForm(trialRotations, trackRotations, quantizedRotations, format, rotationConstants[bone])) break;
+				}
+				const int positionTries[] = { TrackConstant, TrackQuantized, TrackRaw };
+				for (int format : positionTries) {
+					positionFormats[bone] = format;
+					if (tryForm(trialPositions, trackPositions, quantizedPositions, format, positionConstants[bone])) break;
+				}
+				const int scaleTries[] = { TrackIdentity, TrackConstant, TrackQuantized, TrackRaw };
+				for (int format : scaleTries) {
+					scaleFormats[bone] = format;
+					if (tryForm(trialScales, trackScales, quantizedScales, format, format == TrackIdentity ? Vec3(1.f, 1.f, 1.f) : scaleConstants[bone])) break;
+				}
+
+				// Over the budget as it is: halve the budget of the nearest ancestor that is not raw yet and start over. Raw
+				// keys that quantization would do without the error the ancestors already carry halve it too, but only once
+				// per ancestor, past that the ancestor's keys cost more than the raw track
+				bool blameAncestors = error(compressed) > maxErrors[bone];
+				int limit = blameAncestors ? 8 : 1;
+				if (!blameAncestors && budget >= 0.f && (rotationFormats[bone] == TrackRaw || positionFormats[bone] == TrackRaw || scaleFormats[bone] == TrackRaw)) {
+					std::vector<Quaternion> rawRotations(trialRotations);
+					std::vector<Vec3> rawPositions(trialPositions), rawScales(trialScales);
+					if (rotationFormats[bone] == TrackRaw) trialRotations = quantizedRotations;
+					if (positionFormats[bone] == TrackRaw) trialPositions = quantizedPositions;
+					if (scaleFormats[bone] == TrackRaw) trialScales = quantizedScales;
+					blameAncestors = error(reference) <= budget;
+					trialRotations.swap(rawRotations);
+					trialPositions.swap(rawPositions);
+					trialScales.swap(rawScales);
+				}
+				if (blameAncestors) {
+					int parent = parents[bone];
+					while (parent > -1 && tightened[parent] >= limit) parent = parents[parent];
+					if (parent > -1) {
+						tightened[parent]++;
+						done = false;
+						break;
+					}
+				}
+
+				for (int f = 0; f < frames; f++) {
+					Affine local = Affine::fromTRS(trialPositions[f], trialRotations[f], trialScales[f]);
+					compressed[f * bones + bone] = parents[bone] > -1 ? local * compressed[f * bones + parents[bone]] : local;
+				}
+			}
+		}
+
+		// Store the chosen forms
+		positions = CompressedChannel<Vec3>();
+		rotations = CompressedChannel<Quaternion>();
+		scales = CompressedChannel<Vec3>();
+		for (int bone = 0; bone < bones; bone++) {
+			list(rotations, bone, rotationFormats[bone], rotationConstants[bone]);
+			list(positions, bone, positionFormats[bone], positionConstants[bone]);
+			list(scales, bone, scaleFormats[bone], scaleConstants[bone]);
+			rotations.pose.push_back(rotationConstants[bone]);
+			positions.pose.push_back(positionConstants[bone]);
+			scales.pose.push_back(scaleFormats[bone] == TrackIdentity ? Vec3(1.f, 1.f, 1.f) : scaleConstants[bone]);
+		}
+		for (int bone : positions.quantizedBones) {
+			positions.rangeMin.push_back(positionMin[bone]);
+			positions.rangeExtent.push_back(positionExtent[bone]);
+		}
+		for (int bone : scales.quantizedBones) {
+			scales.rangeMin.push_back(scaleMin[bone]);
+			scales.rangeExtent.push_back(scaleExtent[bone]);
+		}
+		planeRanges(positions);
+		planeRanges(scales);
+		rotations.rawStride = ((int)rotations.rawBones.size() + 3) & ~3;
+		positions.rawStride = (int)positions.rawBones.size();
+		scales.rawStride = (int)scales.rawBones.size();
+		int quantizedRotationTracks = (int)rotations.quantizedBones.size();
+		rotations.quantizedStride = (quantizedRotationTracks + 3) & ~3;
+		rotations.quantizedKeys.assign(frames * rotations.quantizedStride * 3, 0);
+		for (int f = 0; f < frames; f++) {
+			unsigned short* frameKeys = rotations.quantizedKeys.data() + f * rotations.quantizedStride * 3;
+			for (int i = 0; i < quantizedRotationTracks; i++)
+				packRotation(keyRotations[f * bones + rotations.quantizedBones[i]], frameKeys + i, rotations.quantizedStride);
+			for (int bone : rotations.rawBones) rotations.rawKeys.push_back(keyRotations[f * bones + bone]);
+			rotations.rawKeys.resize((f + 1) * rotations.rawStride);
+			storeVec3(positions, keyPositions + f * bones);
+			storeVec3(scales, keyScales + f * bones);
+		}
+	}
+
+	// Local pose of every bone between frames baseFrame and next, decompressed from the keys of the two frames
+	void samplePose(int baseFrame, int next, float interpolationFact, Vec3* outPositions, Quaternion* outRotations, Vec3* outScales) const {
+		sampleRotations(baseFrame, next, interpolationFact, outRotations);
+		sampleVec3(positions, baseFrame, next, interpolationFact, outPositions);
+		sampleVec3(scales, baseFrame, next, interpolationFact, outScales);
+	}
+
+	// Rotations only: constants as they are, quantized tracks decoded and slerped a register of tracks at a time
+	// straight into the pose
+	void sampleRotations(int baseFrame, int next, float interpolationFact, Quaternion* outRotations) const {
+		memcpy(outRotations, rotations.pose.data(), boneCount * sizeof(Quaternion));
+		int quantized = (int)rotations.quantizedBones.size(), stride = rotations.quantizedStride;
+		const unsigned short* fromKeys = rotations.quantizedKeys.data() + baseFrame * stride * 3;
+		const unsigned short* toKeys = rotations.quantizedKeys.data() + next * stride * 3;
+		slerpPackedRotations(fromKeys, toKeys, stride, rotations.quantizedBones.data(), quantized, interpolationFact, outRotations);
+		int raw = (int)rotations.rawBones.size(), rawStride = rotations.rawStride;
+		const Quaternion* fromRaw = rotations.rawKeys.data() + baseFrame * rawStride;
+		const Quaternion* toRaw = rotations.rawKeys.data() + next * rawStride;
+		slerpRawRotations(fromRaw, toRaw, rotations.rawBones.data(), raw, interpolationFact, outRotations);
+	}
+
+	// One bone only (findWorldMatrix walks a single chain)
+	void sampleBone(int bone, int baseFrame, int next, float interpolationFact, Vec3& position, Quaternion& rotation, Vec3& scale) const {
+		Quaternion from, to;
+		int track = rotations.tracks[bone];
+		switch (rotations.formats[bone]) {
+			case TrackConstant: from = to = rotations.constants[track]; break;
+			case TrackQuantized: {
+				int stride = rotations.quantizedStride;
+				from = unpackRotation(&rotations.quantizedKeys[baseFrame * stride * 3 + track], stride);
+				to = unpackRotation(&rotations.quantizedKeys[next * stride * 3 + track], stride);
+				break;
+			}
+			default: {
+				int stride = rotations.rawStride;
+				from = rotations.rawKeys[baseFrame * stride + track];
+				to = rotations.rawKeys[next * stride + track];
+			}
+		}
+		interpolateQuaternions(&from, &to, &rotation, 1, interpolationFact);
+		position = sampleVec3(positions, bone, baseFrame, next, interpolationFact);
+		scale = sampleVec3(scales, bone, baseFrame, next, interpolationFact);
+	}
+
+	// Heap bytes held by the keys and track tables
+	size_t memoryBytes() const { return positions.memoryBytes() + rotations.memoryBytes() + scales.memoryBytes(); }
+
+private:
+	// Bones sorted so every parent comes before its children
+	static std::vector<int> parentsFirst(const int* parents, int bones) {
+		std::vector<int> depth(bones, 0), order(bones);
+		for (int bone = 0; bone < bones; bone++)
+			for (int parent = parents[bone]; parent > -1 && depth[bone] < bones; parent = parents[parent]) depth[bone]++;
+		for (int bone = 0; bone < bones; bone++) order[bone] = bone;
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return depth[a] < depth[b]; });
+		return order;
+	}
+
+	// Constant candidates (the rotation closest to all keys, the centres of the position and scale ranges) and
+	// quantization ranges of one bone
+	void fitRanges(const Quaternion* keyRotations, const Vec3* keyPositions, const Vec3* keyScales, int bone, Quaternion& rotation,
+		Vec3& position, Vec3& positionMin, Vec3& positionExtent, Vec3& scale, Vec3& scaleMin, Vec3& scaleExtent) const {
+		Quaternion sum;
+		Vec3 positionMax(-FLT_MAX, -FLT_MAX, -FLT_MAX), scaleMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		positionMin = Vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+		scaleMin = Vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+		const Quaternion& first = keyRotations[bone];
+		for (int f = 0; f < frameCount; f++) {
+			int key = f * boneCount + bone;
+			Quaternion q = Dot(keyRotations[key], first) < 0.f ? -keyRotations[key] : keyRotations[key];
+			for (int i = 0; i < 4; i++) sum.q[i] += q.q[i];
+			positionMin = Min(positionMin, keyPositions[key]);
+			positionMax = Max(positionMax, keyPositions[key]);
+			scaleMin = Min(scaleMin, keyScales[key]);
+			scaleMax = Max(scaleMax, keyScales[key]);
+		}
+		rotation = sum.magnitude() > 0.f ? sum.normalize() : first;
+		position = (positionMin + positionMax) * 0.5f;
+		positionExtent = positionMax - positionMin;
+		scale = (scaleMin + scaleMax) * 0.5f;
+		scaleExtent = scaleMax - scaleMin;
+	}
+
+	template<typename Value>
+	static void list(CompressedChannel<Value>& channel, int bone, int format, const Value& constant) {
+		channel.formats.push_back((unsigned char)format);
+		switch (format) {
+			case TrackConstant:
+				channel.tracks.push_back((int)channel.constantBones.size());
+				channel.constantBones.push_back(bone);
+				channel.constants.push_back(constant);
+				break;
+			case TrackIdentity:
+				channel.tracks.push_back((int)channel.identityBones.size());
+				channel.identityBones.push_back(bone);
+				break;
+			case TrackQuantized:
+				channel.tracks.push_back((int)channel.quantizedBones.size());
+				channel.quantizedBones.push_back(bone);
+				break;
+			default:
+				channel.tracks.push_back((int)channel.rawBones.size());
+				channel.rawBones.push_back(bone);
+		}
+	}
+
+	// Plane stride and range planes of the quantized tracks of a Vec3 channel, the padding lanes decode to 0
+	static void planeRanges(CompressedChannel<Vec3>& channel) {
+		int stride = ((int)channel.quantizedBones.size() + 3) & ~3;
+		channel.quantizedStride = stride;
+		channel.quantizedRanges.assign(stride * 6, 0.f);
+		for (size_t i = 0; i < channel.quantizedBones.size(); i++) {
+			for (int axis = 0; axis < 3; axis++) {
+				channel.quantizedRanges[axis * stride + i] = channel.rangeMin[i].v[axis];
+				channel.quantizedRanges[(axis + 3) * stride + i] = channel.rangeExtent[i].v[axis] * (1.f / 65535.f);
+			}
+		}
+	}
+
+	// Appends one frame of the animated tracks of a Vec3 channel
+	static void storeVec3(CompressedChannel<Vec3>& channel, const Vec3* frameKeys) {
+		int stride = channel.quantizedStride;
+		size_t frame = channel.quantizedKeys.size();
+		channel.quantizedKeys.resize(frame + stride * 3, 0);
+		for (size_t i = 0; i < channel.quantizedBones.size(); i++) {
+			unsigned short packed[3];
+			packVec3(frameKeys[channel.quantizedBones[i]], channel.rangeMin[i], channel.rangeExtent[i], packed);
+			for (int axis = 0; axis < 3; axis++) channel.quantizedKeys[frame + axis * stride + i] = packed[axis];
+		}
+		for (int bone : channel.rawBones) channel.rawKeys.push_back(frameKeys[bone]);
+	}
+
+	static void sampleVec3(const CompressedChannel<Vec3>& channel, int baseFrame, int next, float t, Vec3* out) {
+		memcpy(out, channel.pose.data(), channel.pose.size() * sizeof(Vec3));
+		int quantized = (int)channel.quantizedBones.size(), stride = channel.quantizedStride;
+		const unsigned short* fromKeys = channel.quantizedKeys.data() + baseFrame * stride * 3;
+		const unsigned short* toKeys = channel.quantizedKeys.data() + next * stride * 3;
+		lerpPackedVec3(fromKeys, toKeys, stride, channel.quantizedRanges.data(), channel.quantizedBones.data(), quantized, t, out);
+		int raw = (int)channel.rawBones.size();
+		const Vec3* fromRaw = channel.rawKeys.data() + baseFrame * channel.rawStride;
+		const Vec3* toRaw = channel.rawKeys.data() + next * channel.rawStride;
+		for (int i = 0; i < raw; i++) out[channel.rawBones[i]] = fromRaw[i] + (toRaw[i] - fromRaw[i]) * t;
+	}
+
+	static Vec3 sampleVec3(const CompressedChannel<Vec3>& channel, int bone, int baseFrame, int next, float t) {
+		int track = channel.tracks[bone];
+		switch (channel.formats[bone]) {
+			case TrackIdentity: return Vec3(1.f, 1.f, 1.f);
+			case TrackConstant: return channel.constants[track];
+			case TrackQuantized: {
+				int stride = channel.quantizedStride;
+				return lerpPackedVec3(&channel.quantizedKeys[baseFrame * stride * 3 + track], &channel.quantizedKeys[next * stride * 3 + track], stride, &channel.quantizedRanges[track], t);
+			}
+			default: {
+				int stride = channel.rawStride;
+				const Vec3& from = channel.rawKeys[baseFrame * stride + track];
+				const Vec3& to = channel.rawKeys[next * stride + track];
+				return from + (to - from) * t;
+			}
+		}
+	}
+};
\ No newline at end of file
@@ -35,6 +35,9 @@ public:
 		view = Matrix::lookAt(position, right, up, dir);
 	}
 
+	// Camera to world transform, the view matrix is rigid so this is a transpose rather than a full inverse
+	Matrix viewInverse() const { return Affine(view).inverseRigid().toMatrix(); }
+
 	// Set Camera
 	void setCamera(int _width, int _height, float _zFar, float _zNear, float _fovTheta = 90.f) {
 		width = _width;
@@ -50,14 +53,14 @@ public:
 
 	// Rotete up and dir/to vector about the right/from vector
 	void pitch(float angle) {
-		Matrix R = Matrix::rotateAxis(right, angle);
+		Matrix R = Matrix::rotateAxis<FastMath>(right, angle);
 		up = R.mulVec(up).normalize();
 		dir = R.mulVec(dir).normalize();
 	}
 
 	// Rotate the basis vectors about world y-axis
 	void rotateY(float angle) {
-		Matrix R = Matrix::rotateOnYAxis(angle);
+		Matrix R = Matrix::rotateOnYAxis<FastMath>(angle);
 		right = R.mulVec(right).normalize();
 		up = R.mulVec(up).normalize();
 		dir = R.mulVec(dir).normalize();
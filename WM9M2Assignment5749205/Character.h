@@ -6,6 +6,7 @@
 #include "Camera.h"
 #include "Collision.h"
 #include "Core.h"
+#include "HitboxRig.h"
 #include "MyMath.h"
 #include "Window.h"
 
@@ -47,11 +48,15 @@ private:
 	int totalAmmo{ 240 };
 	int health{ 100 };
 	int bulletDamage{ 50 };
+	int meleeDamage{ 100 };
 
 	float movementSpeed = 5.f;
 	float sprintSpeed = 10.f;
 	float positionX{ 0.f };
 	float positionY{ 0.f };
+	float meleeRange{ 2.f };
+	float meleeRadius{ 0.5f };
+	Vec3 forward{ 0.f, 0.f, 1.f };
 
 	bool carryGun = true;
 	bool toggleAlternateFire = false;
@@ -75,12 +80,14 @@ public:
 	void updateAnimation(float dt) { animationInstance.update(getAnimationByState(state), dt); }
 	void resetAnimationTime() { if (animationInstance.animationFinished() == true) animationInstance.resetAnimationTime(); }
 
-	void draw(Core* core, TextureManager* textures, PSOManager* psos, ShaderManager* shaders, Matrix& vp, Matrix& w) {
+	void draw(Core* core, TextureManager* textures, PSOManager* psos, ShaderManager* shaders, Matrix& vp, const Matrix& w) {
 		if (!isAlive) return;
 		animatedModel.draw(core, &animationInstance, textures, psos, shaders, vp, w);
 	}
 
-	void movePlayer(Camera* camera, Window* window, float dt) {
+	// Moves with the camera, when world is given the hitbox is swept against it and slides along whatever it hits
+	void movePlayer(Camera* camera, Window* window, float dt, const BVH* world = nullptr) {
+		Vec3 start = camera->position;
 		float speed = (window->keys[VK_SHIFT] == 1) ? sprintSpeed : movementSpeed;
 		State state = (window->keys[VK_SHIFT] == 1) ? Run : Walk;
 
@@ -108,8 +115,15 @@ public:
 			camera->strafe(speed * dt);
 			positionX += speed * dt;
 		}
+		if (world) {
+			BoundingSphere from = hitbox;
+			from.centre = start;
+			camera->position = slideSphere(from, camera->position - start, *world);
+			camera->position.y = 0.f;
+		}
 		camera->updateViewMatrix();
 		hitbox.centre = camera->position;
+		forward = camera->dir;
 	}
 
 	// Inspect Weapon
@@ -118,12 +132,22 @@ public:
 		if (carryGun) setAnimationState(Inspect);
 	}
 
-	// Perform Melee Attack (needs collision detection for damage)
-	void meleeAttack() {
+	// Perform Melee Attack, a sphere swept along the view direction, which is a capsule. Returns the capsule of target
+	// it touches or -1
+	int meleeAttack(const HitboxRig* target = nullptr) {
 		if (carryGun) setAnimationState(MeleeAttack);
-		if (animationInstance.animationFinished()) { setAnimationState(Idle); return; }
+		if (animationInstance.animationFinished()) { setAnimationState(Idle); return -1; }
+		if (!carryGun || target == nullptr) return -1;
+
+		Capsule swing;
+		swing.a = hitbox.centre;
+		swing.b = hitbox.centre + forward * meleeRange;
+		swing.radius = meleeRadius;
+		return target->overlap(swing);
 	}
 
+	int getMeleeDamage() const { return meleeDamage; }
+
 	// Putaway the carbine
 	void putawayWeapon() {
 		if (carryGun) {
@@ -162,9 +186,11 @@ public:
 	}
 
 	// Shoot Bullet (needs collision detection for damage)
-	void shoot() {
+	// Returns whether a bullet left the barrel, the caller casts it along the camera
+	bool shoot() {
 		State state;
-		if (bulletsInClip > 0) {
+		bool fired = bulletsInClip > 0;
+		if (fired) {
 			int deduceBullet = (toggleAlternateFire) ? 3 : 1;
 			state = (toggleAlternateFire) ? Fire : AlternateFire;
 			bulletsInClip -= std::max<int>(deduceBullet, bulletsInClip);
@@ -172,9 +198,12 @@ public:
 		} else {
 			setAnimationState(DryFire);
 		}
-		if (animationInstance.animationFinished()) { setAnimationState(Idle); return; }
+		if (animationInstance.animationFinished()) setAnimationState(Idle);
+		return fired;
 	}
 
+	int getBulletDamage() const { return bulletDamage; }
+
 	void takeDamage(int damage) {
 		if (!isAlive) return;
 		health -= damage;
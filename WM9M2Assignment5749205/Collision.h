@@ -1,5 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <cfloat>
+#include <future>
+#include <random>
+#include <thread>
+#include <vector>
+
 #include "MyMath.h"
 
 // Sphere
@@ -46,19 +53,167 @@ public:
 		min = Min(min, p);
 	}
 
-	// Slab Test for Ray-AABB Collision
-	bool rayAABB(const Ray& r, float& t) {
+	void extend(const AABB& box) {
+		max = Max(max, box.max);
+		min = Min(min, box.min);
+	}
+
+	Vec3 centre() const { return (min + max) * 0.5f; }
+
+	// Half the surface area (SAH costs only need the ratio between boxes), 0 for an empty box
+	float surfaceArea() const {
+		Vec3 d = max - min;
+		if (d.x < 0.f || d.y < 0.f || d.z < 0.f) return 0.f;
+		return d.x * d.y + d.y * d.z + d.z * d.x;
+	}
+
+	// Squared distance from p to the box, 0 inside
+	float distanceSquare(const Vec3& p) const {
+		Vec3 d = Max(Max(min - p, p - max), Vec3(0.f, 0.f, 0.f));
+		return d.lengthSquare();
+	}
+
+	// Transform to another space with the min/max-of-columns method (Arvo), each output axis takes the
+	// smaller/larger of matrix column * min and matrix column * max instead of extending by 8 corners
+	AABB transform(const Matrix& matrix) const {
+		AABB ret;
+#ifdef MYMATH_X86
+		__m128 c0 = _mm_loadu_ps(&matrix.m[0]);
+		__m128 c1 = _mm_loadu_ps(&matrix.m[4]);
+		__m128 c2 = _mm_loadu_ps(&matrix.m[8]);
+		__m128 c3 = _mm_loadu_ps(&matrix.m[12]);
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+		__m128 lo = c3, hi = c3;
+		__m128 a = _mm_mul_ps(c0, _mm_set1_ps(min.x)), b = _mm_mul_ps(c0, _mm_set1_ps(max.x));
+		lo = _mm_add_ps(lo, _mm_min_ps(a, b)); hi = _mm_add_ps(hi, _mm_max_ps(a, b));
+		a = _mm_mul_ps(c1, _mm_set1_ps(min.y)); b = _mm_mul_ps(c1, _mm_set1_ps(max.y));
+		lo = _mm_add_ps(lo, _mm_min_ps(a, b)); hi = _mm_add_ps(hi, _mm_max_ps(a, b));
+		a = _mm_mul_ps(c2, _mm_set1_ps(min.z)); b = _mm_mul_ps(c2, _mm_set1_ps(max.z));
+		lo = _mm_add_ps(lo, _mm_min_ps(a, b)); hi = _mm_add_ps(hi, _mm_max_ps(a, b));
+
+		alignas(16) float l[4], h[4];
+		_mm_store_ps(l, lo);
+		_mm_store_ps(h, hi);
+		ret.min = Vec3(l[0], l[1], l[2]);
+		ret.max = Vec3(h[0], h[1], h[2]);
+#else
+		for (int i = 0; i < 3; i++) {
+			ret.min.v[i] = ret.max.v[i] = matrix.m[i * 4 + 3];
+			for (int j = 0; j < 3; j++) {
+				float a = matrix.m[i * 4 + j] * min.v[j];
+				float b = matrix.m[i * 4 + j] * max.v[j];
+				ret.min.v[i] += std::min<float>(a, b);
+				ret.max.v[i] += std::max<float>(a, b);
+			}
+		}
+#endif
+		return ret;
+	}
+
+	// Slab Test for Ray-AABB Collision, clipped to [0, tMax] so boxes behind the ray miss. t is the entry distance
+	// (0 when the ray starts inside)
+	bool rayAABB(const Ray& r, float& t, float tMax = FLT_MAX) const { return rayBox(min, max, r, tMax, t); }
+
+	static bool rayBox(const Vec3& min, const Vec3& max, const Ray& r, float tMax, float& t) {
 		Vec3 s = (min - r.o) * r.invdir;
 		Vec3 l = (max - r.o) * r.invdir;
 		Vec3 s1 = Min(s, l);
 		Vec3 l1 = Max(s, l);
-		float ts = std::max<float>(s1.x, std::max<float>(s1.y, s1.z));
-		float tl = std::min<float>(l1.x, std::min<float>(l1.y, l1.z));
-		t = std::min<float>(ts, tl);
-		return (ts < tl);
+		float ts = std::max<float>(0.f, std::max<float>(s1.x, std::max<float>(s1.y, s1.z)));
+		float tl = std::min<float>(tMax, std::min<float>(l1.x, std::min<float>(l1.y, l1.z)));
+		t = ts;
+		return ts <= tl;
 	}
 };
 
+// Oriented Bounding Box
+// A local box carried by a world matrix as a centre, unit axes and half extents along them, so a rotated prop keeps a
+// tight fit where the AABB of its transformed corners grows with the rotation. Scale is folded into the extents, the
+// matrix is expected to be rotation, scale and translation only (no shear)
+class OBB {
+public:
+	Vec3 centre;
+	Vec3 axis[3];
+	Vec3 extent;
+	float radius;			// Bounding sphere radius around centre, the first and cheapest rejection
+
+	OBB() {}
+	OBB(const AABB& local, const Matrix& world) { initialize(local, world); }
+
+	// The same box, axis aligned
+	explicit OBB(const AABB& box) {
+		centre = box.centre();
+		axis[0] = Vec3(1.f, 0.f, 0.f);
+		axis[1] = Vec3(0.f, 1.f, 0.f);
+		axis[2] = Vec3(0.f, 0.f, 1.f);
+		extent = (box.max - box.min) * 0.5f;
+		radius = extent.length();
+	}
+
+	void initialize(const AABB& local, const Matrix& world) {
+		centre = world.mulPoint(local.centre());
+		Vec3 half = (local.max - local.min) * 0.5f;
+		for (int i = 0; i < 3; i++) {
+			Vec3 column(world.m[i], world.m[4 + i], world.m[8 + i]);
+			float scale = column.length();
+			axis[i] = Vec3(0.f, 0.f, 0.f);
+			if (scale > 0.f) axis[i] = column / scale;
+			else axis[i].v[i] = 1.f;
+			extent.v[i] = half.v[i] * scale;
+		}
+		radius = extent.length();
+	}
+
+	// Point in box space (coordinates along the axes, relative to centre)
+	Vec3 toLocal(const Vec3& p) const {
+		Vec3 d = p - centre;
+		return Vec3(Dot(d, axis[0]), Dot(d, axis[1]), Dot(d, axis[2]));
+	}
+
+	Vec3 closestPoint(const Vec3& p) const {
+		Vec3 q = Max(-extent, Min(toLocal(p), extent));
+		return centre + axis[0] * q.x + axis[1] * q.y + axis[2] * q.z;
+	}
+
+	// Enclosing world AABB (for broadphase structures that only take boxes)
+	AABB bounds() const {
+		Vec3 r;
+		for (int i = 0; i < 3; i++)
+			r.v[i] = fabsf(axis[0].v[i]) * extent.x + fabsf(axis[1].v[i]) * extent.y + fabsf(axis[2].v[i]) * extent.z;
+		AABB ret;
+		ret.min = centre - r;
+		ret.max = centre + r;
+		return ret;
+	}
+
+	// Slab test in box space, same t and clipping as AABB::rayAABB (the axes are orthonormal, so distances carry over).
+	// Rays missing the bounding sphere are rejected before the change of frame
+	bool rayOBB(const Ray& r, float& t, float tMax = FLT_MAX) const {
+		Vec3 m = r.o - centre;
+		float b = Dot(m, r.dir), c = m.lengthSquare() - radius * radius;
+		if (c > 0.f && (b > 0.f || b * b < Dot(r.dir, r.dir) * c)) return false;
+		Ray local(toLocal(r.o), Vec3(Dot(r.dir, axis[0]), Dot(r.dir, axis[1]), Dot(r.dir, axis[2])));
+		return AABB::rayBox(-extent, extent, local, tMax, t);
+	}
+};
+
+// Batched AABB Transforms
+// One box per matrix (e.g. per-instance bounds refresh)
+inline void transformAABBs(const AABB* local, const Matrix* worlds, AABB* out, int count) {
+	for (int i = 0; i < count; i++) out[i] = local[i].transform(worlds[i]);
+}
+
+// The same local box under many matrices (e.g. one model drawn with instancing)
+inline void transformAABBs(const AABB& local, const Matrix* worlds, AABB* out, int count) {
+	for (int i = 0; i < count; i++) out[i] = local.transform(worlds[i]);
+}
+
+// Oriented boxes of one local box under many matrices
+inline void transformOBBs(const AABB& local, const Matrix* worlds, OBB* out, int count) {
+	for (int i = 0; i < count; i++) out[i].initialize(local, worlds[i]);
+}
+
 static bool collisionAabbAabb(const AABB& object1, const AABB& object2) {
 	// Calculate Penetration Depths
 	float pdx = std::min<float>(object1.max.x, object2.max.x) - std::max<float>(object1.min.x, object2.min.x);
@@ -78,7 +233,56 @@ static bool collisionSphereAabb(const BoundingSphere& sphere, const AABB& aabb)
 	float py = std::max<float>(aabb.min.y, std::min<float>(sphere.centre.y, aabb.max.y));
 	float pz = std::max<float>(aabb.min.z, std::min<float>(sphere.centre.z, aabb.max.z));
 
-	return powf((sphere.centre.x - px) + (sphere.centre.y - py) + (sphere.centre.z - pz), 2.f) <= powf(sphere.radius, 2.f);
+	// Squared distance to it (each axis squared before summing)
+	float dx = sphere.centre.x - px, dy = sphere.centre.y - py, dz = sphere.centre.z - pz;
+	return dx * dx + dy * dy + dz * dz <= sphere.radius * sphere.radius;
+}
+
+// Separating Axis Test for OBB-OBB Collision (Ericson, Real-Time Collision Detection 4.4.1). The bounding spheres
+// reject most separated pairs first, then the six face axes, which find nearly every remaining separation, and the
+// nine edge-edge axes last. The epsilon on the absolute rotation stops near-parallel edges from producing a zero
+// cross product that would report a false separation
+inline bool collisionObbObb(const OBB& a, const OBB& b) {
+	Vec3 d = b.centre - a.centre;
+	float reach = a.radius + b.radius;
+	if (d.lengthSquare() > reach * reach) return false;
+
+	// Rotation of b in a's frame and the centre offset along a's axes
+	float R[3][3], absR[3][3];
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			R[i][j] = Dot(a.axis[i], b.axis[j]);
+			absR[i][j] = fabsf(R[i][j]) + 1e-6f;
+		}
+	}
+	float t[3] = { Dot(d, a.axis[0]), Dot(d, a.axis[1]), Dot(d, a.axis[2]) };
+	const float* ea = a.extent.v;
+	const float* eb = b.extent.v;
+
+	for (int i = 0; i < 3; i++) {
+		float rb = eb[0] * absR[i][0] + eb[1] * absR[i][1] + eb[2] * absR[i][2];
+		if (fabsf(t[i]) > ea[i] + rb) return false;
+	}
+	for (int j = 0; j < 3; j++) {
+		float ra = ea[0] * absR[0][j] + ea[1] * absR[1][j] + ea[2] * absR[2][j];
+		if (fabsf(t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j]) > ra + eb[j]) return false;
+	}
+	for (int i = 0; i < 3; i++) {
+		int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+		for (int j = 0; j < 3; j++) {
+			int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+			float ra = ea[i1] * absR[i2][j] + ea[i2] * absR[i1][j];
+			float rb = eb[j1] * absR[i][j2] + eb[j2] * absR[i][j1];
+			if (fabsf(t[i2] * R[i1][j] - t[i1] * R[i2][j]) > ra + rb) return false;
+		}
+	}
+	return true;
+}
+
+inline bool collisionSphereObb(const BoundingSphere& sphere, const OBB& obb) {
+	float reach = sphere.radius + obb.radius;
+	if ((sphere.centre - obb.centre).lengthSquare() > reach * reach) return false;
+	return (obb.closestPoint(sphere.centre) - sphere.centre).lengthSquare() <= sphere.radius * sphere.radius;
 }
 
 static bool collisionRaySphere(const BoundingSphere& sphere, const Ray& ray) {
@@ -91,4 +295,1672 @@ static bool collisionRaySphere(const BoundingSphere& sphere, const Ray& ray) {
 	float root1 = (-b + sqrtf(quadraticEquation)) / (2.f * a);  // Solution One
 	float root2 = (-b - sqrtf(quadraticEquation)) / (2.f * a);  // Solution Two
 	return true;
+}
+
+// SoA Box Packets
+// N boxes held as one Floatx4/Floatx8 per bound component, so one ray or sphere is tested against every lane with
+// the same arithmetic as the scalar AABB::rayBox and AABB::distanceSquare (lane masks match them exactly, apart
+// from rays lying exactly in a slab plane, where 0 * inf is NaN and the min/max instructions pick a side). Unused
+// lanes hold a box at +infinity, which nothing hits.
+template<typename Lanes, int N>
+class AABBPacket {
+public:
+	static const int width = N;
+
+	Lanes minX, minY, minZ;
+	Lanes maxX, maxY, maxZ;
+
+	AABBPacket() { load(nullptr, 0); }
+	AABBPacket(const AABB* boxes, int count = N) { load(boxes, count); }
+
+	// Transposes up to N boxes into the lanes
+	void load(const AABB* boxes, int count = N) {
+		float lanes[6][N];
+		for (int i = 0; i < N; i++) {
+			for (int a = 0; a < 3; a++) {
+				lanes[a][i] = i < count ? boxes[i].min.v[a] : INFINITY;
+				lanes[3 + a][i] = i < count ? boxes[i].max.v[a] : INFINITY;
+			}
+		}
+		minX = Lanes::load(lanes[0]); minY = Lanes::load(lanes[1]); minZ = Lanes::load(lanes[2]);
+		maxX = Lanes::load(lanes[3]); maxY = Lanes::load(lanes[4]); maxZ = Lanes::load(lanes[5]);
+	}
+
+	// Bit i set when box i is hit within [0, tMax], tEntry gets every lane's entry distance
+	int rayAABB(const Ray& r, float tMax, Lanes& tEntry) const {
+		Lanes ox(r.o.x), oy(r.o.y), oz(r.o.z);
+		Lanes ix(r.invdir.x), iy(r.invdir.y), iz(r.invdir.z);
+		Lanes sx = (minX - ox) * ix, lx = (maxX - ox) * ix;
+		Lanes sy = (minY - oy) * iy, ly = (maxY - oy) * iy;
+		Lanes sz = (minZ - oz) * iz, lz = (maxZ - oz) * iz;
+		Lanes ts = Max(Lanes(0.f), Max(Min(sx, lx), Max(Min(sy, ly), Min(sz, lz))));
+		Lanes tl = Min(Lanes(tMax), Min(Max(sx, lx), Min(Max(sy, ly), Max(sz, lz))));
+		tEntry = ts;
+		return (ts <= tl).mask();
+	}
+
+	int rayAABB(const Ray& r, float tMax = FLT_MAX) const {
+		Lanes tEntry;
+		return rayAABB(r, tMax, tEntry);
+	}
+
+	// Squared distance from p to every box, 0 inside
+	Lanes distanceSquare(const Vec3& p) const {
+		Lanes px(p.x), py(p.y), pz(p.z), zero(0.f);
+		Lanes dx = Max(Max(minX - px, px - maxX), zero);
+		Lanes dy = Max(Max(minY - py, py - maxY), zero);
+		Lanes dz = Max(Max(minZ - pz, pz - maxZ), zero);
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	// Bit i set when the sphere touches box i
+	int sphereAABB(const BoundingSphere& sphere) const {
+		return (distanceSquare(sphere.centre) <= Lanes(sphere.radius * sphere.radius)).mask();
+	}
+};
+
+typedef AABBPacket<Floatx4, 4> AABBx4;
+typedef AABBPacket<Floatx8, 8> AABBx8;
+
+// Packs boxes into packets of Packet::width, the last one padded with empty lanes
+template<typename Packet>
+static void packAABBs(const AABB* boxes, int count, std::vector<Packet>& packets) {
+	const int width = Packet::width;
+	packets.resize((count + width - 1) / width);
+	for (int i = 0; i < (int)packets.size(); i++) packets[i].load(boxes + i * width, std::min<int>(width, count - i * width));
+}
+
+// Bounding Volume Hierarchy
+// Static tree over world space boxes (e.g. the instanced trees) for ray, box and sphere queries in O(log n).
+// Built top down with binned SAH, subtrees above parallelThreshold boxes are built on other threads. Nodes are
+// flattened depth first into one array so the first child always follows its parent and only the second
+// child index is stored, leaf boxes are copied into leaf order so a leaf reads one contiguous run.
+class BVH {
+public:
+	// 32 bytes, two nodes per cache line
+	struct Node {
+		Vec3 min;
+		int first;			// Leaf: first box in primitives, interior: index of the second child
+		Vec3 max;
+		int count;			// Leaf: number of boxes, interior: 0
+	};
+
+	std::vector<Node> nodes;
+	std::vector<AABB> primitives;	// Boxes in leaf order
+	std::vector<int> indices;		// primitives[i] is boxes[indices[i]] of the build input
+
+	static const int binCount = 16;
+	static const int parallelThreshold = 4096;
+	static const int stackSize = 64;
+
+	// packetLeaves is for leaves tested as one SIMD packet (e.g. 8 triangles at once), where a leaf costs the same
+	// whatever it holds, so every node of up to maxLeafSize boxes becomes a leaf instead of asking the SAH
+	void build(const std::vector<AABB>& boxes, int maxLeafSize = 4, bool packetLeaves = false) {
+		build(boxes.empty() ? nullptr : &boxes[0], (int)boxes.size(), maxLeafSize, packetLeaves);
+	}
+
+	void build(const AABB* boxes, int count, int maxLeafSize = 4, bool packetLeaves = false) {
+		nodes.clear();
+		primitives.resize(count);
+		indices.resize(count);
+		if (count == 0) return;
+
+		// Boxes are partitioned in place together with their input index, so every build pass reads memory in order
+		std::vector<BuildPrimitive> work(count);
+		for (int i = 0; i < count; i++) {
+			work[i].bounds.set(boxes[i]);
+			work[i].index = i;
+		}
+
+		maxLeafSize = std::max<int>(1, maxLeafSize);
+		unsigned int threads = std::max<unsigned int>(1, std::thread::hardware_concurrency());
+		nodes.reserve(2 * count - 1);
+		buildNode(&work[0], maxLeafSize, packetLeaves, nodes, 0, count, 0, (int)threads);
+
+		for (int i = 0; i < count; i++) {
+			indices[i] = work[i].index;
+			primitives[i] = boxes[indices[i]];
+		}
+	}
+
+	// Nearest box hit within [0, tMax], index is the box's position in the build input
+	bool closestHit(const Ray& ray, int& index, float& t, float tMax = FLT_MAX) const {
+		index = -1;
+		float best = tMax;
+		traverseRay(ray, best, [&](int first, int count, float& limit) {
+			for (int i = first; i < first + count; i++) {
+				float tBox;
+				if (AABB::rayBox(primitives[i].min, primitives[i].max, ray, limit, tBox) && (index < 0 || tBox < limit)) {
+					limit = tBox;
+					index = indices[i];
+				}
+			}
+			return false;
+		});
+		t = best;
+		return index >= 0;
+	}
+
+	// Ray walk shared by the ray queries. Children are visited nearest first and subtrees entered beyond best are
+	// skipped. leaf(first, count, best) tests primitives [first, first + count) in leaf order, lowers best when it
+	// finds something closer and returns true to stop the walk (any hit queries)
+	template<typename Leaf>
+	void traverseRay(const Ray& ray, float& best, Leaf leaf) const {
+		float tNode;
+		if (nodes.empty() || !AABB::rayBox(nodes[0].min, nodes[0].max, ray, best, tNode)) return;
+
+		struct Entry { int node; float t; };
+		Entry stack[stackSize];
+		int top = 0;
+		int current = 0;
+		while (true) {
+			const Node& node = nodes[current];
+			if (node.count > 0) {
+				if (leaf(node.first, node.count, best)) return;
+			}
+			else {
+				int a = current + 1, b = node.first;
+				float ta, tb;
+				bool hitA = AABB::rayBox(nodes[a].min, nodes[a].max, ray, best, ta);
+				bool hitB = AABB::rayBox(nodes[b].min, nodes[b].max, ray, best, tb);
+				if (hitA && hitB) {
+					if (tb < ta) { std::swap(a, b); std::swap(ta, tb); }
+					stack[top++] = { b, tb };
+					current = a;
+					continue;
+				}
+				if (hitA || hitB) {
+					current = hitA ? a : b;
+					continue;
+				}
+			}
+
+			// Pop the next subtree that can still hold a closer hit
+			while (top > 0 && stack[top - 1].t > best) top--;
+			if (top == 0) break;
+			current = stack[--top].node;
+		}
+	}
+
+	// Whether any box is hit within [0, tMax] (line of sight), returns on the first hit
+	bool anyHit(const Ray& ray, float tMax = FLT_MAX) const {
+		if (nodes.empty()) return false;
+
+		int stack[stackSize];
+		int top = 0;
+		stack[top++] = 0;
+		while (top > 0) {
+			int current = stack[--top];
+			const Node& node = nodes[current];
+			float t;
+			if (!AABB::rayBox(node.min, node.max, ray, tMax, t)) continue;
+			if (node.count > 0) {
+				for (int i = node.first; i < node.first + node.count; i++)
+					if (AABB::rayBox(primitives[i].min, primitives[i].max, ray, tMax, t)) return true;
+			}
+			else {
+				stack[top++] = node.first;
+				stack[top++] = current + 1;
+			}
+		}
+		return false;
+	}
+
+	// Boxes overlapping box (same test as collisionAabbAabb), indices appended to out, returns how many were added
+	int queryAABB(const AABB& box, std::vector<int>& out) const {
+		size_t start = out.size();
+		visitAABB(box, [&](const AABB& primitive, int index) {
+			if (collisionAabbAabb(primitive, box)) out.push_back(index);
+		});
+		return (int)(out.size() - start);
+	}
+
+	// Calls visit(primitive box, input index) for every box in a leaf whose bounds touch box
+	template<typename Visitor>
+	void visitAABB(const AABB& box, Visitor visit) const {
+		if (nodes.empty()) return;
+
+		int stack[stackSize];
+		int top = 0;
+		stack[top++] = 0;
+		while (top > 0) {
+			int current = stack[--top];
+			const Node& node = nodes[current];
+			if (node.min.x > box.max.x || node.max.x < box.min.x ||
+				node.min.y > box.max.y || node.max.y < box.min.y ||
+				node.min.z > box.max.z || node.max.z < box.min.z) continue;
+			if (node.count > 0) {
+				for (int i = node.first; i < node.first + node.count; i++) visit(primitives[i], indices[i]);
+			}
+			else {
+				stack[top++] = node.first;
+				stack[top++] = current + 1;
+			}
+		}
+	}
+
+	// Boxes touching sphere, indices appended to out, returns how many were added
+	int querySphere(const BoundingSphere& sphere, std::vector<int>& out) const {
+		size_t start = out.size();
+		if (nodes.empty()) return 0;
+
+		float radiusSquare = sphere.radius * sphere.radius;
+		int stack[stackSize];
+		int top = 0;
+		stack[top++] = 0;
+		while (top > 0) {
+			int current = stack[--top];
+			const Node& node = nodes[current];
+			Vec3 d = Max(Max(node.min - sphere.centre, sphere.centre - node.max), Vec3(0.f, 0.f, 0.f));
+			if (d.lengthSquare() > radiusSquare) continue;
+			if (node.count > 0) {
+				for (int i = node.first; i < node.first + node.count; i++)
+					if (primitives[i].distanceSquare(sphere.centre) <= radiusSquare) out.push_back(indices[i]);
+			}
+			else {
+				stack[top++] = node.first;
+				stack[top++] = current + 1;
+			}
+		}
+		return (int)(out.size() - start);
+	}
+
+private:
+	// Build time box padded to four floats a side, the loops over k compile to packed min/max/add
+	struct alignas(16) Bounds {
+		float min[4];
+		float max[4];
+
+		Bounds() {
+			for (int k = 0; k < 4; k++) {
+				min[k] = FLT_MAX;
+				max[k] = -FLT_MAX;
+			}
+		}
+
+		void set(const AABB& box) {
+			for (int k = 0; k < 3; k++) {
+				min[k] = box.min.v[k];
+				max[k] = box.max.v[k];
+			}
+			min[3] = max[3] = 0.f;
+		}
+
+		void extend(const Bounds& b) {
+			for (int k = 0; k < 4; k++) {
+				min[k] = b.min[k] < min[k] ? b.min[k] : min[k];
+				max[k] = b.max[k] > max[k] ? b.max[k] : max[k];
+			}
+		}
+
+		// Extends by the centre of b, kept doubled (min + max) since only its relative position matters
+		void extendCentre(const Bounds& b) {
+			for (int k = 0; k < 4; k++) {
+				float c = b.min[k] + b.max[k];
+				min[k] = c < min[k] ? c : min[k];
+				max[k] = c > max[k] ? c : max[k];
+			}
+		}
+
+		float surfaceArea() const {
+			float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+			if (dx < 0.f || dy < 0.f || dz < 0.f) return 0.f;
+			return dx * dy + dy * dz + dz * dx;
+		}
+	};
+
+	struct BuildPrimitive {
+		Bounds bounds;
+		int index;
+	};
+
+	struct Bin {
+		Bounds bounds;
+		int count = 0;
+	};
+
+	// SAH splits stop at this depth and fall back to median splits, which keeps the tree within stackSize
+	static const int maxSahDepth = 32;
+
+	// Builds the subtree over work[begin, end) into out, child indices are relative to out
+	static void buildNode(BuildPrimitive* work, int maxLeafSize, bool packetLeaves, std::vector<Node>& out, int begin, int end, int depth, int threads) {
+		int nodeIndex = (int)out.size();
+		out.push_back(Node());
+
+		Bounds bounds, centroidBounds;
+		for (int i = begin; i < end; i++) {
+			bounds.extend(work[i].bounds);
+			centroidBounds.extendCentre(work[i].bounds);
+		}
+		out[nodeIndex].min = Vec3(bounds.min[0], bounds.min[1], bounds.min[2]);
+		out[nodeIndex].max = Vec3(bounds.max[0], bounds.max[1], bounds.max[2]);
+
+		int count = end - begin;
+		int mid = begin + count / 2;
+		int axis = 0;
+		int splitBin = -1, splitBins = binCount;
+		float extent[3];
+		for (int a = 0; a < 3; a++) extent[a] = centroidBounds.max[a] - centroidBounds.min[a];
+		if (extent[1] > extent[axis]) axis = 1;
+		if (extent[2] > extent[axis]) axis = 2;
+
+		if (count > 1 && depth < maxSahDepth && !(packetLeaves && count <= maxLeafSize)) {
+			// Bin the centroids on all three axes in one pass, then sweep each axis for the cheapest split. Small
+			// nodes use fewer bins, the fixed cost of the bins would otherwise dominate the lower levels
+			int binsUsed = 2 + count / 2;
+			if (binsUsed > binCount) binsUsed = binCount;
+			Bin bins[3][binCount];
+			float scale[3];
+			for (int a = 0; a < 3; a++) scale[a] = extent[a] > 0.f ? binsUsed / extent[a] : 0.f;
+			for (int i = begin; i < end; i++) {
+				const Bounds& b = work[i].bounds;
+				for (int a = 0; a < 3; a++) {
+					Bin& bin = bins[a][binIndex(b.min[a] + b.max[a], centroidBounds.min[a], scale[a], binsUsed)];
+					bin.bounds.extend(work[i].bounds);
+					bin.count++;
+				}
+			}
+
+			float bestCost = FLT_MAX;
+			for (int a = 0; a < 3; a++) {
+				if (extent[a] <= 0.f) continue;
+
+				float rightArea[binCount];
+				int rightCount[binCount];
+				Bounds right;
+				int n = 0;
+				for (int b = binsUsed - 1; b > 0; b--) {
+					right.extend(bins[a][b].bounds);
+					n += bins[a][b].count;
+					rightArea[b] = right.surfaceArea();
+					rightCount[b] = n;
+				}
+
+				Bounds left;
+				n = 0;
+				for (int b = 1; b < binsUsed; b++) {
+					left.extend(bins[a][b - 1].bounds);
+					n += bins[a][b - 1].count;
+					if (n == 0 || rightCount[b] == 0) continue;
+					float cost = left.surfaceArea() * n + rightArea[b] * rightCount[b];
+					if (cost < bestCost) {
+						bestCost = cost;
+						axis = a;
+						splitBin = b;
+						splitBins = binsUsed;
+					}
+				}
+			}
+
+			// Cost of the split relative to testing every box here, visiting the node tests both child boxes
+			float area = bounds.surfaceArea();
+			float splitCost = area > 0.f ? 2.f + bestCost / area : FLT_MAX;
+			if (count <= maxLeafSize && (splitBin < 0 || splitCost >= (float)count)) {
+				makeLeaf(out[nodeIndex], begin, count);
+				return;
+			}
+		}
+		else if (count <= maxLeafSize) {
+			makeLeaf(out[nodeIndex], begin, count);
+			return;
+		}
+
+		if (splitBin >= 0) {
+			float scale = splitBins / extent[axis];
+			float origin = centroidBounds.min[axis];
+			mid = (int)(std::partition(work + begin, work + end, [&](const BuildPrimitive& p) {
+				return binIndex(p.bounds.min[axis] + p.bounds.max[axis], origin, scale, splitBins) < splitBin;
+			}) - work);
+		}
+		else if (extent[axis] > 0.f) {
+			// Too deep for SAH (or no SAH split): object median on the widest centroid axis
+			std::nth_element(work + begin, work + mid, work + end, [&](const BuildPrimitive& p, const BuildPrimitive& q) {
+				return p.bounds.min[axis] + p.bounds.max[axis] < q.bounds.min[axis] + q.bounds.max[axis];
+			});
+		}
+		// Otherwise every centroid is the same point and the range is simply halved
+
+		if (threads > 1 && count >= parallelThreshold) {
+			// First child on another thread into its own array, then both are appended with their indices offset
+			int half = threads / 2;
+			std::vector<Node> left, right;
+			std::future<void> task = std::async(std::launch::async, [&] { buildNode(work, maxLeafSize, packetLeaves, left, begin, mid, depth + 1, half); });
+			buildNode(work, maxLeafSize, packetLeaves, right, mid, end, depth + 1, threads - half);
+			task.get();
+
+			appendSubtree(out, left);
+			out[nodeIndex].first = (int)out.size();
+			appendSubtree(out, right);
+		}
+		else {
+			buildNode(work, maxLeafSize, packetLeaves, out, begin, mid, depth + 1, threads);
+			out[nodeIndex].first = (int)out.size();
+			buildNode(work, maxLeafSize, packetLeaves, out, mid, end, depth + 1, threads);
+		}
+		out[nodeIndex].count = 0;
+	}
+
+	static int binIndex(float centroid, float origin, float scale, int bins) {
+		return std::min<int>(bins - 1, (int)((centroid - origin) * scale));
+	}
+
+	static void makeLeaf(Node& node, int first, int count) {
+		node.first = first;
+		node.count = count;
+	}
+
+	static void appendSubtree(std::vector<Node>& out, const std::vector<Node>& subtree) {
+		int offset = (int)out.size();
+		for (const Node& node : subtree) {
+			out.push_back(node);
+			if (node.count == 0) out.back().first += offset;
+		}
+	}
+};
+
+// Spatial Hash Broadphase
+// Uniform grid for moving colliders (NPCs, bullets, players). Cells are hashed into a power of two bucket table
+// that doubles as objects are added, every collider is listed in each cell its box touches. A move that stays in
+// the same cells only updates the stored shape, so insert, move and remove are O(1) for colliders no larger than
+// a cell. Pairs and queries are reported once: only from the first cell (lowest x, y, z) both sides share.
+enum ColliderType {
+	ColliderSphere,
+	ColliderAABB
+};
+
+class SpatialHash {
+public:
+	struct Pair {
+		int a, b;				// a < b
+	};
+
+	struct Collider {
+		AABB bounds;
+		BoundingSphere sphere;	// Only used for ColliderSphere
+		ColliderType type;
+		unsigned int layer;		// Layers this collider is on
+		unsigned int mask;		// Layers it collides with
+		int cellMin[3];
+		int cellMax[3];
+		bool active;
+	};
+
+	float cellSize;
+	std::vector<Collider> colliders;	// Indexed by id, removed slots are reused
+
+	SpatialHash(float _cellSize = 4.f, int _bucketCount = 1024) { initialize(_cellSize, _bucketCount); }
+
+	// Cell size should be around the diameter of a typical collider
+	void initialize(float _cellSize, int _bucketCount) {
+		cellSize = _cellSize;
+		invCellSize = 1.f / _cellSize;
+		int count = 1;
+		while (count < _bucketCount) count <<= 1;
+		buckets.assign(count, std::vector<Entry>());
+		colliders.clear();
+		freeIds.clear();
+		entryCount = 0;
+	}
+
+	int insert(const BoundingSphere& sphere, unsigned int layer = 1, unsigned int mask = ~0u) {
+		Collider collider;
+		collider.sphere = sphere;
+		collider.type = ColliderSphere;
+		sphereBounds(sphere, collider.bounds);
+		return insert(collider, layer, mask);
+	}
+
+	int insert(const AABB& box, unsigned int layer = 1, unsigned int mask = ~0u) {
+		Collider collider;
+		collider.bounds = box;
+		collider.sphere.centre = box.centre();
+		collider.sphere.radius = 0.f;
+		collider.type = ColliderAABB;
+		return insert(collider, layer, mask);
+	}
+
+	// Moving a removed id does nothing
+	void move(int id, const BoundingSphere& sphere) {
+		Collider& collider = colliders[id];
+		if (!collider.active) return;
+		collider.sphere = sphere;
+		AABB bounds;
+		sphereBounds(sphere, bounds);
+		move(id, bounds);
+	}
+
+	void move(int id, const AABB& box) {
+		Collider& collider = colliders[id];
+		if (!collider.active) return;
+		collider.bounds = box;
+		if (collider.type == ColliderAABB) collider.sphere.centre = box.centre();
+
+		int cellMin[3], cellMax[3];
+		cellRange(box, cellMin, cellMax);
+		if (cellMin[0] == collider.cellMin[0] && cellMin[1] == collider.cellMin[1] && cellMin[2] == collider.cellMin[2] &&
+			cellMax[0] == collider.cellMax[0] && cellMax[1] == collider.cellMax[1] && cellMax[2] == collider.cellMax[2]) return;
+
+		unlink(id);
+		for (int a = 0; a < 3; a++) {
+			collider.cellMin[a] = cellMin[a];
+			collider.cellMax[a] = cellMax[a];
+		}
+		link(id);
+	}
+
+	void remove(int id) {
+		if (!colliders[id].active) return;
+		unlink(id);
+		colliders[id].active = false;
+		freeIds.push_back(id);
+	}
+
+	void setLayers(int id, unsigned int layer, unsigned int mask) {
+		colliders[id].layer = layer;
+		colliders[id].mask = mask;
+	}
+
+	// Colliders on any of the mask layers within radius of centre (touching their shape), ids appended to out
+	int queryRadius(const Vec3& centre, float radius, std::vector<int>& out, unsigned int mask = ~0u) const {
+		Collider query;
+		query.sphere.centre = centre;
+		query.sphere.radius = radius;
+		query.type = ColliderSphere;
+		sphereBounds(query.sphere, query.bounds);
+		return queryCollider(query, mask, out);
+	}
+
+	// Colliders on any of the mask layers overlapping box, ids appended to out
+	int queryAABB(const AABB& box, std::vector<int>& out, unsigned int mask = ~0u) const {
+		Collider query;
+		query.bounds = box;
+		query.type = ColliderAABB;
+		return queryCollider(query, mask, out);
+	}
+
+	// Every overlapping pair whose layers and masks accept each other, each pair once
+	void computePairs(std::vector<Pair>& pairs) const {
+		pairs.clear();
+		for (const std::vector<Entry>& bucket : buckets) {
+			int size = (int)bucket.size();
+			for (int i = 0; i < size; i++) {
+				const Entry& e = bucket[i];
+				const Collider& a = colliders[e.id];
+				for (int j = i + 1; j < size; j++) {
+					const Entry& f = bucket[j];
+					// Different cells hashed to the same bucket, or a pair already reported from an earlier shared cell
+					if (e.cell[0] != f.cell[0] || e.cell[1] != f.cell[1] || e.cell[2] != f.cell[2]) continue;
+					const Collider& b = colliders[f.id];
+					if (!(a.layer & b.mask) || !(b.layer & a.mask)) continue;
+					if (!firstSharedCell(a, b, e.cell)) continue;
+					if (!overlaps(a, b)) continue;
+					Pair pair = { std::min<int>(e.id, f.id), std::max<int>(e.id, f.id) };
+					pairs.push_back(pair);
+				}
+			}
+		}
+	}
+
+	static bool overlaps(const Collider& a, const Collider& b) {
+		if (a.type == ColliderSphere && b.type == ColliderSphere) {
+			float r = a.sphere.radius + b.sphere.radius;
+			return (a.sphere.centre - b.sphere.centre).lengthSquare() <= r * r;
+		}
+		if (a.type == ColliderSphere) return b.bounds.distanceSquare(a.sphere.centre) <= a.sphere.radius * a.sphere.radius;
+		if (b.type == ColliderSphere) return a.bounds.distanceSquare(b.sphere.centre) <= b.sphere.radius * b.sphere.radius;
+		return collisionAabbAabb(a.bounds, b.bounds);
+	}
+
+private:
+	struct Entry {
+		int id;
+		int cell[3];
+	};
+
+	float invCellSize;
+	std::vector<std::vector<Entry>> buckets;
+	std::vector<int> freeIds;
+	int entryCount;
+
+	int insert(Collider& collider, unsigned int layer, unsigned int mask) {
+		collider.layer = layer;
+		collider.mask = mask;
+		collider.active = true;
+		cellRange(collider.bounds, collider.cellMin, collider.cellMax);
+
+		int id;
+		if (!freeIds.empty()) {
+			id = freeIds.back();
+			freeIds.pop_back();
+			colliders[id] = collider;
+		}
+		else {
+			id = (int)colliders.size();
+			colliders.push_back(collider);
+		}
+		link(id);
+		if (entryCount > 2 * (int)buckets.size()) rehash((int)buckets.size() * 2);
+		return id;
+	}
+
+	static void sphereBounds(const BoundingSphere& sphere, AABB& bounds) {
+		Vec3 r(sphere.radius, sphere.radius, sphere.radius);
+		bounds.min = sphere.centre - r;
+		bounds.max = sphere.centre + r;
+	}
+
+	void cellRange(const AABB& box, int* cellMin, int* cellMax) const {
+		for (int a = 0; a < 3; a++) {
+			cellMin[a] = (int)floorf(box.min.v[a] * invCellSize);
+			cellMax[a] = (int)floorf(box.max.v[a] * invCellSize);
+		}
+	}
+
+	int bucketIndex(int x, int y, int z) const {
+		unsigned int h = ((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u) ^ ((unsigned int)z * 83492791u);
+		return (int)(h & (unsigned int)(buckets.size() - 1));
+	}
+
+	void link(int id) {
+		const Collider& collider = colliders[id];
+		for (int x = collider.cellMin[0]; x <= collider.cellMax[0]; x++)
+			for (int y = collider.cellMin[1]; y <= collider.cellMax[1]; y++)
+				for (int z = collider.cellMin[2]; z <= collider.cellMax[2]; z++) {
+					Entry entry = { id, { x, y, z } };
+					buckets[bucketIndex(x, y, z)].push_back(entry);
+					entryCount++;
+				}
+	}
+
+	// Swap-removes the collider from each of its cells, buckets stay short so the search is O(1) on average
+	void unlink(int id) {
+		const Collider& collider = colliders[id];
+		for (int x = collider.cellMin[0]; x <= collider.cellMax[0]; x++)
+			for (int y = collider.cellMin[1]; y <= collider.cellMax[1]; y++)
+				for (int z = collider.cellMin[2]; z <= collider.cellMax[2]; z++) {
+					std::vector<Entry>& bucket = buckets[bucketIndex(x, y, z)];
+					for (size_t i = 0; i < bucket.size(); i++) {
+						if (bucket[i].id == id && bucket[i].cell[0] == x && bucket[i].cell[1] == y && bucket[i].cell[2] == z) {
+							bucket[i] = bucket.back();
+							bucket.pop_back();
+							entryCount--;
+							break;
+						}
+					}
+				}
+	}
+
+	void rehash(int bucketCount) {
+		buckets.assign(bucketCount, std::vector<Entry>());
+		entryCount = 0;
+		for (int id = 0; id < (int)colliders.size(); id++)
+			if (colliders[id].active) link(id);
+	}
+
+	// Whether cell is the lowest cell inside both cell ranges, the one cell a shared pair is reported from
+	static bool firstSharedCell(const Collider& a, const Collider& b, const int* cell) {
+		for (int k = 0; k < 3; k++)
+			if (cell[k] != std::max<int>(a.cellMin[k], b.cellMin[k])) return false;
+		return true;
+	}
+
+	int queryCollider(Collider& query, unsigned int mask, std::vector<int>& out) const {
+		size_t start = out.size();
+		cellRange(query.bounds, query.cellMin, query.cellMax);
+		for (int x = query.cellMin[0]; x <= query.cellMax[0]; x++)
+			for (int y = query.cellMin[1]; y <= query.cellMax[1]; y++)
+				for (int z = query.cellMin[2]; z <= query.cellMax[2]; z++) {
+					int cell[3] = { x, y, z };
+					for (const Entry& e : buckets[bucketIndex(x, y, z)]) {
+						if (e.cell[0] != x || e.cell[1] != y || e.cell[2] != z) continue;
+						const Collider& collider = colliders[e.id];
+						if (!(collider.layer & mask)) continue;
+						if (!firstSharedCell(collider, query, cell)) continue;
+						if (overlaps(collider, query)) out.push_back(e.id);
+					}
+				}
+		return (int)(out.size() - start);
+	}
+};
+
+// Dynamic AABB Tree
+// Incremental bounding volume tree for colliders that move every frame (hitboxes, projectiles). Each leaf keeps a
+// fat box (the collider's box grown by margin and stretched along its last displacement), a move only reinserts the
+// leaf once the collider leaves it. Inserts descend towards the sibling with the least surface area growth and the
+// path back up is refitted and rebalanced with AVL style rotations, so the height stays O(log n).
+class DynamicAABBTree {
+public:
+	static const int nullNode = -1;
+
+	struct Node {
+		AABB bounds;			// Leaves: fat box, interior: union of the children
+		AABB box;				// Leaves: the collider's own box
+		int parent;				// Next free node while unused
+		int child1;				// nullNode for leaves
+		int child2;
+		int height;				// Leaves 0, unused nodes -1
+		int userData;
+
+		bool isLeaf() const { return child1 == nullNode; }
+	};
+
+	struct Pair {
+		int a, b;				// Proxy ids, a < b
+	};
+
+	std::vector<Node> nodes;	// Proxy ids are the indices of their leaves
+	int root;
+	float margin;
+
+	// Fat boxes stretch this many times the displacement passed to move, ahead of the collider
+	static const int displacementMultiplier = 4;
+
+	// AVL balance keeps the height within 1.44 log2(n), far below this
+	static const int stackSize = 256;
+
+	DynamicAABBTree(float _margin = 0.1f) { initialize(_margin); }
+
+	void initialize(float _margin) {
+		margin = _margin;
+		nodes.clear();
+		root = nullNode;
+		freeList = nullNode;
+	}
+
+	int insert(const AABB& box, int userData = 0) {
+		int proxy = allocateNode();
+		Node& leaf = nodes[proxy];
+		leaf.box = box;
+		leaf.bounds = box;
+		grow(leaf.bounds, margin);
+		leaf.userData = userData;
+		leaf.height = 0;
+		insertLeaf(proxy);
+		return proxy;
+	}
+
+	int insert(const BoundingSphere& sphere, int userData = 0) { return insert(sphereBox(sphere), userData); }
+
+	void remove(int proxy) {
+		removeLeaf(proxy);
+		freeNode(proxy);
+	}
+
+	// Updates the collider's box, returns true when the leaf had to be reinserted. displacement is the movement
+	// expected by the next update (velocity * dt), the fat box is stretched in that direction
+	bool move(int proxy, const AABB& box, const Vec3& displacement = Vec3(0.f, 0.f, 0.f)) {
+		Node& leaf = nodes[proxy];
+		leaf.box = box;
+
+		AABB fat = box;
+		grow(fat, margin);
+		for (int a = 0; a < 3; a++) {
+			float d = displacement.v[a] * displacementMultiplier;
+			if (d < 0.f) fat.min.v[a] += d;
+			else fat.max.v[a] += d;
+		}
+
+		if (contains(leaf.bounds, box)) {
+			// Still inside, unless a fast move left the fat box far larger than the current one needs
+			AABB limit = fat;
+			grow(limit, 4.f * margin);
+			if (contains(limit, leaf.bounds)) return false;
+		}
+
+		removeLeaf(proxy);
+		nodes[proxy].bounds = fat;
+		insertLeaf(proxy);
+		return true;
+	}
+
+	bool move(int proxy, const BoundingSphere& sphere, const Vec3& displacement = Vec3(0.f, 0.f, 0.f)) {
+		return move(proxy, sphereBox(sphere), displacement);
+	}
+
+	int height() const { return root == nullNode ? 0 : nodes[root].height; }
+
+	// Proxies whose boxes overlap box (same test as collisionAabbAabb), appended to out
+	int queryAABB(const AABB& box, std::vector<int>& out) const {
+		size_t start = out.size();
+		int stack[stackSize];
+		int top = 0;
+		if (root != nullNode) stack[top++] = root;
+		while (top > 0) {
+			int index = stack[--top];
+			const Node& node = nodes[index];
+			if (!touches(node.bounds, box)) continue;
+			if (node.isLeaf()) {
+				if (collisionAabbAabb(node.box, box)) out.push_back(index);
+			}
+			else {
+				stack[top++] = node.child1;
+				stack[top++] = node.child2;
+			}
+		}
+		return (int)(out.size() - start);
+	}
+
+	// Proxies whose boxes touch sphere, appended to out
+	int querySphere(const BoundingSphere& sphere, std::vector<int>& out) const {
+		size_t start = out.size();
+		float radiusSquare = sphere.radius * sphere.radius;
+		int stack[stackSize];
+		int top = 0;
+		if (root != nullNode) stack[top++] = root;
+		while (top > 0) {
+			int index = stack[--top];
+			const Node& node = nodes[index];
+			if (node.bounds.distanceSquare(sphere.centre) > radiusSquare) continue;
+			if (node.isLeaf()) {
+				if (node.box.distanceSquare(sphere.centre) <= radiusSquare) out.push_back(index);
+			}
+			else {
+				stack[top++] = node.child1;
+				stack[top++] = node.child2;
+			}
+		}
+		return (int)(out.size() - start);
+	}
+
+	// Nearest proxy box hit within [0, tMax]
+	bool closestHit(const Ray& ray, int& proxy, float& t, float tMax = FLT_MAX) const {
+		proxy = nullNode;
+		float best = tMax;
+		int stack[stackSize];
+		int top = 0;
+		if (root != nullNode) stack[top++] = root;
+		while (top > 0) {
+			int index = stack[--top];
+			const Node& node = nodes[index];
+			float tNode;
+			if (!AABB::rayBox(node.bounds.min, node.bounds.max, ray, best, tNode)) continue;
+			if (node.isLeaf()) {
+				if (AABB::rayBox(node.box.min, node.box.max, ray, best, tNode) && (proxy == nullNode || tNode < best)) {
+					best = tNode;
+					proxy = index;
+				}
+			}
+			else {
+				stack[top++] = node.child1;
+				stack[top++] = node.child2;
+			}
+		}
+		t = best;
+		return proxy != nullNode;
+	}
+
+	// Whether any proxy box is hit within [0, tMax], returns on the first hit
+	bool anyHit(const Ray& ray, float tMax = FLT_MAX) const {
+		int stack[stackSize];
+		int top = 0;
+		if (root != nullNode) stack[top++] = root;
+		while (top > 0) {
+			const Node& node = nodes[stack[--top]];
+			float t;
+			if (!AABB::rayBox(node.bounds.min, node.bounds.max, ray, tMax, t)) continue;
+			if (node.isLeaf()) {
+				if (AABB::rayBox(node.box.min, node.box.max, ray, tMax, t)) return true;
+			}
+			else {
+				stack[top++] = node.child1;
+				stack[top++] = node.child2;
+			}
+		}
+		return false;
+	}
+
+	// Every pair of proxies whose boxes overlap, each pair once. The tree is descended against itself: a node is
+	// paired with itself (its two children against each other) and node pairs whose fat boxes miss are dropped whole
+	void computePairs(std::vector<Pair>& pairs) {
+		pairs.clear();
+		if (root == nullNode) return;
+
+		pairStack.clear();
+		pairStack.push_back({ root, root });
+		while (!pairStack.empty()) {
+			Pair p = pairStack.back();
+			pairStack.pop_back();
+			const Node& a = nodes[p.a];
+			if (p.a == p.b) {
+				if (a.isLeaf()) continue;
+				pairStack.push_back({ a.child1, a.child1 });
+				pairStack.push_back({ a.child2, a.child2 });
+				pairStack.push_back({ a.child1, a.child2 });
+				continue;
+			}
+
+			const Node& b = nodes[p.b];
+			if (!touches(a.bounds, b.bounds)) continue;
+			if (a.isLeaf() && b.isLeaf()) {
+				if (collisionAabbAabb(a.box, b.box)) {
+					Pair pair = { std::min<int>(p.a, p.b), std::max<int>(p.a, p.b) };
+					pairs.push_back(pair);
+				}
+			}
+			else if (b.isLeaf() || (!a.isLeaf() && a.bounds.surfaceArea() >= b.bounds.surfaceArea())) {
+				pairStack.push_back({ a.child1, p.b });
+				pairStack.push_back({ a.child2, p.b });
+			}
+			else {
+				pairStack.push_back({ p.a, b.child1 });
+				pairStack.push_back({ p.a, b.child2 });
+			}
+		}
+	}
+
+private:
+	int freeList;
+	std::vector<Pair> pairStack;
+
+	static AABB sphereBox(const BoundingSphere& sphere) {
+		AABB box;
+		Vec3 r(sphere.radius, sphere.radius, sphere.radius);
+		box.min = sphere.centre - r;
+		box.max = sphere.centre + r;
+		return box;
+	}
+
+	static void grow(AABB& box, float amount) {
+		Vec3 r(amount, amount, amount);
+		box.min = box.min - r;
+		box.max = box.max + r;
+	}
+
+	static AABB combine(const AABB& a, const AABB& b) {
+		AABB box;
+		box.min = Min(a.min, b.min);
+		box.max = Max(a.max, b.max);
+		return box;
+	}
+
+	static bool contains(const AABB& outer, const AABB& inner) {
+		return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+			inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+	}
+
+	// Closed overlap test for fat boxes, so touching colliders are never culled before the exact test
+	static bool touches(const AABB& a, const AABB& b) {
+		return a.min.x <= b.max.x && b.min.x <= a.max.x && a.min.y <= b.max.y && b.min.y <= a.max.y &&
+			a.min.z <= b.max.z && b.min.z <= a.max.z;
+	}
+
+	int allocateNode() {
+		int index;
+		if (freeList == nullNode) {
+			index = (int)nodes.size();
+			nodes.push_back(Node());
+		}
+		else {
+			index = freeList;
+			freeList = nodes[index].parent;
+		}
+		Node& node = nodes[index];
+		node.parent = nullNode;
+		node.child1 = nullNode;
+		node.child2 = nullNode;
+		node.height = 0;
+		node.userData = 0;
+		return index;
+	}
+
+	void freeNode(int index) {
+		nodes[index].parent = freeList;
+		nodes[index].height = -1;
+		freeList = index;
+	}
+
+	void insertLeaf(int leaf) {
+		if (root == nullNode) {
+			root = leaf;
+			nodes[leaf].parent = nullNode;
+			return;
+		}
+
+		// Walk down to the cheapest sibling: creating a parent here costs the combined area, going further down
+		// also grows every node on the way by the area the leaf adds
+		AABB leafBounds = nodes[leaf].bounds;
+		int index = root;
+		while (!nodes[index].isLeaf()) {
+			const Node& node = nodes[index];
+			float area = node.bounds.surfaceArea();
+			float combinedArea = combine(node.bounds, leafBounds).surfaceArea();
+			float cost = 2.f * combinedArea;
+			float inheritance = 2.f * (combinedArea - area);
+
+			float cost1 = descendCost(node.child1, leafBounds) + inheritance;
+			float cost2 = descendCost(node.child2, leafBounds) + inheritance;
+			if (cost < cost1 && cost < cost2) break;
+			index = cost1 < cost2 ? node.child1 : node.child2;
+		}
+
+		int sibling = index;
+		int oldParent = nodes[sibling].parent;
+		int newParent = allocateNode();
+		nodes[newParent].parent = oldParent;
+		nodes[newParent].bounds = combine(leafBounds, nodes[sibling].bounds);
+		nodes[newParent].height = nodes[sibling].height + 1;
+		nodes[newParent].child1 = sibling;
+		nodes[newParent].child2 = leaf;
+		nodes[sibling].parent = newParent;
+		nodes[leaf].parent = newParent;
+
+		if (oldParent == nullNode) root = newParent;
+		else if (nodes[oldParent].child1 == sibling) nodes[oldParent].child1 = newParent;
+		else nodes[oldParent].child2 = newParent;
+
+		refit(nodes[leaf].parent);
+	}
+
+	float descendCost(int child, const AABB& leafBounds) const {
+		const Node& node = nodes[child];
+		float combinedArea = combine(leafBounds, node.bounds).surfaceArea();
+		return node.isLeaf() ? combinedArea : combinedArea - node.bounds.surfaceArea();
+	}
+
+	void removeLeaf(int leaf) {
+		if (leaf == root) {
+			root = nullNode;
+			return;
+		}
+
+		int parent = nodes[leaf].parent;
+		int grandParent = nodes[parent].parent;
+		int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+		if (grandParent == nullNode) {
+			root = sibling;
+			nodes[sibling].parent = nullNode;
+			freeNode(parent);
+			return;
+		}
+
+		if (nodes[grandParent].child1 == parent) nodes[grandParent].child1 = sibling;
+		else nodes[grandParent].child2 = sibling;
+		nodes[sibling].parent = grandParent;
+		freeNode(parent);
+		refit(grandParent);
+	}
+
+	// Rebalances and refits every node from index up to the root
+	void refit(int index) {
+		while (index != nullNode) {
+			index = balance(index);
+			Node& node = nodes[index];
+			const Node& child1 = nodes[node.child1];
+			const Node& child2 = nodes[node.child2];
+			node.height = 1 + std::max<int>(child1.height, child2.height);
+			node.bounds = combine(child1.bounds, child2.bounds);
+			index = node.parent;
+		}
+	}
+
+	// If one child of A is more than one level taller, rotates it up into A's place and hands A its shorter
+	// grandchild. Returns the index now at A's position
+	int balance(int iA) {
+		Node& A = nodes[iA];
+		if (A.isLeaf() || A.height < 2) return iA;
+
+		int iB = A.child1, iC = A.child2;
+		int difference = nodes[iC].height - nodes[iB].height;
+		if (difference > 1) return rotate(iA, iC, iB, false);
+		if (difference < -1) return rotate(iA, iB, iC, true);
+		return iA;
+	}
+
+	// Lifts tall (a child of A) above A. A keeps short and receives tall's shorter child, tall keeps the taller one.
+	// tallIsFirst says which of A's child slots tall occupied
+	int rotate(int iA, int iTall, int iShort, bool tallIsFirst) {
+		Node& A = nodes[iA];
+		Node& tall = nodes[iTall];
+		int iF = tall.child1, iG = tall.child2;
+		Node& F = nodes[iF];
+		Node& G = nodes[iG];
+
+		tall.child1 = iA;
+		tall.parent = A.parent;
+		A.parent = iTall;
+
+		if (tall.parent == nullNode) root = iTall;
+		else if (nodes[tall.parent].child1 == iA) nodes[tall.parent].child1 = iTall;
+		else nodes[tall.parent].child2 = iTall;
+
+		int iKeep = F.height > G.height ? iF : iG;
+		int iGive = F.height > G.height ? iG : iF;
+		tall.child2 = iKeep;
+		if (tallIsFirst) A.child1 = iGive;
+		else A.child2 = iGive;
+		nodes[iGive].parent = iA;
+
+		A.bounds = combine(nodes[iShort].bounds, nodes[iGive].bounds);
+		A.height = 1 + std::max<int>(nodes[iShort].height, nodes[iGive].height);
+		tall.bounds = combine(A.bounds, nodes[iKeep].bounds);
+		tall.height = 1 + std::max<int>(A.height, nodes[iKeep].height);
+		return iTall;
+	}
+};
+
+
+// Swept Sphere Queries
+// Continuous tests for a sphere moving by motion over one step, so fast or low framerate movement cannot tunnel
+// through thin obstacles. t is the fraction of motion travelled at first contact and normal points from the obstacle
+// towards the sphere. A sphere that already touches an obstacle hits at t = 0 only if it moves further in, so a
+// resolver can always back out of a contact
+struct SweepHit {
+	float t;
+	Vec3 normal;
+	int index;				// Obstacle position for the queries over several obstacles
+};
+
+// Earliest t in [0, 1] at which o + d * t comes within radius of centre, for o starting further away
+static bool sweepPointSphere(const Vec3& o, const Vec3& d, const Vec3& centre, float radius, float& t) {
+	Vec3 m = o - centre;
+	float b = Dot(m, d);
+	float c = m.lengthSquare() - radius * radius;
+	if (b >= 0.f) return false;						// Moving away
+	float a = Dot(d, d);
+	float discriminant = b * b - a * c;
+	if (discriminant < 0.f) return false;
+	t = std::max<float>(0.f, (-b - sqrtf(discriminant)) / a);
+	return t <= 1.f;
+}
+
+// Earliest t in [0, 1] at which o + d * t comes within radius of segment ab (a capsule), for o starting outside it
+static bool sweepPointCapsule(const Vec3& o, const Vec3& d, const Vec3& a, const Vec3& b, float radius, float& t) {
+	Vec3 ab = b - a, m = o - a;
+	float dd = Dot(ab, ab), md = Dot(m, ab), nd = Dot(d, ab);
+	float nn = Dot(d, d), mn = Dot(m, d);
+	float best = FLT_MAX, tc;
+
+	// Side of the cylinder, unless the motion runs along the axis (then only the end caps can be hit)
+	float qa = dd * nn - nd * nd;
+	if (qa > 1e-6f * dd * nn) {
+		float qb = dd * mn - nd * md;
+		float qc = dd * (m.lengthSquare() - radius * radius) - md * md;
+		float discriminant = qb * qb - qa * qc;
+		if (discriminant >= 0.f) {
+			tc = (-qb - sqrtf(discriminant)) / qa;
+			float s = md + tc * nd;
+			if (tc >= 0.f && tc <= 1.f && s >= 0.f && s <= dd) best = tc;
+		}
+	}
+
+	if (sweepPointSphere(o, d, a, radius, tc)) best = std::min<float>(best, tc);
+	if (sweepPointSphere(o, d, b, radius, tc)) best = std::min<float>(best, tc);
+	if (best == FLT_MAX) return false;
+	t = best;
+	return true;
+}
+
+// Direction from the closest point of box to p, or out through the nearest face when p is inside
+static Vec3 aabbContactNormal(const AABB& box, const Vec3& p) {
+	Vec3 q = Max(box.min, Min(p, box.max));
+	Vec3 n = p - q;
+	float lengthSquare = n.lengthSquare();
+	if (lengthSquare > 1e-12f) return n / sqrtf(lengthSquare);
+
+	int axis = 0;
+	float sign = -1.f, nearest = FLT_MAX;
+	for (int a = 0; a < 3; a++) {
+		if (p.v[a] - box.min.v[a] < nearest) { nearest = p.v[a] - box.min.v[a]; axis = a; sign = -1.f; }
+		if (box.max.v[a] - p.v[a] < nearest) { nearest = box.max.v[a] - p.v[a]; axis = a; sign = 1.f; }
+	}
+	Vec3 ret(0.f, 0.f, 0.f);
+	ret.v[axis] = sign;
+	return ret;
+}
+
+// Box corner with max on the axes whose bit is set in n (bit 0 x, 1 y, 2 z) and min on the others
+static Vec3 aabbCorner(const AABB& box, int n) {
+	return Vec3((n & 1) ? box.max.x : box.min.x, (n & 2) ? box.max.y : box.min.y, (n & 4) ? box.max.z : box.min.z);
+}
+
+// Sphere against a box: the centre is swept against the box grown by the radius, then hits in an edge or corner
+// region of the grown box are redone against the rounded edge capsules (Ericson, Real-Time Collision Detection 5.5.7)
+static bool sweepSphereAabb(const BoundingSphere& sphere, const Vec3& motion, const AABB& box, float& t, Vec3& normal) {
+	float r = sphere.radius;
+	const Vec3& c = sphere.centre;
+	if (box.distanceSquare(c) <= r * r) {
+		normal = aabbContactNormal(box, c);
+		if (Dot(motion, normal) >= 0.f) return false;
+		t = 0.f;
+		return true;
+	}
+	if (motion.lengthSquare() == 0.f) return false;
+
+	Vec3 grow(r, r, r);
+	float tEnter;
+	if (!AABB::rayBox(box.min - grow, box.max + grow, Ray(c, motion), 1.f, tEnter)) return false;
+
+	Vec3 p = c + motion * tEnter;
+	int below = 0, above = 0;
+	for (int a = 0; a < 3; a++) {
+		if (p.v[a] < box.min.v[a]) below |= 1 << a;
+		if (p.v[a] > box.max.v[a]) above |= 1 << a;
+	}
+	int region = below | above;
+
+	if (region == 7) {
+		// Corner: the three edges meeting at it
+		float best = FLT_MAX, te;
+		for (int a = 0; a < 3; a++)
+			if (sweepPointCapsule(c, motion, aabbCorner(box, above), aabbCorner(box, above ^ (1 << a)), r, te)) best = std::min<float>(best, te);
+		if (best == FLT_MAX) return false;
+		tEnter = best;
+	}
+	else if (region & (region - 1)) {
+		// Edge: the capsule along the one axis where the point is inside the box
+		if (!sweepPointCapsule(c, motion, aabbCorner(box, above), aabbCorner(box, above | (7 ^ region)), r, tEnter)) return false;
+	}
+	// Otherwise a face, where the grown box is exact
+
+	t = tEnter;
+	normal = aabbContactNormal(box, c + motion * t);
+	return true;
+}
+
+static bool sweepSphereSphere(const BoundingSphere& sphere, const Vec3& motion, const BoundingSphere& target, float& t, Vec3& normal) {
+	float r = sphere.radius + target.radius;
+	Vec3 m = sphere.centre - target.centre;
+	if (m.lengthSquare() <= r * r) {
+		normal = m.lengthSquare() > 1e-12f ? m.normalize() : Vec3(0.f, 1.f, 0.f);
+		if (Dot(motion, normal) >= 0.f) return false;
+		t = 0.f;
+		return true;
+	}
+	if (!sweepPointSphere(sphere.centre, motion, target.centre, r, t)) return false;
+	normal = (sphere.centre + motion * t - target.centre).normalize();
+	return true;
+}
+
+// Reach of a sweep: every box a sphere moving by motion (along any path no longer than motion) can touch
+static AABB sweepBounds(const BoundingSphere& sphere, const Vec3& motion) {
+	float reach = sphere.radius + motion.length();
+	Vec3 r(reach, reach, reach);
+	AABB bounds;
+	bounds.min = sphere.centre - r;
+	bounds.max = sphere.centre + r;
+	return bounds;
+}
+
+// First box hit among boxes, hit.index is its position in boxes. Boxes outside the swept bounds are skipped cheaply
+static bool sweepSphereAabbs(const BoundingSphere& sphere, const Vec3& motion, const AABB* boxes, int count, SweepHit& hit) {
+	AABB swept;
+	swept.min = Min(sphere.centre, sphere.centre + motion) - Vec3(sphere.radius, sphere.radius, sphere.radius);
+	swept.max = Max(sphere.centre, sphere.centre + motion) + Vec3(sphere.radius, sphere.radius, sphere.radius);
+
+	hit.index = -1;
+	hit.t = FLT_MAX;
+	for (int i = 0; i < count; i++) {
+		const AABB& box = boxes[i];
+		if (box.min.x > swept.max.x || box.max.x < swept.min.x || box.min.y > swept.max.y || box.max.y < swept.min.y ||
+			box.min.z > swept.max.z || box.max.z < swept.min.z) continue;
+		float t;
+		Vec3 normal;
+		if (sweepSphereAabb(sphere, motion, box, t, normal) && t < hit.t) {
+			hit.t = t;
+			hit.normal = normal;
+			hit.index = i;
+		}
+	}
+	return hit.index >= 0;
+}
+
+// Sphere cast against target spheres (melee swings, thick rays), first target hit
+inline bool sweepSphereSpheres(const BoundingSphere& sphere, const Vec3& motion, const BoundingSphere* targets, int count, SweepHit& hit) {
+	hit.index = -1;
+	hit.t = FLT_MAX;
+	for (int i = 0; i < count; i++) {
+		float t;
+		Vec3 normal;
+		if (sweepSphereSphere(sphere, motion, targets[i], t, normal) && t < hit.t) {
+			hit.t = t;
+			hit.normal = normal;
+			hit.index = i;
+		}
+	}
+	return hit.index >= 0;
+}
+
+// Slide Resolver
+// Moves the sphere by motion through boxes and returns where its centre ends up. Each iteration moves to the first
+// contact (stopping skin short of it), removes the part of the remaining motion that points into the surface and
+// continues with the rest. Against a second surface at an angle only the motion along their crease is kept, and
+// after maxIterations contacts the sphere stops where it is
+inline Vec3 slideSphere(const BoundingSphere& sphere, const Vec3& motion, const AABB* boxes, int count, int maxIterations = 4, float skin = 1e-3f) {
+	BoundingSphere moving = sphere;
+	Vec3 remaining = motion;
+	Vec3 firstNormal;
+	bool hasFirstNormal = false;
+
+	for (int i = 0; i < maxIterations; i++) {
+		float length = remaining.length();
+		if (length <= skin) return moving.centre;
+
+		SweepHit hit;
+		if (!sweepSphereAabbs(moving, remaining, boxes, count, hit)) return moving.centre + remaining;
+
+		float travel = std::max<float>(0.f, hit.t - skin / length);
+		moving.centre = moving.centre + remaining * travel;
+		remaining = remaining * (1.f - travel);
+		remaining = remaining - hit.normal * Dot(remaining, hit.normal);
+
+		if (hasFirstNormal && Dot(remaining, firstNormal) < 0.f) {
+			Vec3 crease = Cross(firstNormal, hit.normal);
+			float creaseLength = crease.length();
+			remaining = creaseLength > 1e-6f ? crease * (Dot(remaining, crease) / (creaseLength * creaseLength)) : Vec3(0.f, 0.f, 0.f);
+		}
+		firstNormal = hit.normal;
+		hasFirstNormal = true;
+	}
+	return moving.centre;
+}
+
+// The same against a static scene BVH, only the boxes within reach of the motion are swept
+inline Vec3 slideSphere(const BoundingSphere& sphere, const Vec3& motion, const BVH& world, int maxIterations = 4, float skin = 1e-3f) {
+	std::vector<AABB> nearby;
+	world.visitAABB(sweepBounds(sphere, motion), [&](const AABB& box, int) { nearby.push_back(box); });
+	if (nearby.empty()) return sphere.centre + motion;
+	return slideSphere(sphere, motion, &nearby[0], (int)nearby.size(), maxIterations, skin);
+}
+
+// Capsule
+// Segment ab swept by radius, a close fit for limbs and bodies that stays cheap to move: posing it only moves two
+// points. Every test reduces to a distance between a point or segment and the core segment
+
+// Point of segment ab closest to p
+static Vec3 closestPointSegment(const Vec3& p, const Vec3& a, const Vec3& b) {
+	Vec3 ab = b - a;
+	float dd = Dot(ab, ab);
+	if (dd <= 0.f) return a;
+	return a + ab * clamp(Dot(p - a, ab) / dd, 0.f, 1.f);
+}
+
+// Squared distance between segments p1q1 and p2q2, c1 and c2 get the closest points on each (Ericson, Real-Time
+// Collision Detection 5.1.9). Degenerate segments are handled as points
+static float closestPointsSegments(const Vec3& p1, const Vec3& q1, const Vec3& p2, const Vec3& q2, Vec3& c1, Vec3& c2) {
+	Vec3 d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+	float a = Dot(d1, d1), e = Dot(d2, d2), f = Dot(d2, r);
+	float s = 0.f, t = 0.f;
+	if (a > 0.f && e <= 0.f) s = clamp(-Dot(d1, r) / a, 0.f, 1.f);
+	else if (a <= 0.f && e > 0.f) t = clamp(f / e, 0.f, 1.f);
+	else if (a > 0.f) {
+		float b = Dot(d1, d2), c = Dot(d1, r);
+		float denominator = a * e - b * b;		// Zero for parallel segments, any s then works
+		if (denominator > 0.f) s = clamp((b * f - c * e) / denominator, 0.f, 1.f);
+		t = (b * s + f) / e;
+		if (t < 0.f) {
+			t = 0.f;
+			s = clamp(-c / a, 0.f, 1.f);
+		} else if (t > 1.f) {
+			t = 1.f;
+			s = clamp((b - c) / a, 0.f, 1.f);
+		}
+	}
+	c1 = p1 + d1 * s;
+	c2 = p2 + d2 * t;
+	return (c1 - c2).lengthSquare();
+}
+
+class Capsule {
+public:
+	Vec3 a, b;
+	float radius;
+
+	Vec3 closestPoint(const Vec3& p) const { return closestPointSegment(p, a, b); }
+
+	BoundingSphere bounds() const {
+		BoundingSphere sphere;
+		sphere.centre = (a + b) * 0.5f;
+		sphere.radius = (b - a).length() * 0.5f + radius;
+		return sphere;
+	}
+
+	// Nearest t in [0, tMax], 0 when the ray starts inside. Nothing in the capsule is further from the origin than
+	// |o - a| + |ab| + radius, so the ray is cut there and swept as a finite segment
+	bool rayCapsule(const Ray& r, float& t, float tMax = FLT_MAX) const {
+		if ((r.o - closestPoint(r.o)).lengthSquare() <= radius * radius) {
+			t = 0.f;
+			return true;
+		}
+		float reach = std::min<float>(tMax, ((r.o - a).length() + (b - a).length() + radius) / r.dir.length());
+		float s;
+		if (!sweepPointCapsule(r.o, r.dir * reach, a, b, radius, s)) return false;
+		t = s * reach;
+		return true;
+	}
+};
+
+inline bool collisionSphereCapsule(const BoundingSphere& sphere, const Capsule& capsule) {
+	float reach = sphere.radius + capsule.radius;
+	return (capsule.closestPoint(sphere.centre) - sphere.centre).lengthSquare() <= reach * reach;
+}
+
+inline bool collisionCapsuleCapsule(const Capsule& capsule1, const Capsule& capsule2) {
+	Vec3 c1, c2;
+	float reach = capsule1.radius + capsule2.radius;
+	return closestPointsSegments(capsule1.a, capsule1.b, capsule2.a, capsule2.b, c1, c2) <= reach * reach;
+}
+
+
+// Bounding Volumes from Points
+// Load time fitting of mesh vertices. computeAABB is one 8-wide pass that also finds the points with the smallest
+// and largest coordinate on each axis (extremes: min x, max x, min y, max y, min z, max z), where Ritter's sphere
+// starts. Lane indices are tracked as floats, exact up to 2^24 points
+inline AABB computeAABB(const Vec3* points, int count, int* extremes = nullptr) {
+	AABB box;
+	int ext[6] = { 0, 0, 0, 0, 0, 0 };
+	int i = 0;
+	if (count >= 8) {
+		const float laneIndices[8] = { 0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f };
+		Floatx8 index = Floatx8::load(laneIndices), step(8.f);
+		Vec3x8 low = Vec3x8::load(points), high = low;
+		Floatx8 lowIndex[3] = { index, index, index }, highIndex[3] = { index, index, index };
+		auto update = [&](const Floatx8& p, Floatx8& l, Floatx8& h, Floatx8& li, Floatx8& hi) {
+			Floatx8 below = p < l, above = p > h;
+			l = Select(below, p, l);
+			li = Select(below, index, li);
+			h = Select(above, p, h);
+			hi = Select(above, index, hi);
+		};
+		for (i = 8; i + 8 <= count; i += 8) {
+			index = index + step;
+			Vec3x8 p = Vec3x8::load(points + i);
+			update(p.x, low.x, high.x, lowIndex[0], highIndex[0]);
+			update(p.y, low.y, high.y, lowIndex[1], highIndex[1]);
+			update(p.z, low.z, high.z, lowIndex[2], highIndex[2]);
+		}
+
+		// Reduce the lanes, ties go to the lower lane
+		const Floatx8* lows[3] = { &low.x, &low.y, &low.z };
+		const Floatx8* highs[3] = { &high.x, &high.y, &high.z };
+		for (int a = 0; a < 3; a++) {
+			float l[8], h[8], li[8], hi[8];
+			lows[a]->store(l);
+			highs[a]->store(h);
+			lowIndex[a].store(li);
+			highIndex[a].store(hi);
+			int lowLane = 0, highLane = 0;
+			for (int lane = 1; lane < 8; lane++) {
+				if (l[lane] < l[lowLane]) lowLane = lane;
+				if (h[lane] > h[highLane]) highLane = lane;
+			}
+			ext[2 * a] = (int)li[lowLane];
+			ext[2 * a + 1] = (int)hi[highLane];
+		}
+	}
+	for (; i < count; i++) {
+		for (int a = 0; a < 3; a++) {
+			if (points[i].v[a] < points[ext[2 * a]].v[a]) ext[2 * a] = i;
+			if (points[i].v[a] > points[ext[2 * a + 1]].v[a]) ext[2 * a + 1] = i;
+		}
+	}
+
+	if (count > 0) {
+		box.min = Vec3(points[ext[0]].x, points[ext[2]].y, points[ext[4]].z);
+		box.max = Vec3(points[ext[1]].x, points[ext[3]].y, points[ext[5]].z);
+	}
+	if (extremes) for (int a = 0; a < 6; a++) extremes[a] = ext[a];
+	return box;
+}
+
+// Grows sphere just enough to take in p (Ritter's update), returns whether it had to
+inline bool growSphere(BoundingSphere& sphere, const Vec3& p) {
+	Vec3 d = p - sphere.centre;
+	float distanceSquare = d.lengthSquare();
+	if (distanceSquare <= sphere.radius * sphere.radius) return false;
+	float distance = sqrtf(distanceSquare);
+	float radius = (sphere.radius + distance) * 0.5f;
+	sphere.centre = sphere.centre + d * ((radius - sphere.radius) / distance);
+	sphere.radius = std::max<float>(radius, (p - sphere.centre).length());
+	return true;
+}
+
+// Ritter's sphere: the most separated pair of axis extremes as a diameter, then grown over every point outside it.
+// Two passes, usually within 5-20% of the minimal radius
+inline BoundingSphere ritterSphere(const Vec3* points, int count) {
+	BoundingSphere sphere;
+	sphere.centre = Vec3(0.f, 0.f, 0.f);
+	sphere.radius = 0.f;
+	if (count == 0) return sphere;
+
+	int ext[6];
+	computeAABB(points, count, ext);
+	int a = ext[0], b = ext[1];
+	for (int axis = 1; axis < 3; axis++) {
+		const Vec3& pa = points[ext[2 * axis]];
+		const Vec3& pb = points[ext[2 * axis + 1]];
+		if ((pb - pa).lengthSquare() > (points[b] - points[a]).lengthSquare()) {
+			a = ext[2 * axis];
+			b = ext[2 * axis + 1];
+		}
+	}
+	sphere.centre = (points[a] + points[b]) * 0.5f;
+	sphere.radius = (points[b] - points[a]).length() * 0.5f;
+	for (int i = 0; i < count; i++) growSphere(sphere, points[i]);
+	return sphere;
+}
+
+// Sphere in double precision for the exact fit, where circumcentres of nearly flat point sets lose too much in float
+struct SphereFit {
+	double c[3];
+	double r2;
+
+	bool contains(const double* p) const {
+		double dx = p[0] - c[0], dy = p[1] - c[1], dz = p[2] - c[2];
+		return dx * dx + dy * dy + dz * dz <= r2 * (1.0 + 1e-9) + 1e-18;
+	}
+
+	void radiusTo(const double* p) {
+		double dx = p[0] - c[0], dy = p[1] - c[1], dz = p[2] - c[2];
+		r2 = dx * dx + dy * dy + dz * dz;
+	}
+
+	static SphereFit through(const double* a, const double* b) {
+		SphereFit s;
+		for (int i = 0; i < 3; i++) s.c[i] = (a[i] + b[i]) * 0.5;
+		s.radiusTo(a);
+		return s;
+	}
+
+	// Circumsphere of a, b, c (centre in their plane), false when they are collinear
+	static bool through(const double* a, const double* b, const double* c, SphereFit& s) {
+		double u[3], v[3], w[3];
+		for (int i = 0; i < 3; i++) { u[i] = b[i] - a[i]; v[i] = c[i] - a[i]; }
+		cross(u, v, w);
+		double ww = dot(w, w);
+		if (ww <= 1e-12 * dot(u, u) * dot(v, v)) return false;
+		double m[3], n[3];
+		for (int i = 0; i < 3; i++) m[i] = dot(u, u) * v[i] - dot(v, v) * u[i];
+		cross(m, w, n);
+		for (int i = 0; i < 3; i++) s.c[i] = a[i] + n[i] / (2.0 * ww);
+		s.radiusTo(a);
+		return true;
+	}
+
+	// Circumsphere of a, b, c, d, false when they are coplanar
+	static bool through(const double* a, const double* b, const double* c, const double* d, SphereFit& s) {
+		double u[3], v[3], t[3];
+		for (int i = 0; i < 3; i++) { u[i] = b[i] - a[i]; v[i] = c[i] - a[i]; t[i] = d[i] - a[i]; }
+		double vt[3], tu[3], uv[3];
+		cross(v, t, vt);
+		cross(t, u, tu);
+		cross(u, v, uv);
+		double det = dot(u, vt);
+		if (fabs(det) <= 1e-9 * sqrt(dot(u, u) * dot(v, v) * dot(t, t))) return false;
+		for (int i = 0; i < 3; i++) s.c[i] = a[i] + (dot(u, u) * vt[i] + dot(v, v) * tu[i] + dot(t, t) * uv[i]) / (2.0 * det);
+		s.radiusTo(a);
+		return true;
+	}
+
+	// Smallest sphere holding up to 4 points, from their pairs and triples (for the degenerate cases above)
+	static SphereFit enclose(const double* const* p, int count) {
+		SphereFit best = through(p[0], p[0]);
+		best.r2 = DBL_MAX;
+		auto consider = [&](const SphereFit& s) {
+			if (s.r2 >= best.r2) return;
+			for (int i = 0; i < count; i++) if (!s.contains(p[i])) return;
+			best = s;
+		};
+		for (int i = 0; i < count; i++) {
+			for (int j = i + 1; j < count; j++) {
+				consider(through(p[i], p[j]));
+				for (int k = j + 1; k < count; k++) {
+					SphereFit s;
+					if (through(p[i], p[j], p[k], s)) consider(s);
+				}
+			}
+		}
+		return best;
+	}
+
+	static double dot(const double* a, const double* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+	static void cross(const double* a, const double* b, double* out) {
+		out[0] = a[1] * b[2] - a[2] * b[1];
+		out[1] = a[2] * b[0] - a[0] * b[2];
+		out[2] = a[0] * b[1] - a[1] * b[0];
+	}
+};
+
+// Minimal bounding sphere (Welzl, in the randomized incremental form with expected linear time). Points are
+// shuffled once with a fixed seed so the result does not change between runs. Slower than Ritter, exact
+inline BoundingSphere welzlSphere(const Vec3* points, int count) {
+	BoundingSphere sphere;
+	sphere.centre = Vec3(0.f, 0.f, 0.f);
+	sphere.radius = 0.f;
+	if (count == 0) return sphere;
+
+	std::vector<int> order(count);
+	for (int i = 0; i < count; i++) order[i] = i;
+	std::shuffle(order.begin(), order.end(), std::mt19937(5489u));
+	std::vector<double> p(3 * (size_t)count);
+	for (int i = 0; i < count; i++)
+		for (int a = 0; a < 3; a++) p[3 * (size_t)i + a] = points[order[i]].v[a];
+	auto at = [&](int i) { return &p[3 * (size_t)i]; };
+
+	// Each level fixes one more point on the boundary, the inner loops only revisit the points before it
+	SphereFit s = SphereFit::through(at(0), at(0));
+	for (int i = 1; i < count; i++) {
+		if (s.contains(at(i))) continue;
+		s = SphereFit::through(at(i), at(i));
+		for (int j = 0; j < i; j++) {
+			if (s.contains(at(j))) continue;
+			s = SphereFit::through(at(i), at(j));
+			for (int k = 0; k < j; k++) {
+				if (s.contains(at(k))) continue;
+				const double* three[3] = { at(i), at(j), at(k) };
+				if (!SphereFit::through(three[0], three[1], three[2], s)) s = SphereFit::enclose(three, 3);
+				for (int l = 0; l < k; l++) {
+					if (s.contains(at(l))) continue;
+					const double* four[4] = { at(i), at(j), at(k), at(l) };
+					if (!SphereFit::through(four[0], four[1], four[2], four[3], s)) s = SphereFit::enclose(four, 4);
+				}
+			}
+		}
+	}
+
+	// Back to float, then make sure rounding left no point outside
+	sphere.centre = Vec3((float)s.c[0], (float)s.c[1], (float)s.c[2]);
+	sphere.radius = (float)sqrt(s.r2);
+	for (int i = 0; i < count; i++) growSphere(sphere, points[i]);
+	return sphere;
 }
\ No newline at end of file
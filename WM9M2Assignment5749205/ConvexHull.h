@@ -0,0 +1,691 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Collision.h"
+#include "GEMLoader.h"
+#include "MyMath.h"
+
+// Convex Hulls
+// Props like the truck or the food warmer are a poor fit for a box or a sphere. Their convex hull is built once at
+// load time with quickhull and capped at a vertex budget, then GJK answers distance and overlap queries between
+// hulls, spheres and capsules, and EPA the penetration depth when they overlap. All three work on support points
+// only (the furthest point of a shape along a direction), hull supports hill climb over the vertex adjacency from
+// the vertex of the previous query, so a pair that barely moves between frames needs a step or two per support
+
+// Convex hull of a point set, counter clockwise triangles seen from outside
+class ConvexHull {
+public:
+	std::vector<Vec3> vertices;
+	std::vector<int> triangles;			// 3 per face
+	std::vector<int> adjacencyFirst;	// Neighbours of vertex i are adjacency[adjacencyFirst[i]] to adjacency[adjacencyFirst[i + 1] - 1]
+	std::vector<int> adjacency;
+	BoundingSphere sphere;				// Around the hull vertices
+
+	// Quickhull (Barber, Dobkin and Huhdanpaa). Each step adds the point furthest outside a face, so stopping at
+	// maxVertices keeps the points that shape the hull most, the hull then lies inside the input by at most the
+	// distance of the next point it would have added. Flat or collinear input has no faces and keeps its axis
+	// extremes, supports then scan them
+	void build(const Vec3* points, int count, int maxVertices = 64) {
+		vertices.clear();
+		triangles.clear();
+		adjacencyFirst.clear();
+		adjacency.clear();
+		sphere.centre = Vec3(0.f, 0.f, 0.f);
+		sphere.radius = 0.f;
+		if (count <= 0) return;
+
+		int extremes[6];
+		AABB box = computeAABB(points, count, extremes);
+		float epsilon = 3.f * FLT_EPSILON * (std::max<float>(fabsf(box.min.x), fabsf(box.max.x)) +
+											 std::max<float>(fabsf(box.min.y), fabsf(box.max.y)) +
+											 std::max<float>(fabsf(box.min.z), fabsf(box.max.z)));
+
+		// Initial tetrahedron: the most separated pair of extremes, the point furthest from their line, then the
+		// point furthest from that plane
+		int simplex[4] = { extremes[0], extremes[1], 0, 0 };
+		for (int i = 0; i < 6; i++)
+			for (int j = i + 1; j < 6; j++)
+				if ((points[extremes[i]] - points[extremes[j]]).lengthSquare() > (points[simplex[0]] - points[simplex[1]]).lengthSquare()) {
+					simplex[0] = extremes[i];
+					simplex[1] = extremes[j];
+				}
+		Vec3 p0 = points[simplex[0]], line = points[simplex[1]] - p0;
+		float best = 0.f;
+		for (int i = 0; i < count; i++) {
+			float d = Cross(points[i] - p0, line).lengthSquare();
+			if (d > best) { best = d; simplex[2] = i; }
+		}
+		Vec3 normal = Cross(line, points[simplex[2]] - p0);
+		best = 0.f;
+		for (int i = 0; i < count && normal.lengthSquare() > 0.f; i++) {
+			float d = fabsf(Dot(points[i] - p0, normal));
+			if (d > best) { best = d; simplex[3] = i; }
+		}
+		if (line.length() <= epsilon || normal.lengthSquare() == 0.f || best <= epsilon * normal.length()) {
+			for (int i = 0; i < 6; i++)
+				if (std::find(extremes, extremes + i, extremes[i]) == extremes + i) vertices.push_back(points[extremes[i]]);
+			finish();
+			return;
+		}
+
+		HullBuilder builder(points, epsilon);
+		Vec3 inside = (points[simplex[0]] + points[simplex[1]] + points[simplex[2]] + points[simplex[3]]) * 0.25f;
+		const int tetrahedron[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 1, 3, 2 }, { 2, 3, 0 } };
+		for (int f = 0; f < 4; f++) {
+			int a = simplex[tetrahedron[f][0]], b = simplex[tetrahedron[f][1]], c = simplex[tetrahedron[f][2]];
+			if (Dot(Cross(points[b] - points[a], points[c] - points[a]), inside - points[a]) > 0.f) std::swap(b, c);
+			builder.addFace(a, b, c);
+		}
+		std::vector<int> outside;
+		for (int i = 0; i < count; i++)
+			if (i != simplex[0] && i != simplex[1] && i != simplex[2] && i != simplex[3]) outside.push_back(i);
+		builder.assign(outside, 0);
+
+		int vertexCount = 4;
+		while (vertexCount < maxVertices && builder.expand()) vertexCount++;
+
+		// Compact the vertices of the remaining faces
+		std::vector<int> remap(count, -1);
+		for (const HullBuilder::Face& face : builder.faces) {
+			if (!face.alive) continue;
+			for (int i = 0; i < 3; i++) {
+				if (remap[face.v[i]] < 0) {
+					remap[face.v[i]] = (int)vertices.size();
+					vertices.push_back(points[face.v[i]]);
+				}
+				triangles.push_back(remap[face.v[i]]);
+			}
+		}
+		finish();
+	}
+
+	// Hull of every mesh of a GEM model in model space (static and animated vertices)
+	void build(const std::vector<GEMLoader::GEMMesh>& meshes, int maxVertices = 64) {
+		std::vector<Vec3> positions;
+		for (const GEMLoader::GEMMesh& mesh : meshes) {
+			for (const GEMLoader::GEMStaticVertex& vertex : mesh.verticesStatic) positions.push_back(Vec3(vertex.position.x, vertex.position.y, vertex.position.z));
+			for (const GEMLoader::GEMAnimatedVertex& vertex : mesh.verticesAnimated) positions.push_back(Vec3(vertex.position.x, vertex.position.y, vertex.position.z));
+		}
+		build(positions.empty() ? nullptr : &positions[0], (int)positions.size(), maxVertices);
+	}
+
+	// Vertex furthest along d. Small hulls are scanned, larger ones climb from start to the best neighbour until none
+	// is better (on a convex polytope the first local maximum is the global one)
+	int support(const Vec3& d, int start = 0) const {
+		int best = start < (int)vertices.size() ? start : 0;
+		float bestDot = Dot(vertices[best], d);
+		if ((int)vertices.size() <= scanLimit || adjacency.empty()) {
+			for (int i = 0; i < (int)vertices.size(); i++) {
+				float dot = Dot(vertices[i], d);
+				if (dot > bestDot) { bestDot = dot; best = i; }
+			}
+			return best;
+		}
+		for (int current = -1; current != best;) {
+			current = best;
+			for (int i = adjacencyFirst[current]; i < adjacencyFirst[current + 1]; i++) {
+				float dot = Dot(vertices[adjacency[i]], d);
+				if (dot > bestDot) { bestDot = dot; best = adjacency[i]; }
+			}
+		}
+		return best;
+	}
+
+private:
+	static const int scanLimit = 16;
+
+	// Face list of the hull under construction, every directed edge maps to the face it belongs to so the faces
+	// across an edge can be found while walking the region visible from a new point
+	struct HullBuilder {
+		struct Face {
+			int v[3];
+			Vec3 normal;
+			float offset;
+			std::vector<int> outside;		// Points above the face, not yet on the hull
+			int furthest;
+			float furthestDistance;
+			bool alive;
+		};
+
+		const Vec3* points;
+		float epsilon;
+		std::vector<Face> faces;
+		std::unordered_map<long long, int> edges;
+
+		HullBuilder(const Vec3* _points, float _epsilon) : points(_points), epsilon(_epsilon) {}
+
+		static long long key(int a, int b) { return ((long long)a << 32) | (unsigned int)b; }
+
+		float distance(const Face& face, int point) const { return Dot(face.normal, points[point]) - face.offset; }
+
+		void addFace(int a, int b, int c) {
+			Face face;
+			face.v[0] = a;
+			face.v[1] = b;
+			face.v[2] = c;
+			face.normal = Cross(points[b] - points[a], points[c] - points[a]);
+			float length = face.normal.length();
+			face.normal = length > 0.f ? face.normal / length : Vec3(0.f, 0.f, 0.f);
+			face.offset = Dot(face.normal, points[a]);
+			face.furthest = -1;
+			face.furthestDistance = 0.f;
+			face.alive = true;
+			int index = (int)faces.size();
+			edges[key(a, b)] = index;
+			edges[key(b, c)] = index;
+			edges[key(c, a)] = index;
+			faces.push_back(face);
+		}
+
+		// Gives each point to the first face from firstFace on it lies above, points above none are inside the hull
+		void assign(const std::vector<int>& candidates, int firstFace) {
+			for (int point : candidates) {
+				for (int f = firstFace; f < (int)faces.size(); f++) {
+					Face& face = faces[f];
+					if (!face.alive) continue;
+					float d = distance(face, point);
+					if (d <= epsilon) continue;
+					face.outside.push_back(point);
+					if (d > face.furthestDistance) {
+						face.furthestDistance = d;
+						face.furthest = point;
+					}
+					break;
+				}
+			}
+		}
+
+		// Adds the point furthest above its face: the faces it sees are replaced by a cone from the point to their
+		// horizon and their outside points go to the new faces. False when no point is left outside
+		bool expand() {
+			int start = -1;
+			for (int f = 0; f < (int)faces.size(); f++)
+				if (faces[f].alive && faces[f].furthest >= 0 && (start < 0 || faces[f].furthestDistance > faces[start].furthestDistance)) start = f;
+			if (start < 0) return false;
+			int eye = faces[start].furthest;
+
+			std::vector<int> visible(1, start);
+			std::vector<std::pair<int, int>> horizon;
+			faces[start].alive = false;
+			for (size_t i = 0; i < visible.size(); i++) {
+				const Face& face = faces[visible[i]];
+				for (int e = 0; e < 3; e++) {
+					int a = face.v[e], b = face.v[(e + 1) % 3];
+					int across = edges[key(b, a)];
+					if (!faces[across].alive) continue;
+					if (distance(faces[across], eye) > epsilon) {
+						faces[across].alive = false;
+						visible.push_back(across);
+					} else {
+						horizon.push_back(std::make_pair(a, b));
+					}
+				}
+			}
+
+			std::vector<int> orphans;
+			for (int f : visible) {
+				for (int point : faces[f].outside)
+					if (point != eye) orphans.push_back(point);
+				std::vector<int>().swap(faces[f].outside);
+				for (int e = 0; e < 3; e++) edges.erase(key(faces[f].v[e], faces[f].v[(e + 1) % 3]));
+			}
+			int firstNew = (int)faces.size();
+			for (const std::pair<int, int>& edge : horizon) addFace(edge.first, edge.second, eye);
+			assign(orphans, firstNew);
+			return true;
+		}
+	};
+
+	// Bounding sphere and vertex adjacency (from the face edges, each directed edge a to b is in exactly one face)
+	void finish() {
+		sphere = ritterSphere(vertices.empty() ? nullptr : &vertices[0], (int)vertices.size());
+		if (triangles.empty()) return;
+		std::vector<std::vector<int>> neighbours(vertices.size());
+		for (size_t i = 0; i < triangles.size(); i += 3)
+			for (int e = 0; e < 3; e++) neighbours[triangles[i + e]].push_back(triangles[i + (e + 1) % 3]);
+		adjacencyFirst.push_back(0);
+		for (const std::vector<int>& list : neighbours) {
+			adjacency.insert(adjacency.end(), list.begin(), list.end());
+			adjacencyFirst.push_back((int)adjacency.size());
+		}
+	}
+};
+
+// Convex Shapes
+// A shape as GJK sees it: a core (hull vertices, a segment or a point) grown by radius. A sphere is a point core and a
+// capsule a segment core, the radius is added after the core query, so curved shapes never have to be tessellated
+struct ConvexShape {
+	const ConvexHull* hull;
+	Affine transform;		// Hull to world
+	Vec3 a, b;				// Segment core when there is no hull (a == b for a sphere)
+	float radius;
+
+	static ConvexShape fromHull(const ConvexHull& hull, const Matrix& world) {
+		ConvexShape shape;
+		shape.hull = &hull;
+		shape.transform = Affine(world);
+		shape.radius = 0.f;
+		return shape;
+	}
+
+	// Boxes are the unit cube hull stretched onto the box axes
+	static ConvexShape fromOBB(const OBB& obb) {
+		ConvexShape shape;
+		shape.hull = &unitCube();
+		shape.transform = Affine(obb.axis[0].x * obb.extent.x, obb.axis[1].x * obb.extent.y, obb.axis[2].x * obb.extent.z, obb.centre.x,
+								 obb.axis[0].y * obb.extent.x, obb.axis[1].y * obb.extent.y, obb.axis[2].y * obb.extent.z, obb.centre.y,
+								 obb.axis[0].z * obb.extent.x, obb.axis[1].z * obb.extent.y, obb.axis[2].z * obb.extent.z, obb.centre.z);
+		shape.radius = 0.f;
+		return shape;
+	}
+
+	static ConvexShape fromAABB(const AABB& box) { return fromOBB(OBB(box)); }
+
+	static ConvexShape fromSphere(const BoundingSphere& sphere) {
+		ConvexShape shape;
+		shape.hull = nullptr;
+		shape.a = shape.b = sphere.centre;
+		shape.radius = sphere.radius;
+		return shape;
+	}
+
+	static ConvexShape fromCapsule(const Capsule& capsule) {
+		ConvexShape shape;
+		shape.hull = nullptr;
+		shape.a = capsule.a;
+		shape.b = capsule.b;
+		shape.radius = capsule.radius;
+		return shape;
+	}
+
+	Vec3 centre() const { return hull ? transform.mulPoint(hull->sphere.centre) : (a + b) * 0.5f; }
+
+	// Furthest core point along d. The hull is searched along the transposed transform (the direction that picks
+	// the same vertex in hull space), vertex is where the search starts and ends
+	Vec3 supportCore(const Vec3& d, int& vertex) const {
+		if (!hull) return Dot(b - a, d) > 0.f ? b : a;
+		const float* m = transform.m;
+		vertex = hull->support(Vec3(m[0] * d.x + m[4] * d.y + m[8] * d.z, m[1] * d.x + m[5] * d.y + m[9] * d.z, m[2] * d.x + m[6] * d.y + m[10] * d.z), vertex);
+		return transform.mulPoint(hull->vertices[vertex]);
+	}
+
+	// Furthest point of the whole shape along d
+	Vec3 support(const Vec3& d, int& vertex) const {
+		Vec3 p = supportCore(d, vertex);
+		if (radius <= 0.f) return p;
+		float length = d.length();
+		return length > 0.f ? p + d * (radius / length) : p;
+	}
+
+	// Corners at -1 and 1 on every axis, built on first use
+	static const ConvexHull& unitCube() {
+		static const ConvexHull cube = [] {
+			Vec3 corners[8];
+			for (int i = 0; i < 8; i++) corners[i] = Vec3(i & 1 ? 1.f : -1.f, i & 2 ? 1.f : -1.f, i & 4 ? 1.f : -1.f);
+			ConvexHull hull;
+			hull.build(corners, 8);
+			return hull;
+		}();
+		return cube;
+	}
+};
+
+// Per pair state kept between frames: the last separating direction and support vertices, where the next query of
+// the pair starts
+struct GJKCache {
+	Vec3 direction = Vec3(0.f, 0.f, 0.f);
+	int vertexA = 0;
+	int vertexB = 0;
+};
+
+// Contact of two overlapping shapes, normal points from a towards b (moving b by normal * depth separates them)
+struct ConvexContact {
+	Vec3 normal;
+	float depth;
+	Vec3 pointA, pointB;	// Deepest points of each shape inside the other
+};
+
+// GJK
+// Simplex of the Minkowski difference a - b with the support points of both shapes behind each vertex, solved for the
+// point closest to the origin with the closest point routines of Ericson, Real-Time Collision Detection 5.1.5-5.1.6
+struct GJKSimplex {
+	struct Vertex {
+		Vec3 w, a, b;		// w = a - b
+	};
+
+	Vertex v[4];
+	float lambda[4];		// Barycentrics of the closest point
+	int count = 0;
+
+	void closestPoints(Vec3& pointA, Vec3& pointB) const {
+		pointA = Vec3(0.f, 0.f, 0.f);
+		pointB = Vec3(0.f, 0.f, 0.f);
+		for (int i = 0; i < count; i++) {
+			pointA += v[i].a * lambda[i];
+			pointB += v[i].b * lambda[i];
+		}
+	}
+
+	// Reduces the simplex to the feature holding the point closest to the origin and returns that point in closest.
+	// False when the origin is inside the tetrahedron
+	bool solve(Vec3& closest) {
+		switch (count) {
+			case 1: lambda[0] = 1.f; break;
+			case 2: solveSegment(0, 1); break;
+			case 3: solveTriangle(0, 1, 2); break;
+			default: if (!solveTetrahedron()) return false; break;
+		}
+		closest = Vec3(0.f, 0.f, 0.f);
+		for (int i = 0; i < count; i++) closest += v[i].w * lambda[i];
+		return true;
+	}
+
+private:
+	void keep(int i0) {
+		Vertex a = v[i0];
+		v[0] = a;
+		lambda[0] = 1.f;
+		count = 1;
+	}
+
+	void keep(int i0, int i1, float t) {
+		Vertex a = v[i0], b = v[i1];
+		v[0] = a;
+		v[1] = b;
+		lambda[0] = 1.f - t;
+		lambda[1] = t;
+		count = 2;
+	}
+
+	void solveSegment(int i0, int i1) {
+		Vec3 a = v[i0].w, ab = v[i1].w - a;
+		float t = -Dot(a, ab), dd = Dot(ab, ab);
+		if (t <= 0.f) keep(i0);
+		else if (t >= dd) keep(i1);
+		else keep(i0, i1, t / dd);
+	}
+
+	void solveTriangle(int i0, int i1, int i2) {
+		Vec3 a = v[i0].w, b = v[i1].w, c = v[i2].w;
+		Vec3 ab = b - a, ac = c - a;
+		float d1 = -Dot(ab, a), d2 = -Dot(ac, a);
+		if (d1 <= 0.f && d2 <= 0.f) { keep(i0); return; }
+		float d3 = -Dot(ab, b), d4 = -Dot(ac, b);
+		if (d3 >= 0.f && d4 <= d3) { keep(i1); return; }
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) { keep(i0, i1, d1 / (d1 - d3)); return; }
+		float d5 = -Dot(ab, c), d6 = -Dot(ac, c);
+		if (d6 >= 0.f && d5 <= d6) { keep(i2); return; }
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) { keep(i0, i2, d2 / (d2 - d6)); return; }
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f) { keep(i1, i2, (d4 - d3) / ((d4 - d3) + (d5 - d6))); return; }
+
+		float denominator = 1.f / (va + vb + vc);
+		Vertex va0 = v[i0], vb0 = v[i1], vc0 = v[i2];
+		v[0] = va0;
+		v[1] = vb0;
+		v[2] = vc0;
+		lambda[1] = vb * denominator;
+		lambda[2] = vc * denominator;
+		lambda[0] = 1.f - lambda[1] - lambda[2];
+		count = 3;
+	}
+
+	// Faces the origin lies outside of (or every face of a flat tetrahedron) are solved as triangles, the nearest wins
+	bool solveTetrahedron() {
+		const int faces[4][4] = { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } };
+		Vertex all[4] = { v[0], v[1], v[2], v[3] };
+		float volume = Dot(all[3].w - all[0].w, Cross(all[1].w - all[0].w, all[2].w - all[0].w));
+		float scale = std::max<float>(std::max<float>(all[0].w.lengthSquare(), all[1].w.lengthSquare()), std::max<float>(all[2].w.lengthSquare(), all[3].w.lengthSquare()));
+		bool flat = volume * volume <= 1e-12f * scale * scale * scale;
+
+		GJKSimplex best;
+		float bestDistance = FLT_MAX;
+		for (int f = 0; f < 4; f++) {
+			Vec3 a = all[faces[f][0]].w, b = all[faces[f][1]].w, c = all[faces[f][2]].w, d = all[faces[f][3]].w;
+			Vec3 n = Cross(b - a, c - a);
+			float sideOrigin = -Dot(a, n), sideOpposite = Dot(d - a, n);
+			if (!flat && sideOrigin * sideOpposite >= 0.f) continue;		// Origin on the inner side of this face
+			GJKSimplex candidate;
+			candidate.v[0] = all[faces[f][0]];
+			candidate.v[1] = all[faces[f][1]];
+			candidate.v[2] = all[faces[f][2]];
+			candidate.count = 3;
+			Vec3 closest;
+			candidate.solve(closest);
+			if (closest.lengthSquare() < bestDistance) {
+				bestDistance = closest.lengthSquare();
+				best = candidate;
+			}
+		}
+		if (bestDistance == FLT_MAX) return false;
+		*this = best;
+		return true;
+	}
+};
+
+// Distance between the cores of a and b. Returns false when the cores overlap (simplex then holds the origin).
+// Otherwise closest is the closest point of the core difference a - b to the origin, its length the core distance.
+// Stops early once the cores are proven further apart than stopDistance, closest is then only that proof: a vector
+// along the separating direction as long as the support lower bound, which is above stopDistance
+inline bool gjkCores(const ConvexShape& a, const ConvexShape& b, GJKSimplex& simplex, Vec3& closest, GJKCache& cache, float stopDistance = FLT_MAX) {
+	Vec3 v = cache.direction;
+	if (v.lengthSquare() == 0.f) v = a.centre() - b.centre();
+	if (v.lengthSquare() == 0.f) v = Vec3(1.f, 0.f, 0.f);
+	simplex.count = 0;
+	float scale = 0.f;
+	bool separated = true;
+
+	for (int iteration = 0; iteration < 64; iteration++) {
+		GJKSimplex::Vertex p;
+		p.a = a.supportCore(-v, cache.vertexA);
+		p.b = b.supportCore(v, cache.vertexB);
+		p.w = p.a - p.b;
+		float vv = Dot(v, v), vw = Dot(v, p.w);
+
+		// vw / |v| is a lower bound on the distance. v may still be the cached direction of an earlier query, so it is
+		// never the answer here, only the bound taken from the fresh support point
+		if (vw > 0.f && vw * vw > stopDistance * stopDistance * vv) {
+			cache.direction = v;
+			closest = v * (vw / vv);
+			return true;
+		}
+		if (simplex.count > 0 && vv - vw <= 1e-5f * vv) break;		// No progress, v is the closest point
+		bool repeated = false;
+		for (int i = 0; i < simplex.count; i++) repeated |= (simplex.v[i].w - p.w).lengthSquare() == 0.f;
+		if (repeated) break;
+
+		simplex.v[simplex.count++] = p;
+		scale = std::max<float>(scale, p.w.lengthSquare());
+		if (!simplex.solve(v) || Dot(v, v) <= 1e-10f * scale) {
+			separated = false;
+			break;
+		}
+	}
+	cache.direction = v;
+	closest = v;
+	return separated;
+}
+
+// Overlap test, stops as soon as one direction separates the shapes
+inline bool gjkOverlap(const ConvexShape& a, const ConvexShape& b, GJKCache* cache = nullptr) {
+	GJKCache local;
+	GJKCache& state = cache ? *cache : local;
+	GJKSimplex simplex;
+	Vec3 closest;
+	float reach = a.radius + b.radius;
+	if (!gjkCores(a, b, simplex, closest, state, reach)) return true;
+	return closest.lengthSquare() <= reach * reach;
+}
+
+// Distance between the shapes, 0 when they overlap. pointA and pointB are the closest points on each
+inline float gjkDistance(const ConvexShape& a, const ConvexShape& b, Vec3& pointA, Vec3& pointB, GJKCache* cache = nullptr) {
+	GJKCache local;
+	GJKCache& state = cache ? *cache : local;
+	GJKSimplex simplex;
+	Vec3 closest;
+	bool separated = gjkCores(a, b, simplex, closest, state);
+	simplex.closestPoints(pointA, pointB);
+	if (!separated) return 0.f;
+
+	float distance = closest.length();
+	Vec3 direction = -closest / distance;		// From a towards b
+	pointA = pointA + direction * a.radius;
+	pointB = pointB - direction * b.radius;
+	return std::max<float>(0.f, distance - a.radius - b.radius);
+}
+
+// EPA
+// Expanding polytope (van den Bergen): starting from a tetrahedron around the origin inside a - b, the face nearest
+// the origin is pushed out to the support point along its normal until that gains less than the tolerance. The
+// nearest face then gives the penetration normal and depth
+inline bool epaPenetration(const ConvexShape& a, const ConvexShape& b, GJKSimplex simplex, GJKCache& cache, ConvexContact& contact) {
+	struct Face {
+		int v[3];
+		Vec3 normal;
+		float distance;
+	};
+	std::vector<GJKSimplex::Vertex> points(simplex.v, simplex.v + simplex.count);
+	auto supportPoint = [&](const Vec3& d) {
+		GJKSimplex::Vertex p;
+		p.a = a.support(d, cache.vertexA);
+		p.b = b.support(-d, cache.vertexB);
+		p.w = p.a - p.b;
+		return p;
+	};
+
+	// Grow the GJK simplex to a tetrahedron, along the axes and whatever is perpendicular to what is there. A new
+	// point has to add a length, area or volume above a small fraction of the shapes' size
+	float size = std::max<float>(a.hull ? a.hull->sphere.radius : 0.f, (a.b - a.a).length()) + a.radius +
+				 std::max<float>(b.hull ? b.hull->sphere.radius : 0.f, (b.b - b.a).length()) + b.radius;
+	const Vec3 axes[6] = { Vec3(1.f, 0.f, 0.f), Vec3(-1.f, 0.f, 0.f), Vec3(0.f, 1.f, 0.f), Vec3(0.f, -1.f, 0.f), Vec3(0.f, 0.f, 1.f), Vec3(0.f, 0.f, -1.f) };
+	if (points.empty()) points.push_back(supportPoint(axes[0]));
+	for (int attempt = 0; points.size() < 4 && attempt < 12; attempt++) {
+		Vec3 d = axes[attempt % 6];
+		if (points.size() == 2) d = Cross(points[1].w - points[0].w, axes[attempt % 6]);
+		if (points.size() == 3) d = Cross(points[1].w - points[0].w, points[2].w - points[0].w) * (attempt % 2 ? -1.f : 1.f);
+		if (d.lengthSquare() == 0.f) continue;
+		GJKSimplex::Vertex p = supportPoint(d);
+		float gain = 0.f;
+		if (points.size() == 1) gain = (p.w - points[0].w).length();
+		else if (points.size() == 2) gain = Cross(p.w - points[0].w, points[1].w - points[0].w).length() / size;
+		else gain = fabsf(Dot(p.w - points[0].w, Cross(points[1].w - points[0].w, points[2].w - points[0].w))) / (size * size);
+		if (gain > 1e-5f * size) points.push_back(p);
+	}
+	if (points.size() < 4) {
+		// Flat difference (two coplanar flat hulls): touching with no depth
+		simplex.closestPoints(contact.pointA, contact.pointB);
+		contact.normal = Vec3(0.f, 1.f, 0.f);
+		contact.depth = 0.f;
+		return true;
+	}
+	points.resize(4);
+
+	std::vector<Face> faces;
+	float scale = 0.f;
+	for (const GJKSimplex::Vertex& p : points) scale = std::max<float>(scale, p.w.length());
+	float tolerance = 1e-4f * scale;
+	auto addFace = [&](int i0, int i1, int i2) {
+		Face face;
+		face.v[0] = i0;
+		face.v[1] = i1;
+		face.v[2] = i2;
+		face.normal = Cross(points[i1].w - points[i0].w, points[i2].w - points[i0].w);
+		float length = face.normal.length();
+		if (length > 0.f) {
+			face.normal = face.normal / length;
+			face.distance = Dot(face.normal, points[i0].w);
+		} else {
+			face.normal = Vec3(0.f, 0.f, 0.f);		// Sliver, never nearest and never visible
+			face.distance = FLT_MAX;
+		}
+		faces.push_back(face);
+	};
+	Vec3 inside = (points[0].w + points[1].w + points[2].w + points[3].w) * 0.25f;
+	const int tetrahedron[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 1, 3, 2 }, { 2, 3, 0 } };
+	for (int f = 0; f < 4; f++) {
+		int i0 = tetrahedron[f][0], i1 = tetrahedron[f][1], i2 = tetrahedron[f][2];
+		if (Dot(Cross(points[i1].w - points[i0].w, points[i2].w - points[i0].w), inside - points[i0].w) > 0.f) std::swap(i1, i2);
+		addFace(i0, i1, i2);
+	}
+
+	int nearest = 0;
+	std::vector<std::pair<int, int>> horizon;
+	for (int iteration = 0; iteration < 64; iteration++) {
+		nearest = 0;
+		for (int f = 1; f < (int)faces.size(); f++)
+			if (faces[f].distance < faces[nearest].distance) nearest = f;
+		Face face = faces[nearest];
+		GJKSimplex::Vertex p = supportPoint(face.normal);
+		if (Dot(p.w, face.normal) - face.distance <= tolerance) break;
+
+		// Remove the faces the new point sees, their unshared edges are the horizon it is joined to
+		int index = (int)points.size();
+		points.push_back(p);
+		horizon.clear();
+		for (int f = 0; f < (int)faces.size();) {
+			if (Dot(faces[f].normal, p.w - points[faces[f].v[0]].w) <= 0.f) { f++; continue; }
+			for (int e = 0; e < 3; e++) {
+				std::pair<int, int> edge(faces[f].v[e], faces[f].v[(e + 1) % 3]);
+				auto shared = std::find(horizon.begin(), horizon.end(), std::make_pair(edge.second, edge.first));
+				if (shared != horizon.end()) horizon.erase(shared);
+				else horizon.push_back(edge);
+			}
+			faces[f] = faces.back();
+			faces.pop_back();
+		}
+		for (const std::pair<int, int>& edge : horizon) addFace(edge.first, edge.second, index);
+		if (faces.empty()) return false;
+	}
+
+	// Deepest points from the barycentrics of the origin's projection on the nearest face
+	nearest = 0;
+	for (int f = 1; f < (int)faces.size(); f++)
+		if (faces[f].distance < faces[nearest].distance) nearest = f;
+	const Face& face = faces[nearest];
+	const GJKSimplex::Vertex& p0 = points[face.v[0]];
+	const GJKSimplex::Vertex& p1 = points[face.v[1]];
+	const GJKSimplex::Vertex& p2 = points[face.v[2]];
+	Vec3 q = face.normal * face.distance;
+	Vec3 e1 = p1.w - p0.w, e2 = p2.w - p0.w, e = q - p0.w;
+	float d11 = Dot(e1, e1), d12 = Dot(e1, e2), d22 = Dot(e2, e2), d1 = Dot(e, e1), d2 = Dot(e, e2);
+	float denominator = d11 * d22 - d12 * d12;
+	float u = 0.f, v = 0.f;
+	if (denominator > 0.f) {
+		u = (d22 * d1 - d12 * d2) / denominator;
+		v = (d11 * d2 - d12 * d1) / denominator;
+	}
+	contact.normal = face.normal;
+	contact.depth = face.distance;
+	contact.pointA = p0.a + (p1.a - p0.a) * u + (p2.a - p0.a) * v;
+	contact.pointB = p0.b + (p1.b - p0.b) * u + (p2.b - p0.b) * v;
+	return true;
+}
+
+// Penetration of overlapping shapes, false when they do not overlap. Cores that are apart but within the radii are
+// solved from the GJK closest points, EPA only runs when the cores themselves overlap
+inline bool gjkPenetration(const ConvexShape& a, const ConvexShape& b, ConvexContact& contact, GJKCache* cache = nullptr) {
+	GJKCache local;
+	GJKCache& state = cache ? *cache : local;
+	GJKSimplex simplex;
+	Vec3 closest;
+	float reach = a.radius + b.radius;
+	if (gjkCores(a, b, simplex, closest, state, reach)) {
+		float distance = closest.length();
+		if (distance > reach) return false;
+		Vec3 coreA, coreB;
+		simplex.closestPoints(coreA, coreB);
+		contact.normal = -closest / distance;
+		contact.depth = reach - distance;
+		contact.pointA = coreA + contact.normal * a.radius;
+		contact.pointB = coreB - contact.normal * b.radius;
+		return true;
+	}
+	return epaPenetration(a, b, simplex, state, contact);
+}
\ No newline at end of file
@@ -90,7 +90,7 @@ public:
 		psos->createPSO(core, "CubePSO", shaders->getShader(shadername)->vertexShader, shaders->getShader(shadername)->pixelShader, VertexLayoutCache::getStaticLayout());
 	}
 	
-	void draw(Core* core, PSOManager* psos, ShaderManager* shaders, Matrix& vp, Matrix& w) {
+	void draw(Core* core, PSOManager* psos, ShaderManager* shaders, Matrix& vp, const Matrix& w) {
 		psos->bind(core, "CubePSO");
 		shaders->updateConstantVertexShaderBuffer("Cube", "staticMeshBuffer", "W", &w);
 		shaders->updateConstantVertexShaderBuffer("Cube", "staticMeshBuffer", "VP", &vp);
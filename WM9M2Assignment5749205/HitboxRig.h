@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "Animation.h"
+#include "Collision.h"
+#include "GEMLoader.h"
+#include "MyMath.h"
+
+// Hitbox Rig
+// Capsules attached to the bones of a Skeleton, so shots and hits land on the limb they touch instead of a sphere
+// around the whole model. Each capsule is fitted once at load time to the bind pose vertices its bone dominates
+// (principal axis of the vertices, radius covering a fraction of them), no hitbox data has to be authored. Every
+// frame update poses all capsules from the skinning matrices in one pass over a flat array and refits a broad sphere
+// around the rig, and the queries reject on that sphere before looking at a single capsule
+
+struct RigHit {
+	float t;			// Distance along the ray, in units of the ray direction
+	int capsule;		// Position in HitboxRig::capsules
+	int bone;			// Skeleton bone the capsule follows
+};
+
+class HitboxRig {
+public:
+	// Capsule in bind pose mesh space, kept as centre and half axis so posing is one point and one vector
+	struct BoneCapsule {
+		Vec3 centre;
+		Vec3 halfAxis;
+		float radius;
+		int bone;
+	};
+
+	std::vector<BoneCapsule> bindCapsules;
+	std::vector<Capsule> capsules;				// World space pose from the last update, same order as bindCapsules
+	std::vector<BoundingSphere> capsuleBounds;	// Sphere around each posed capsule, the per capsule rejection
+	BoundingSphere broad;						// Around the whole posed rig
+
+	// One capsule per bone that dominates at least minVertices vertices (bones that only steer others, like IK
+	// controls, get none). coverage is the fraction of those vertices the radius reaches, below 1 so a few
+	// stretched vertices at the joints do not inflate the limb
+	void build(const Skeleton& skeleton, const std::vector<GEMLoader::GEMMesh>& meshes, float coverage = 0.9f, int minVertices = 8) {
+		std::vector<std::vector<Vec3>> boneVertices(skeleton.bones.size());
+		for (const GEMLoader::GEMMesh& mesh : meshes) {
+			for (const GEMLoader::GEMAnimatedVertex& vertex : mesh.verticesAnimated) {
+				int dominant = 0;
+				for (int i = 1; i < 4; i++)
+					if (vertex.boneWeights[i] > vertex.boneWeights[dominant]) dominant = i;
+				unsigned int bone = vertex.bonesIDs[dominant];
+				if (bone < boneVertices.size()) boneVertices[bone].push_back(Vec3(vertex.position.x, vertex.position.y, vertex.position.z));
+			}
+		}
+
+		bindCapsules.clear();
+		std::vector<float> distances;
+		for (int bone = 0; bone < (int)boneVertices.size(); bone++) {
+			const std::vector<Vec3>& points = boneVertices[bone];
+			if ((int)points.size() < minVertices) continue;
+
+			Vec3 mean(0.f, 0.f, 0.f);
+			for (const Vec3& p : points) mean += p;
+			mean = mean / (float)points.size();
+
+			// Principal axis: power iteration on the covariance, started from its largest column
+			Vec3 covariance[3] = { Vec3(0.f, 0.f, 0.f), Vec3(0.f, 0.f, 0.f), Vec3(0.f, 0.f, 0.f) };
+			for (const Vec3& p : points) {
+				Vec3 d = p - mean;
+				for (int i = 0; i < 3; i++) covariance[i] += d * d.v[i];
+			}
+			int largest = 0;
+			for (int i = 1; i < 3; i++)
+				if (covariance[i].v[i] > covariance[largest].v[i]) largest = i;
+			Vec3 axis = covariance[largest];
+			for (int i = 0; i < 16 && axis.lengthSquare() > 0.f; i++) {
+				axis = axis.normalize();
+				axis = covariance[0] * axis.x + covariance[1] * axis.y + covariance[2] * axis.z;
+			}
+			axis = axis.lengthSquare() > 0.f ? axis.normalize() : Vec3(0.f, 1.f, 0.f);
+
+			// Extent along the axis and distance from it
+			float sMin = FLT_MAX, sMax = -FLT_MAX;
+			distances.clear();
+			for (const Vec3& p : points) {
+				Vec3 d = p - mean;
+				float s = Dot(d, axis);
+				sMin = std::min<float>(sMin, s);
+				sMax = std::max<float>(sMax, s);
+				distances.push_back(std::max<float>(0.f, d.lengthSquare() - s * s));
+			}
+			int k = std::min<int>((int)distances.size() - 1, (int)(coverage * (float)distances.size()));
+			std::nth_element(distances.begin(), distances.begin() + k, distances.end());
+
+			BoneCapsule capsule;
+			capsule.radius = sqrtf(distances[k]);
+			capsule.centre = mean + axis * ((sMin + sMax) * 0.5f);
+			capsule.halfAxis = axis * std::max<float>(0.f, (sMax - sMin) * 0.5f - capsule.radius);	// Caps end at the extent
+			capsule.bone = bone;
+			bindCapsules.push_back(capsule);
+		}
+		capsules.resize(bindCapsules.size());
+		capsuleBounds.resize(bindCapsules.size());
+		broad.centre = Vec3(0.f, 0.f, 0.f);
+		broad.radius = 0.f;
+	}
+
+	// Poses the rig with AnimationInstance::matrices (skinning matrices, which take bind pose mesh space to the
+	// animated pose) and the world matrix the model is drawn with. Radii scale with the world matrix only, it is
+	// expected to scale uniformly and the skinning matrices to be rigid
+	void update(const Matrix* boneMatrices, const Matrix& world) {
+		float scale = Vec3(world.m[0], world.m[4], world.m[8]).length();
+		Affine toWorld(world);		// Inlined 3x4 products, the Matrix ones go through the kernel table per call
+		AABB box;
+		for (size_t i = 0; i < bindCapsules.size(); i++) {
+			const BoneCapsule& bind = bindCapsules[i];
+			Affine skin(boneMatrices[bind.bone]);
+			Vec3 centre = toWorld.mulPoint(skin.mulPoint(bind.centre));
+			Vec3 half = toWorld.mulVec(skin.mulVec(bind.halfAxis));
+
+			Capsule& capsule = capsules[i];
+			capsule.a = centre - half;
+			capsule.b = centre + half;
+			capsule.radius = bind.radius * scale;
+
+			BoundingSphere& bounds = capsuleBounds[i];
+			bounds.centre = centre;
+			bounds.radius = half.length() + capsule.radius;
+			Vec3 reach(bounds.radius, bounds.radius, bounds.radius);
+			box.extend(centre - reach);
+			box.extend(centre + reach);
+		}
+
+		broad.centre = box.centre();
+		broad.radius = 0.f;
+		for (const BoundingSphere& bounds : capsuleBounds)
+			broad.radius = std::max<float>(broad.radius, (bounds.centre - broad.centre).length() + bounds.radius);
+	}
+
+	// Nearest capsule along the ray within [0, tMax]
+	bool raycast(const Ray& ray, RigHit& hit, float tMax = FLT_MAX) const {
+		hit.capsule = -1;
+		if (!reaches(ray, broad, tMax)) return false;
+		float best = tMax;
+		for (size_t i = 0; i < capsules.size(); i++) {
+			float t;
+			if (!reaches(ray, capsuleBounds[i], best) || !capsules[i].rayCapsule(ray, t, best)) continue;
+			best = t;
+			hit.capsule = (int)i;
+		}
+		if (hit.capsule < 0) return false;
+		hit.t = best;
+		hit.bone = bindCapsules[hit.capsule].bone;
+		return true;
+	}
+
+	// First capsule touching sphere (e.g. a bite or a player), -1 when none does
+	int overlap(const BoundingSphere& sphere) const {
+		if (!collisionSphereSphere(sphere, broad)) return -1;
+		for (size_t i = 0; i < capsules.size(); i++)
+			if (collisionSphereSphere(sphere, capsuleBounds[i]) && collisionSphereCapsule(sphere, capsules[i])) return (int)i;
+		return -1;
+	}
+
+	// First capsule touching capsule (e.g. a melee swing), -1 when none does
+	int overlap(const Capsule& capsule) const {
+		BoundingSphere bounds = capsule.bounds();
+		if (!collisionSphereSphere(bounds, broad)) return -1;
+		for (size_t i = 0; i < capsules.size(); i++)
+			if (collisionSphereSphere(bounds, capsuleBounds[i]) && collisionCapsuleCapsule(capsule, capsules[i])) return (int)i;
+		return -1;
+	}
+
+private:
+	// Whether the ray can enter sphere before tMax (conservative, only used to skip exact tests)
+	static bool reaches(const Ray& ray, const BoundingSphere& sphere, float tMax) {
+		Vec3 m = ray.o - sphere.centre;
+		float b = Dot(m, ray.dir), c = m.lengthSquare() - sphere.radius * sphere.radius;
+		if (c <= 0.f) return true;
+		if (b > 0.f) return false;
+		float a = Dot(ray.dir, ray.dir), discriminant = b * b - a * c;
+		return discriminant >= 0.f && -b - sqrtf(discriminant) <= tMax * a;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Collision.h"
+#include "GEMLoader.h"
+#include "MyMath.h"
+
+// Triangle Mesh Raycasting
+// Rays (bullets, line of sight) against the real triangles of static GEM models instead of their boxes. Each model
+// gets one triangle BVH in model space when it is loaded, and every leaf holds up to 8 triangles transposed into a
+// packet, so a leaf costs one 8-wide Moller-Trumbore test. Instances share their model's BVH: the ray is taken into
+// model space with the instance's inverse world matrix instead of transforming any triangles
+
+struct TriangleHit {
+	float t;			// Distance along the ray, in units of the ray direction
+	float u, v;			// Barycentrics, the hit point is v0 * (1 - u - v) + v1 * u + v2 * v
+	Vec3 normal;		// Geometric normal (v1 - v0) x (v2 - v0), in the space of the query ray
+	int triangle;		// Triangle of the mesh, its vertices are indices[3 * triangle + 0..2]
+	int mesh;			// GEM mesh the triangle belongs to, which also picks its material
+	int instance;		// Instance hit by raycastInstances, -1 for the other queries
+};
+
+// 8 triangles as a first vertex and two edges per lane. Unused lanes have zero edges and never hit
+struct TrianglePacket {
+	static const int width = 8;
+
+	Vec3x8 v0, e1, e2;
+	int triangle[width];
+
+	// Moller-Trumbore on all lanes (two sided). The nearest hit in [0, tMax] lowers tMax and its barycentrics go
+	// to u and v, returns its lane or -1
+	int intersect(const Ray& r, float& tMax, float& u, float& v) const {
+		Vec3x8 d(r.dir);
+		Vec3x8 p = Cross(d, e2);
+		Floatx8 det = Dot(e1, p);
+		Floatx8 invDet = Floatx8(1.f) / det;
+		Vec3x8 s = Vec3x8(r.o) - v0;
+		Floatx8 lu = Dot(s, p) * invDet;
+		Vec3x8 q = Cross(s, e1);
+		Floatx8 lv = Dot(d, q) * invDet;
+		Floatx8 lt = Dot(e2, q) * invDet;
+
+		Floatx8 zero(0.f);
+		int mask = ((det != zero) & (lu >= zero) & (lv >= zero) & (lu + lv <= Floatx8(1.f)) & (lt >= zero) & (lt <= Floatx8(tMax))).mask();
+		if (mask == 0) return -1;
+
+		float ts[width], us[width], vs[width];
+		lt.store(ts);
+		lu.store(us);
+		lv.store(vs);
+		int lane = -1;
+		for (int i = 0; i < width; i++) {
+			if (!((mask >> i) & 1) || ts[i] > tMax) continue;
+			tMax = ts[i];
+			lane = i;
+		}
+		u = us[lane];
+		v = vs[lane];
+		return lane;
+	}
+};
+
+class TriangleBVH {
+public:
+	BVH bvh;								// Over the triangle bounds, leaves of up to 8 triangles
+	std::vector<TrianglePacket> packets;
+	std::vector<int> leafPackets;			// leafPackets[first] is the packet of the leaf starting at primitive first
+
+	void build(const Vec3* positions, const unsigned int* indices, int triangleCount) {
+		std::vector<AABB> boxes(triangleCount);
+		for (int i = 0; i < triangleCount; i++) {
+			boxes[i].extend(positions[indices[3 * i]]);
+			boxes[i].extend(positions[indices[3 * i + 1]]);
+			boxes[i].extend(positions[indices[3 * i + 2]]);
+		}
+		bvh.build(boxes, TrianglePacket::width, true);
+
+		packets.clear();
+		leafPackets.assign(triangleCount, -1);
+		for (const BVH::Node& node : bvh.nodes) {
+			if (node.count == 0) continue;
+			Vec3 v0[TrianglePacket::width], e1[TrianglePacket::width], e2[TrianglePacket::width];
+			TrianglePacket packet;
+			for (int i = 0; i < TrianglePacket::width; i++) {
+				packet.triangle[i] = -1;
+				if (i >= node.count) continue;
+				int triangle = bvh.indices[node.first + i];
+				const Vec3& a = positions[indices[3 * triangle]];
+				v0[i] = a;
+				e1[i] = positions[indices[3 * triangle + 1]] - a;
+				e2[i] = positions[indices[3 * triangle + 2]] - a;
+				packet.triangle[i] = triangle;
+			}
+			packet.v0 = Vec3x8::load(v0, node.count);
+			packet.e1 = Vec3x8::load(e1, node.count);
+			packet.e2 = Vec3x8::load(e2, node.count);
+			leafPackets[node.first] = (int)packets.size();
+			packets.push_back(packet);
+		}
+
+		// The walk only needs the nodes, the packets replace the per-triangle boxes
+		std::vector<AABB>().swap(bvh.primitives);
+		std::vector<int>().swap(bvh.indices);
+	}
+
+	// Nearest triangle within [0, tMax], hit.triangle is its position in the build input (mesh and instance unset)
+	bool closestHit(const Ray& ray, TriangleHit& hit, float tMax = FLT_MAX) const {
+		hit.triangle = -1;
+		float best = tMax;
+		bvh.traverseRay(ray, best, [&](int first, int, float& limit) {
+			const TrianglePacket& packet = packets[leafPackets[first]];
+			float u, v;
+			int lane = packet.intersect(ray, limit, u, v);
+			if (lane >= 0) {
+				hit.triangle = packet.triangle[lane];
+				hit.u = u;
+				hit.v = v;
+				hit.normal = Cross(packet.e1.lane(lane), packet.e2.lane(lane));
+			}
+			return false;
+		});
+		hit.t = best;
+		return hit.triangle >= 0;
+	}
+
+	// Whether any triangle is hit within [0, tMax], returns on the first hit
+	bool anyHit(const Ray& ray, float tMax = FLT_MAX) const {
+		float best = tMax;
+		bool found = false;
+		bvh.traverseRay(ray, best, [&](int first, int, float& limit) {
+			float u, v;
+			found = packets[leafPackets[first]].intersect(ray, limit, u, v) >= 0;
+			return found;
+		});
+		return found;
+	}
+};
+
+// Triangles of every static mesh of a GEM model in one BVH, built by the model classes at load time
+class MeshCollider {
+public:
+	TriangleBVH triangles;
+	std::vector<int> meshFirstTriangle;		// First triangle of each mesh in the combined numbering, then the total
+	std::vector<std::string> materials;		// Albedo texture of each mesh
+
+	// Animated meshes are skipped (their pose changes every frame), they keep their slot so hit.mesh still
+	// matches the model's mesh order
+	void build(const std::vector<GEMLoader::GEMMesh>& meshes) {
+		std::vector<Vec3> positions;
+		std::vector<unsigned int> indices;
+		meshFirstTriangle.clear();
+		materials.clear();
+		for (const GEMLoader::GEMMesh& mesh : meshes) {
+			GEMLoader::GEMMaterial material = mesh.material;		// find is not const
+			meshFirstTriangle.push_back((int)indices.size() / 3);
+			materials.push_back(material.find("albedo").getValue());
+			if (mesh.verticesStatic.empty()) continue;
+
+			unsigned int base = (unsigned int)positions.size();
+			for (const GEMLoader::GEMStaticVertex& vertex : mesh.verticesStatic) positions.push_back(Vec3(vertex.position.x, vertex.position.y, vertex.position.z));
+			for (unsigned int index : mesh.indices) indices.push_back(base + index);
+		}
+		meshFirstTriangle.push_back((int)indices.size() / 3);
+		triangles.build(positions.empty() ? nullptr : &positions[0], indices.empty() ? nullptr : &indices[0], (int)indices.size() / 3);
+	}
+
+	// Nearest triangle along a model space ray
+	bool raycast(const Ray& ray, TriangleHit& hit, float tMax = FLT_MAX) const {
+		if (!triangles.closestHit(ray, hit, tMax)) return false;
+		hit.mesh = (int)(std::upper_bound(meshFirstTriangle.begin(), meshFirstTriangle.end(), hit.triangle) - meshFirstTriangle.begin()) - 1;
+		hit.triangle -= meshFirstTriangle[hit.mesh];
+		hit.instance = -1;
+		return true;
+	}
+
+	// One placed copy of the model. The ray goes into model space through worldInverse, t is unchanged (a point
+	// at t on the local ray is the model space image of the point at t on the world ray) and the normal comes back
+	// to world space through the inverse transpose
+	bool raycast(const Ray& ray, const Matrix& worldInverse, TriangleHit& hit, float tMax = FLT_MAX) const {
+		Ray local(worldInverse.mulPoint(ray.o), worldInverse.mulVec(ray.dir));
+		if (!raycast(local, hit, tMax)) return false;
+		Vec3 n = hit.normal;
+		hit.normal = Vec3(worldInverse.m[0] * n.x + worldInverse.m[4] * n.y + worldInverse.m[8] * n.z,
+						  worldInverse.m[1] * n.x + worldInverse.m[5] * n.y + worldInverse.m[9] * n.z,
+						  worldInverse.m[2] * n.x + worldInverse.m[6] * n.y + worldInverse.m[10] * n.z);
+		return true;
+	}
+
+	// Every instance of the model (e.g. the instanced trees). instances is a BVH over the world bounds of each
+	// instance, built in the same order as worldInverses, so only instances whose bounds the ray reaches are
+	// tested, nearest first, each one clipped to the best hit so far
+	bool raycastInstances(const Ray& ray, const BVH& instances, const Matrix* worldInverses, TriangleHit& hit, float tMax = FLT_MAX) const {
+		hit.instance = -1;
+		float best = tMax;
+		instances.traverseRay(ray, best, [&](int first, int count, float& limit) {
+			for (int i = first; i < first + count; i++) {
+				int instance = instances.indices[i];
+				TriangleHit candidate;
+				if (!raycast(ray, worldInverses[instance], candidate, limit)) continue;
+				hit = candidate;
+				hit.instance = instance;
+				limit = candidate.t;
+			}
+			return false;
+		});
+		return hit.instance >= 0;
+	}
+};
+
+// Model Bounds
+// Tight model space bounds of every mesh and of the whole model, fitted to the vertices once at load time (the bind
+// pose for animated models). Spheres use Ritter by default, exact asks for Welzl's minimal spheres
+class ModelBounds {
+public:
+	AABB box;
+	BoundingSphere sphere;
+	std::vector<AABB> meshBoxes;
+	std::vector<BoundingSphere> meshSpheres;
+
+	void compute(const std::vector<GEMLoader::GEMMesh>& meshes, bool exact = false) {
+		std::vector<Vec3> all, positions;
+		meshBoxes.clear();
+		meshSpheres.clear();
+		for (const GEMLoader::GEMMesh& mesh : meshes) {
+			positions.clear();
+			for (const GEMLoader::GEMStaticVertex& vertex : mesh.verticesStatic) positions.push_back(Vec3(vertex.position.x, vertex.position.y, vertex.position.z));
+			for (const GEMLoader::GEMAnimatedVertex& vertex : mesh.verticesAnimated) positions.push_back(Vec3(vertex.position.x, vertex.position.y, vertex.position.z));
+
+			const Vec3* p = positions.empty() ? nullptr : &positions[0];
+			meshBoxes.push_back(computeAABB(p, (int)positions.size()));
+			meshSpheres.push_back(exact ? welzlSphere(p, (int)positions.size()) : ritterSphere(p, (int)positions.size()));
+			all.insert(all.end(), positions.begin(), positions.end());
+		}
+
+		const Vec3* p = all.empty() ? nullptr : &all[0];
+		box = computeAABB(p, (int)all.size());
+		sphere = exact ? welzlSphere(p, (int)all.size()) : ritterSphere(p, (int)all.size());
+	}
+};
\ No newline at end of file
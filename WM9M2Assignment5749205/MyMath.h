@@ -3,22 +3,144 @@
 #define _USE_MATH_DEFINES
 
 #include <cmath>
+#include <cstring>
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <type_traits>
+
+// SIMD kernels are only compiled for x86/x64, every other target uses the scalar path
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MYMATH_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MYMATH_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define MYMATH_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
 
 #define SQ(x)(x * x)
 #define M_PI 3.14159265358979323846
 
+// True while the compiler is evaluating a constant expression, lets constexpr functions use a
+// compile-time friendly path there and the faster runtime one (libm, SIMD kernels) everywhere else
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+#define MYMATH_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+#define MYMATH_CONSTANT_EVALUATED() false
+#endif
+
+// Constexpr Trigonometry / Square Root
+// Compile time: range reduction to [-pi/2, pi/2] and a Taylor series in double (error < 1e-11),
+// runtime: the standard library
+static constexpr double sinTaylor(double x) {
+	// Reduce to [-pi, pi] and then use sin(x) = sin(pi - x) to reach [-pi/2, pi/2]
+	double k = x * (0.5 / M_PI);
+	long long n = static_cast<long long>(k >= 0 ? k + 0.5 : k - 0.5);
+	x -= static_cast<double>(n) * (2.0 * M_PI);
+	if (x > M_PI / 2) x = M_PI - x;
+	else if (x < -M_PI / 2) x = -M_PI - x;
+
+	double x2 = x * x, term = x, sum = x;
+	for (int i = 1; i <= 8; i++) {
+		term *= -x2 / ((2 * i) * (2 * i + 1));
+		sum += term;
+	}
+	return sum;
+}
+
+static constexpr float constexprSin(const float x) {
+	if (MYMATH_CONSTANT_EVALUATED()) return static_cast<float>(sinTaylor(x));
+	return sinf(x);
+}
+
+static constexpr float constexprCos(const float x) {
+	if (MYMATH_CONSTANT_EVALUATED()) return static_cast<float>(sinTaylor(static_cast<double>(x) + M_PI / 2));
+	return cosf(x);
+}
+
+static constexpr float constexprSqrt(const float x) {
+	if (MYMATH_CONSTANT_EVALUATED()) {
+		// Newton-Raphson from an initial guess of max(x, 1), converges monotonically from above
+		if (x <= 0.f) return 0.f;
+		double r = x > 1.f ? x : 1.0, prev = 0.0;
+		while (r != prev) { prev = r; r = 0.5 * (r + x / r); }
+		return static_cast<float>(r);
+	}
+	return sqrtf(x);
+}
+
+// Math Policies
+// Compile-time choice for the transcendental functions: PreciseMath is the standard library (single precision
+// overloads, constexpr-friendly sin/cos), FastMath is branch-free minimax polynomials with no library calls, so
+// loops over them vectorize. Builders and conversions take the policy as a template argument defaulting to
+// PreciseMath, hot paths opt in with e.g. Matrix::rotateOnYAxis<FastMath>(angle).
+// FastMath max error (measured against double precision):
+//   sin, cos, sincos: 1.6e-7 absolute for |x| <= 8192, range reduced to [-pi/4, pi/4] with a two part pi/2
+//   acos:             4.4e-7 rad on [-1, 1] (Abramowitz & Stegun 4.4.46)
+//   atan2:            3.2e-7 rad (Abramowitz & Stegun 4.4.49 on [0, 1] plus octant reflection)
+struct PreciseMath {
+	static constexpr float sin(const float x) { return constexprSin(x); }
+	static constexpr float cos(const float x) { return constexprCos(x); }
+	static constexpr void sincos(const float x, float& s, float& c) { s = constexprSin(x); c = constexprCos(x); }
+	static float acos(const float x) { return acosf(x); }
+	static float atan2(const float y, const float x) { return atan2f(y, x); }
+};
+
+struct FastMath {
+	static constexpr void sincos(const float x, float& s, float& c) {
+		// x = q * pi/2 + r with |r| <= pi/4, q is rounded with an offset so the truncating cast never sees a negative
+		int q = static_cast<int>(x * 0.636619772f + 16384.5f) - 16384;
+		float r = (x - q * 1.5703125f) - q * 4.83826794897e-4f;
+		float r2 = r * r;
+
+		float sr = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+		float cr = 1.f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+
+		// Quadrant without branches (random angles mispredict): sin = {sr, cr, -sr, -cr}[q & 3], cos = {cr, -sr, -cr, sr}[q & 3]
+		// as sums of sr and cr times 0 or +-1, which is exact
+		int odd = q & 1, sign = 1 - (q & 2);
+		float even = static_cast<float>((1 - odd) * sign), swapped = static_cast<float>(odd * sign);
+		s = sr * even + cr * swapped;
+		c = cr * even - sr * swapped;
+	}
+
+	static constexpr float sin(const float x) { float s = 0.f, c = 0.f; sincos(x, s, c); return s; }
+	static constexpr float cos(const float x) { float s = 0.f, c = 0.f; sincos(x, s, c); return c; }
+
+	static constexpr float acos(const float x) {
+		float ax = x < 0.f ? -x : x;
+		ax = ax > 1.f ? 1.f : ax;
+		float p = 1.5707963050f + ax * (-0.2145988016f + ax * (0.0889789874f + ax * (-0.0501743046f + ax * (0.0308918810f
+			+ ax * (-0.0170881256f + ax * (0.0066700901f + ax * -0.0012624911f))))));
+		float r = constexprSqrt(1.f - ax) * p;
+		return x < 0.f ? 3.14159265f - r : r;
+	}
+
+	static constexpr float atan2(const float y, const float x) {
+		float ax = x < 0.f ? -x : x, ay = y < 0.f ? -y : y;
+		float hi = ax > ay ? ax : ay, lo = ax > ay ? ay : ax;
+		float z = hi > 0.f ? lo / hi : 0.f, z2 = z * z;
+		float r = z * (1.f + z2 * (-0.3333314528f + z2 * (0.1999355085f + z2 * (-0.1420889944f + z2 * (0.1065626393f
+			+ z2 * (-0.0752896400f + z2 * (0.0429096138f + z2 * (-0.0161657367f + z2 * 0.0028662257f))))))));
+		r = ay > ax ? 1.57079633f - r : r;
+		r = x < 0.f ? 3.14159265f - r : r;
+		return y < 0.f ? -r : r;
+	}
+};
+
 // Clamping
 template <typename Type>
-static Type clamp(const Type value, const Type minValue, const Type maxValue) {
+static constexpr Type clamp(const Type value, const Type minValue, const Type maxValue) {
 	return std::max<Type>(std::min<Type>(value, maxValue), minValue);
 }
 
 // Linear Interpolation
 template<typename Type>
-static Type lerp(const Type a, const Type b, float t) {
+static constexpr Type lerp(const Type a, const Type b, float t) {
 	return a * (1.f - t) + (b * t);
 }
 
@@ -37,6 +159,126 @@ Type perspectiveCorrectInterpolateAttribute(Type a0, Type a1, Type a2, float v0_
 	return (t0 + t1 + t2) / frag_w;
 }
 
+// Expression Templates (optional)
+// Define MYMATH_EXPRESSION_TEMPLATES before including MyMath.h to make +, -, *, / and unary - on Vec3, Vec4 and
+// Colour return small expression nodes instead of new objects. The chain is evaluated one component at a time
+// when it is assigned to a Vec3/Vec4/Colour, so (p1 * (1.f - t)) + (p2 * t) becomes a single fused pass with the
+// same per-component arithmetic (and results) as before. Nodes reference their vector operands, store results
+// in a Vec3/Vec4/Colour rather than in auto.
+#if defined(MYMATH_EXPRESSION_TEMPLATES)
+class Vec3;
+class Vec4;
+class Colour;
+
+// Element-wise operations
+struct ExprAdd { static constexpr float apply(float a, float b) { return a + b; } };
+struct ExprSub { static constexpr float apply(float a, float b) { return a - b; } };
+struct ExprMul { static constexpr float apply(float a, float b) { return a * b; } };
+struct ExprDiv { static constexpr float apply(float a, float b) { return a / b; } };
+
+// Common part of every node: evaluation and the methods used directly on arithmetic results
+template<typename Derived, typename V>
+struct ExprBase {
+	constexpr V eval() const { return V(static_cast<const Derived&>(*this)); }
+	float length() const { return eval().length(); }
+	constexpr float lengthSquare() const { return eval().lengthSquare(); }
+	V normalize() const { return eval().normalize(); }
+	constexpr float Dot(const V& v) const { return eval().Dot(v); }
+	constexpr V Cross(const V& v) const { return eval().Cross(v); }
+	constexpr float Max() const { return eval().Max(); }
+	constexpr float Min() const { return eval().Min(); }
+};
+
+// Nodes
+template<typename V>
+struct ExprLeaf : ExprBase<ExprLeaf<V>, V> {
+	const V& v;
+	constexpr ExprLeaf(const V& _v) : v(_v) {}
+	constexpr float component(int i) const { return v.component(i); }
+};
+
+template<typename L, typename R, typename Op, typename V>
+struct ExprBinary : ExprBase<ExprBinary<L, R, Op, V>, V> {
+	L l; R r;
+	constexpr ExprBinary(const L& _l, const R& _r) : l(_l), r(_r) {}
+	constexpr float component(int i) const { return Op::apply(l.component(i), r.component(i)); }
+};
+
+template<typename L, typename Op, typename V>
+struct ExprScalar : ExprBase<ExprScalar<L, Op, V>, V> {
+	L l; float s;
+	constexpr ExprScalar(const L& _l, float _s) : l(_l), s(_s) {}
+	constexpr float component(int i) const { return Op::apply(l.component(i), s); }
+};
+
+template<typename L, typename V>
+struct ExprNegate : ExprBase<ExprNegate<L, V>, V> {
+	L l;
+	constexpr ExprNegate(const L& _l) : l(_l) {}
+	constexpr float component(int i) const { return -l.component(i); }
+};
+
+// ExprTraits<T>::value is the vector type T evaluates to, node is how T is held inside a parent node
+// (vectors by reference, nodes by value), types without traits never match the operators below
+template<typename T> struct ExprTraits {};
+
+template<typename V>
+struct ExprVectorTraits {
+	typedef V value;
+	typedef ExprLeaf<V> node;
+	static constexpr node wrap(const V& v) { return node(v); }
+};
+
+template<> struct ExprTraits<Vec3> : ExprVectorTraits<Vec3> {};
+template<> struct ExprTraits<Vec4> : ExprVectorTraits<Vec4> {};
+template<> struct ExprTraits<Colour> : ExprVectorTraits<Colour> {};
+
+template<typename N, typename V>
+struct ExprNodeTraits {
+	typedef V value;
+	typedef N node;
+	static constexpr const N& wrap(const N& n) { return n; }
+};
+
+template<typename V> struct ExprTraits<ExprLeaf<V>> : ExprNodeTraits<ExprLeaf<V>, V> {};
+template<typename L, typename R, typename Op, typename V> struct ExprTraits<ExprBinary<L, R, Op, V>> : ExprNodeTraits<ExprBinary<L, R, Op, V>, V> {};
+template<typename L, typename Op, typename V> struct ExprTraits<ExprScalar<L, Op, V>> : ExprNodeTraits<ExprScalar<L, Op, V>, V> {};
+template<typename L, typename V> struct ExprTraits<ExprNegate<L, V>> : ExprNodeTraits<ExprNegate<L, V>, V> {};
+
+// True when E is an expression (not the vector itself) evaluating to V, used by the converting constructors
+template<typename E, typename V, typename = void>
+struct IsExprOf : std::false_type {};
+
+template<typename E, typename V>
+struct IsExprOf<E, V, typename std::enable_if<std::is_same<typename ExprTraits<E>::value, V>::value && !std::is_same<E, V>::value>::type> : std::true_type {};
+
+// Operators (both sides must evaluate to the same vector type)
+#define MYMATH_EXPR_BINARY(op, Op) \
+	template<typename A, typename B, typename V = typename ExprTraits<A>::value, typename = typename std::enable_if<std::is_same<V, typename ExprTraits<B>::value>::value>::type> \
+	constexpr ExprBinary<typename ExprTraits<A>::node, typename ExprTraits<B>::node, Op, V> operator op(const A& a, const B& b) { \
+		return ExprBinary<typename ExprTraits<A>::node, typename ExprTraits<B>::node, Op, V>(ExprTraits<A>::wrap(a), ExprTraits<B>::wrap(b)); \
+	}
+
+#define MYMATH_EXPR_SCALAR(op, Op) \
+	template<typename A, typename V = typename ExprTraits<A>::value> \
+	constexpr ExprScalar<typename ExprTraits<A>::node, Op, V> operator op(const A& a, const float s) { \
+		return ExprScalar<typename ExprTraits<A>::node, Op, V>(ExprTraits<A>::wrap(a), s); \
+	}
+
+MYMATH_EXPR_BINARY(+, ExprAdd)
+MYMATH_EXPR_BINARY(-, ExprSub)
+MYMATH_EXPR_BINARY(*, ExprMul)
+MYMATH_EXPR_BINARY(/, ExprDiv)
+MYMATH_EXPR_SCALAR(*, ExprMul)
+MYMATH_EXPR_SCALAR(/, ExprDiv)
+
+#undef MYMATH_EXPR_BINARY
+#undef MYMATH_EXPR_SCALAR
+
+template<typename A, typename V = typename ExprTraits<A>::value>
+constexpr ExprNegate<typename ExprTraits<A>::node, V> operator-(const A& a) { return ExprNegate<typename ExprTraits<A>::node, V>(ExprTraits<A>::wrap(a)); }
+#endif
+
 // Vec3 Class
 class Vec3 {
 public:
@@ -47,33 +289,42 @@ public:
 	};
 
 	// Constructors
-	Vec3() : x(0.f), y(0.f), z(0.f) {}
-	Vec3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
-
+	constexpr Vec3() : x(0.f), y(0.f), z(0.f) {}
+	constexpr Vec3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+
+#if defined(MYMATH_EXPRESSION_TEMPLATES)
+	// Evaluate an expression (see Expression Templates)
+	template<typename E, typename = typename std::enable_if<IsExprOf<E, Vec3>::value>::type>
+	constexpr Vec3(const E& e) : x(e.component(0)), y(e.component(1)), z(e.component(2)) {}
+	constexpr float component(int i) const { return i == 0 ? x : (i == 1 ? y : z); }
+#else
 	// Vec3 Operator Overloading
-	Vec3 operator+(const Vec3& pVec) const { return Vec3(v[0] + pVec.v[0], v[1] + pVec.v[1], v[2] + pVec.v[2]); }
-	Vec3 operator-(const Vec3& pVec) const { return Vec3(v[0] - pVec.v[0], v[1] - pVec.v[1], v[2] - pVec.v[2]); }
-	Vec3 operator*(const Vec3& pVec) const { return Vec3(v[0] * pVec.v[0], v[1] * pVec.v[1], v[2] * pVec.v[2]); }
-	Vec3 operator/(const Vec3& pVec) const { return Vec3(v[0] / pVec.v[0], v[1] / pVec.v[1], v[2] / pVec.v[2]); }
+	constexpr Vec3 operator+(const Vec3& pVec) const { return Vec3(x + pVec.x, y + pVec.y, z + pVec.z); }
+	constexpr Vec3 operator-(const Vec3& pVec) const { return Vec3(x - pVec.x, y - pVec.y, z - pVec.z); }
+	constexpr Vec3 operator*(const Vec3& pVec) const { return Vec3(x * pVec.x, y * pVec.y, z * pVec.z); }
+	constexpr Vec3 operator/(const Vec3& pVec) const { return Vec3(x / pVec.x, y / pVec.y, z / pVec.z); }
 
-	Vec3 operator*(const float scalar) const { return Vec3(v[0] * scalar, v[1] * scalar, v[2] * scalar); }
-	Vec3 operator/(const float scalar) const { return Vec3(v[0] / scalar, v[1] / scalar, v[2] / scalar); }
+	constexpr Vec3 operator*(const float scalar) const { return Vec3(x * scalar, y * scalar, z * scalar); }
+	constexpr Vec3 operator/(const float scalar) const { return Vec3(x / scalar, y / scalar, z / scalar); }
+#endif
 
 	// Vec3& Operator Overloading
-	Vec3& operator+=(const Vec3& pVec) { v[0] += pVec.v[0]; v[1] += pVec.v[1]; v[2] += pVec.v[2]; return *this; }
-	Vec3& operator-=(const Vec3& pVec) { v[0] -= pVec.v[0]; v[1] -= pVec.v[1]; v[2] -= pVec.v[2]; return *this; }
-	Vec3& operator*=(const Vec3& pVec) { v[0] *= pVec.v[0]; v[1] *= pVec.v[1]; v[2] *= pVec.v[2]; return *this; }
-	Vec3& operator/=(const Vec3& pVec) { v[0] /= pVec.v[0]; v[1] /= pVec.v[1]; v[2] /= pVec.v[2]; return *this; }
-	Vec3& operator*=(const float scalar) { v[0] *= scalar; v[1] *= scalar; v[2] *= scalar; return *this; }
-	Vec3& operator/=(const float scalar) { v[0] /= scalar; v[1] /= scalar; v[2] /= scalar; return *this; }
-
+	constexpr Vec3& operator+=(const Vec3& pVec) { x += pVec.x; y += pVec.y; z += pVec.z; return *this; }
+	constexpr Vec3& operator-=(const Vec3& pVec) { x -= pVec.x; y -= pVec.y; z -= pVec.z; return *this; }
+	constexpr Vec3& operator*=(const Vec3& pVec) { x *= pVec.x; y *= pVec.y; z *= pVec.z; return *this; }
+	constexpr Vec3& operator/=(const Vec3& pVec) { x /= pVec.x; y /= pVec.y; z /= pVec.z; return *this; }
+	constexpr Vec3& operator*=(const float scalar) { x *= scalar; y *= scalar; z *= scalar; return *this; }
+	constexpr Vec3& operator/=(const float scalar) { x /= scalar; y /= scalar; z /= scalar; return *this; }
+
+#if !defined(MYMATH_EXPRESSION_TEMPLATES)
 	// Unary Negate
-	Vec3 operator-() const { return Vec3(-v[0], -v[1], -v[2]); }
+	constexpr Vec3 operator-() const { return Vec3(-x, -y, -z); }
+#endif
 
 	// Methods
 	// Length (magnitude) of a vector
 	float length() const { return sqrt(SQ(v[0]) + SQ(v[1]) + SQ(v[2])); }
-	float lengthSquare() const { return SQ(v[0]) + SQ(v[1]) + SQ(v[2]); }
+	constexpr float lengthSquare() const { return SQ(x) + SQ(y) + SQ(z); }
 
 	// Normalize a vector (i.e. unit vector)
 	Vec3 normalize() const {
@@ -89,22 +340,21 @@ public:
 	}
 
 	// Dot & Cross Products
-	float Dot(const Vec3& pVec) const { return (v[0] * pVec.v[0] + v[1] * pVec.v[1] + v[2] * pVec.v[2]); }
-	Vec3 Cross(const Vec3& pVec) { return Vec3((v[1] * pVec.v[2] - v[2] * pVec.v[1]), (v[2] * pVec.v[0] - v[0] * pVec.v[2]),
-											   (v[0] * pVec.v[1] - v[1] * pVec.v[0])); }
+	constexpr float Dot(const Vec3& pVec) const { return (x * pVec.x + y * pVec.y + z * pVec.z); }
+	constexpr Vec3 Cross(const Vec3& pVec) const { return Vec3((y * pVec.z - z * pVec.y), (z * pVec.x - x * pVec.z), (x * pVec.y - y * pVec.x)); }
 	
 	// Print
 	void print() const { std::cout << '<' << v[0] << ", " << v[1] << ", " << v[2] << '>' << std::endl; }
 
 	// Max and Min of Vector Components
-	float Max() const { return std::max<float>(x, std::max<float>(y, z)); }
-	float Min() const { return std::min<float>(x, std::min<float>(y, z)); }
+	constexpr float Max() const { return std::max<float>(x, std::max<float>(y, z)); }
+	constexpr float Min() const { return std::min<float>(x, std::min<float>(y, z)); }
 };
 
-float Dot(const Vec3& v1, const Vec3& v2) { return (v1.v[0] * v2.v[0] + v1.v[1] * v2.v[1] + v1.v[2] * v2.v[2]); }
-Vec3 Cross(const Vec3& v1, const Vec3& v2) { return Vec3((v1.v[1] * v2.v[2] - v1.v[2] * v2.v[1]), (v1.v[2] * v2.v[0] - v1.v[0] * v2.v[2]), (v1.v[0] * v2.v[1] - v1.v[1] * v2.v[0])); }
-Vec3 Max(const Vec3& v1, const Vec3& v2) { return Vec3(std::max<float>(v1.v[0], v2.v[0]), std::max<float>(v1.v[1], v2.v[1]), std::max<float>(v1.v[2], v2.v[2])); }
-Vec3 Min(const Vec3& v1, const Vec3& v2) { return Vec3(std::min<float>(v1.v[0], v2.v[0]), std::min<float>(v1.v[1], v2.v[1]), std::min<float>(v1.v[2], v2.v[2])); }
+constexpr float Dot(const Vec3& v1, const Vec3& v2) { return (v1.x * v2.x + v1.y * v2.y + v1.z * v2.z); }
+constexpr Vec3 Cross(const Vec3& v1, const Vec3& v2) { return Vec3((v1.y * v2.z - v1.z * v2.y), (v1.z * v2.x - v1.x * v2.z), (v1.x * v2.y - v1.y * v2.x)); }
+constexpr Vec3 Max(const Vec3& v1, const Vec3& v2) { return Vec3(std::max<float>(v1.x, v2.x), std::max<float>(v1.y, v2.y), std::max<float>(v1.z, v2.z)); }
+constexpr Vec3 Min(const Vec3& v1, const Vec3& v2) { return Vec3(std::min<float>(v1.x, v2.x), std::min<float>(v1.y, v2.y), std::min<float>(v1.z, v2.z)); }
 
 // Vec4 Class
 class Vec4 {
@@ -116,36 +366,45 @@ public:
 	};
 
 	// Constructors
-	Vec4() : x(0.f), y(0.f), z(0.f), w(1.f) {}
-	Vec4(float _x, float _y) : x(_x), y(_y), z(0.f), w(1.f) {}
-	Vec4(float _x, float _y, float _z) : x(_x), y(_y), z(_z), w(1.f) {}
-	Vec4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
-
+	constexpr Vec4() : x(0.f), y(0.f), z(0.f), w(1.f) {}
+	constexpr Vec4(float _x, float _y) : x(_x), y(_y), z(0.f), w(1.f) {}
+	constexpr Vec4(float _x, float _y, float _z) : x(_x), y(_y), z(_z), w(1.f) {}
+	constexpr Vec4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+
+#if defined(MYMATH_EXPRESSION_TEMPLATES)
+	// Evaluate an expression (see Expression Templates)
+	template<typename E, typename = typename std::enable_if<IsExprOf<E, Vec4>::value>::type>
+	constexpr Vec4(const E& e) : x(e.component(0)), y(e.component(1)), z(e.component(2)), w(e.component(3)) {}
+	constexpr float component(int i) const { return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w)); }
+#else
 	// Vec4 Operator Overloading
-	Vec4 operator+(const Vec4& pVec) const { return Vec4(v[0] + pVec.v[0], v[1] + pVec.v[1], v[2] + pVec.v[2], v[3] + pVec.v[3]); }
-	Vec4 operator-(const Vec4& pVec) const { return Vec4(v[0] - pVec.v[0], v[1] - pVec.v[1], v[2] - pVec.v[2], v[3] - pVec.v[3]); }
-	Vec4 operator*(const Vec4& pVec) const { return Vec4(v[0] * pVec.v[0], v[1] * pVec.v[1], v[2] * pVec.v[2], v[3] * pVec.v[3]); }
-	Vec4 operator/(const Vec4& pVec) const { return Vec4(v[0] / pVec.v[0], v[1] / pVec.v[1], v[2] / pVec.v[2], v[3] / pVec.v[3]); }
+	constexpr Vec4 operator+(const Vec4& pVec) const { return Vec4(x + pVec.x, y + pVec.y, z + pVec.z, w + pVec.w); }
+	constexpr Vec4 operator-(const Vec4& pVec) const { return Vec4(x - pVec.x, y - pVec.y, z - pVec.z, w - pVec.w); }
+	constexpr Vec4 operator*(const Vec4& pVec) const { return Vec4(x * pVec.x, y * pVec.y, z * pVec.z, w * pVec.w); }
+	constexpr Vec4 operator/(const Vec4& pVec) const { return Vec4(x / pVec.x, y / pVec.y, z / pVec.z, w / pVec.w); }
 
-	Vec4 operator*(const float scalar) const { return Vec4(v[0] * scalar, v[1] * scalar, v[2] * scalar, v[3] * scalar); }
-	Vec4 operator/(const float scalar) const { return Vec4(v[0] / scalar, v[1] / scalar, v[2] / scalar, v[3] / scalar); }
+	constexpr Vec4 operator*(const float scalar) const { return Vec4(x * scalar, y * scalar, z * scalar, w * scalar); }
+	constexpr Vec4 operator/(const float scalar) const { return Vec4(x / scalar, y / scalar, z / scalar, w / scalar); }
+#endif
 
 	// Vec4& Operator Overloading
-	Vec4& operator+=(const Vec4& pVec) { v[0] += pVec.v[0]; v[1] += pVec.v[1]; v[2] += pVec.v[2]; v[3] += pVec.v[3]; return *this; }
-	Vec4& operator-=(const Vec4& pVec) { v[0] -= pVec.v[0]; v[1] -= pVec.v[1]; v[2] -= pVec.v[2]; v[3] -= pVec.v[3]; return *this; }
-	Vec4& operator*=(const Vec4& pVec) { v[0] *= pVec.v[0]; v[1] *= pVec.v[1]; v[2] *= pVec.v[2]; v[3] *= pVec.v[3]; return *this; }
-	Vec4& operator/=(const Vec4& pVec) { v[0] /= pVec.v[0]; v[1] /= pVec.v[1]; v[2] /= pVec.v[2]; v[3] /= pVec.v[3]; return *this; }
-	Vec4& operator*=(const float scalar) { v[0] *= scalar; v[1] *= scalar; v[2] *= scalar; v[3] *= scalar; return *this; }
-	Vec4& operator/=(const float scalar) { v[0] /= scalar; v[1] /= scalar; v[2] /= scalar; v[3] /= scalar; return *this; }
+	constexpr Vec4& operator+=(const Vec4& pVec) { x += pVec.x; y += pVec.y; z += pVec.z; w += pVec.w; return *this; }
+	constexpr Vec4& operator-=(const Vec4& pVec) { x -= pVec.x; y -= pVec.y; z -= pVec.z; w -= pVec.w; return *this; }
+	constexpr Vec4& operator*=(const Vec4& pVec) { x *= pVec.x; y *= pVec.y; z *= pVec.z; w *= pVec.w; return *this; }
+	constexpr Vec4& operator/=(const Vec4& pVec) { x /= pVec.x; y /= pVec.y; z /= pVec.z; w /= pVec.w; return *this; }
+	constexpr Vec4& operator*=(const float scalar) { x *= scalar; y *= scalar; z *= scalar; w *= scalar; return *this; }
+	constexpr Vec4& operator/=(const float scalar) { x /= scalar; y /= scalar; z /= scalar; w /= scalar; return *this; }
 	float& operator[](int index) { return v[index]; }
 
+#if !defined(MYMATH_EXPRESSION_TEMPLATES)
 	// Unary Negate
-	Vec4 operator-() const { return Vec4(-v[0], -v[1], -v[2], -v[3]); }
+	constexpr Vec4 operator-() const { return Vec4(-x, -y, -z, -w); }
+#endif
 
 	// Methods
 	// Length (magnitude) of a vector
 	float length() const { return sqrt(SQ(v[0]) + SQ(v[1]) + SQ(v[2]) + SQ(v[3])); }
-	float lengthSquare() const { return SQ(v[0]) + SQ(v[1]) + SQ(v[2]) + SQ(v[3]); }
+	constexpr float lengthSquare() const { return SQ(x) + SQ(y) + SQ(z) + SQ(w); }
 
 	// Normalize a vector (i.e. unit vector)
 	Vec4 normalize() {
@@ -161,22 +420,38 @@ public:
 	}
 
 	// Dot Product
-	float Dot(const Vec4& pVec) const { return (v[0] * pVec.v[0] + v[1] * pVec.v[1] + v[2] * pVec.v[2] + v[3] * pVec.v[3]); }
+	constexpr float Dot(const Vec4& pVec) const { return (x * pVec.x + y * pVec.y + z * pVec.z + w * pVec.w); }
 	
 	// Print
 	void print() const { std::cout << '<' << v[0] << ", " << v[1] << ", " << v[2] << ", " << v[3] << '>' << std::endl; }
 
 	// Max and Min of Vector Components
-	float Max() const { return std::max<float>(std::max<float>(x, y), std::max<float>(z, w)); }
-	float Min() const { return std::min<float>(std::min<float>(x, y), std::min<float>(z, w)); }
+	constexpr float Max() const { return std::max<float>(std::max<float>(x, y), std::max<float>(z, w)); }
+	constexpr float Min() const { return std::min<float>(std::min<float>(x, y), std::min<float>(z, w)); }
 
 	// Divide by w
 	Vec4 divideByW() { float W = 1.f / v[3]; return Vec4(v[0] * W, v[1] * W, v[2] * W, W); }
 };
 
-float Dot(const Vec4& v1, const Vec4& v2) { return (v1.v[0] * v2.v[0] + v1.v[1] * v2.v[1] + v1.v[2] * v2.v[2] + v1.v[3] * v2.v[3]); }
-Vec4 Max(const Vec4& v1, const Vec4& v2) { return Vec4(std::max<float>(v1.v[0], v2.v[0]), std::max<float>(v1.v[1], v2.v[1]), std::max<float>(v1.v[2], v2.v[2]), std::max<float>(v1.v[3], v2.v[3])); }
-Vec4 Min(const Vec4& v1, const Vec4& v2) { return Vec4(std::min<float>(v1.v[0], v2.v[0]), std::min<float>(v1.v[1], v2.v[1]), std::min<float>(v1.v[2], v2.v[2]), std::min<float>(v1.v[3], v2.v[3])); }
+constexpr float Dot(const Vec4& v1, const Vec4& v2) { return (v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w); }
+constexpr Vec4 Max(const Vec4& v1, const Vec4& v2) { return Vec4(std::max<float>(v1.x, v2.x), std::max<float>(v1.y, v2.y), std::max<float>(v1.z, v2.z), std::max<float>(v1.w, v2.w)); }
+constexpr Vec4 Min(const Vec4& v1, const Vec4& v2) { return Vec4(std::min<float>(v1.x, v2.x), std::min<float>(v1.y, v2.y), std::min<float>(v1.z, v2.z), std::min<float>(v1.w, v2.w)); }
+
+// SIMD Level (selected at startup from the CPU features, can be lowered for testing)
+enum SimdLevel { SimdScalar, SimdSSE, SimdAVX2 };
+
+// Matrix Kernel Table (filled in after the Matrix class, see matrixKernels())
+class Matrix;
+class Affine;
+class Quaternion;
+struct MatrixKernels {
+	SimdLevel level;
+	bool (*invert)(const Matrix& matrix, Matrix& out);
+	void (*transformPoints)(const Matrix& matrix, const Vec3* in, Vec3* out, int count);
+	void (*transformVectors)(const Matrix& matrix, const Vec3* in, Vec3* out, int count);
+};
+
+inline MatrixKernels& matrixKernels();
 
 // 4x4 Matrix Class
 class alignas(64) Matrix {
@@ -188,60 +463,60 @@ public:
 	};
 
 	// Constructors
-	Matrix() {
-		// Initialize to identity matrix
-		for (int i = 0; i < 16; i++) (i % 5 == 0) ? m[i] = 1.f : m[i] = 0.f;
-	}
+	// Initialize to identity matrix
+	constexpr Matrix() : m{ 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f } {}
 
-	Matrix(float f1, float f2, float f3, float f4, float f5, float f6, float f7, float f8,
-		   float f9, float f10, float f11, float f12, float f13, float f14, float f15, float f16) {
-		// Initialize for 16 floating values
-		m[0] = f1; m[1] = f2; m[2] = f3; m[3] = f4;
-		m[4] = f5; m[5] = f6; m[6] = f7; m[7] = f8;
-		m[8] = f9; m[9] = f10; m[10] = f11; m[11] = f12;
-		m[12] = f13; m[13] = f14; m[14] = f15; m[15] = f16;
-	}
+	// Initialize for 16 floating values
+	constexpr Matrix(float f1, float f2, float f3, float f4, float f5, float f6, float f7, float f8,
+					 float f9, float f10, float f11, float f12, float f13, float f14, float f15, float f16)
+		: m{ f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16 } {}
 
 	// Operator Overloading
-	float& operator[](const int index) { return m[index]; }
+	constexpr float& operator[](const int index) { return m[index]; }
 
-	Matrix operator=(const Matrix& matrix) {
-		memcpy(m, matrix.m, sizeof(float) * 16);
+	constexpr Matrix operator=(const Matrix& matrix) {
+		for (int i = 0; i < 16; i++) m[i] = matrix.m[i];
 		return (*this);
 	}
 
 	// Methods
 	// Identity Matrix
-	static Matrix identity() {
-		Matrix iden;
-		for (int i = 0; i < 16; i++) (i % 5 == 0) ? iden[i] = 1.f : iden[i] = 0.f;
-		return iden;
-	}
+	static constexpr Matrix identity() { return Matrix(); }
 
 	// Matrix & Vector Multiplication
-	Vec4 mul(const Vec4& v) {
+	// Single products stay inline scalar code: the compiler vectorizes them at the call site and a call through the
+	// kernel table measured slower than that, so only the batched transforms and invert are dispatched
+	constexpr Vec4 mul(const Vec4& v) const { return mulScalar(v); }
+	constexpr Vec3 mulPoint(const Vec3& v) const { return mulPointScalar(v); }
+	constexpr Vec3 mulVec(const Vec3& v) const { return mulVecScalar(v); }
+
+	// Matrix & Vector Multiplication (scalar reference)
+	constexpr Vec4 mulScalar(const Vec4& v) const {
 		return Vec4((v.x * m[0] + v.y * m[1] + v.z * m[2] + v.w * m[3]),
 					(v.x * m[4] + v.y * m[5] + v.z * m[6] + v.w * m[7]),
 					(v.x * m[8] + v.y * m[9] + v.z * m[10] + v.w * m[11]),
 					(v.x * m[12] + v.y * m[13] + v.z * m[14] + v.w * m[15]));
 	}
 
-	Vec3 mulPoint(const Vec3& v) {
+	constexpr Vec3 mulPointScalar(const Vec3& v) const {
 		// w = 1
 		return Vec3((v.x * m[0] + v.y * m[1] + v.z * m[2]) + m[3],
 					(v.x * m[4] + v.y * m[5] + v.z * m[6]) + m[7],
 					(v.x * m[8] + v.y * m[9] + v.z * m[10]) + m[11]);
 	}
 
-	Vec3 mulVec(const Vec3& v) {
+	constexpr Vec3 mulVecScalar(const Vec3& v) const {
 		// w = 0
 		return Vec3((v.x * m[0] + v.y * m[1] + v.z * m[2]),
 					(v.x * m[4] + v.y * m[5] + v.z * m[6]),
 					(v.x * m[8] + v.y * m[9] + v.z * m[10]));
 	}
 
-	// 4x4 Matrix Multiplication
-	Matrix mul(const Matrix& matrix) const {
+	// 4x4 Matrix Multiplication (inline scalar, see mul above)
+	constexpr Matrix mul(const Matrix& matrix) const { return mulScalar(matrix); }
+
+	// 4x4 Matrix Multiplication (scalar reference)
+	constexpr Matrix mulScalar(const Matrix& matrix) const {
 		Matrix ret;
 		ret.m[0] = m[0] * matrix.m[0] + m[4] * matrix.m[1] + m[8] * matrix.m[2] + m[12] * matrix.m[3];
 		ret.m[1] = m[1] * matrix.m[0] + m[5] * matrix.m[1] + m[9] * matrix.m[2] + m[13] * matrix.m[3];
@@ -266,57 +541,93 @@ public:
 	}
 
 	// Rotate on x-axis
-	static Matrix rotateOnXAxis(const float theta) {
+	template<typename MathPolicy = PreciseMath>
+	static constexpr Matrix rotateOnXAxis(const float theta) {
 		Matrix xMat;
-		xMat[5] = cos(theta); xMat[6] = sin(theta);
-		xMat[9] = -sin(theta); xMat[10] = cos(theta);
+		float s = 0.f, c = 0.f;
+		MathPolicy::sincos(theta, s, c);
+		xMat[5] = c; xMat[6] = s;
+		xMat[9] = -s; xMat[10] = c;
 		return xMat;
 	}
 
 	// Rotate on y-axis
-	static Matrix rotateOnYAxis(const float theta) {
+	template<typename MathPolicy = PreciseMath>
+	static constexpr Matrix rotateOnYAxis(const float theta) {
 		Matrix yMat;
-		yMat[0] = cos(theta); yMat[2] = -sin(theta);
-		yMat[8] = sin(theta); yMat[10] = cos(theta);
+		float s = 0.f, c = 0.f;
+		MathPolicy::sincos(theta, s, c);
+		yMat[0] = c; yMat[2] = -s;
+		yMat[8] = s; yMat[10] = c;
 		return yMat;
 	}
 	
 	// Rotate on z-axis
-	static Matrix rotateOnZAxis(const float theta) {
+	template<typename MathPolicy = PreciseMath>
+	static constexpr Matrix rotateOnZAxis(const float theta) {
 		Matrix zMat;
-		zMat[0] = cos(theta); zMat[1] = sin(theta);
-		zMat[4] = -sin(theta); zMat[5] = cos(theta);
+		float s = 0.f, c = 0.f;
+		MathPolicy::sincos(theta, s, c);
+		zMat[0] = c; zMat[1] = s;
+		zMat[4] = -s; zMat[5] = c;
 		return zMat;
 	}
 
 	// Translate
-	static Matrix translate(const Vec3& v) {
+	static constexpr Matrix translate(const Vec3& v) {
 		Matrix trans;
 		trans[3] = v.x; trans[7] = v.y; trans[11] = v.z;
 		return trans;
 	}
 
 	// Scale
-	static Matrix scale(const Vec3& v) {
+	static constexpr Matrix scale(const Vec3& v) {
 		Matrix sc;
 		sc[0] = v.x; sc[5] = v.y; sc[10] = v.z;
 		return sc;
 	}
 
+	// Translation, Rotation & Scale written in one pass, same as scale(s) * rotation.toMatrix() * translate(t)
+	// (scale applied first, then rotation, then translation) without the two products, defined after Quaternion
+	static constexpr Matrix fromTRS(const Vec3& translation, const Quaternion& rotation, const Vec3& scale);
+
+	// Splits an affine matrix back into translation, rotation and scale (see Affine::decompose)
+	bool decompose(Vec3& translation, Quaternion& rotation, Vec3& scale) const;
+
 	// Natural Acces for Matrix Multiplication (Operator Overloading)
-	Matrix operator* (const Matrix& matrix) { return mul(matrix); }
+	constexpr Matrix operator* (const Matrix& matrix) const { return mul(matrix); }
 
 	// Transpose
-	Matrix transpose() {
-		return Matrix(a[0][0], a[1][0], a[2][0], a[3][0],
-					  a[0][1], a[1][1], a[2][1], a[3][1],
-					  a[0][2], a[1][2], a[2][2], a[3][2],
-					  a[0][3], a[1][3], a[2][3], a[3][3]);
+	constexpr Matrix transpose() const {
+		return Matrix(m[0], m[4], m[8], m[12],
+					  m[1], m[5], m[9], m[13],
+					  m[2], m[6], m[10], m[14],
+					  m[3], m[7], m[11], m[15]);
+	}
+
+	// Inverse of a matrix (dispatched to the fastest kernel available)
+	Matrix invert() const {
+		Matrix inv;
+		if (!matrixKernels().invert(*this, inv)) {
+			// Handle this case
+			std::cout << "det(M) = 0 [This matrix doesn't have an inverse... returning identity matrix for graceful termination]" << std::endl;
+			return identity();
+		}
+		return inv;
 	}
 
-	// Inverse of a matrix
-	Matrix invert() {
+	// Inverse of a matrix (scalar reference)
+	Matrix invertScalar() const {
 		Matrix inv;
+		if (!invertScalar(inv)) {
+			// Handle this case
+			std::cout << "det(M) = 0 [This matrix doesn't have an inverse... returning identity matrix for graceful termination]" << std::endl;
+			return identity();
+		}
+		return inv;
+	}
+
+	bool invertScalar(Matrix& inv) const {
 		inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
 		inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
 		inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
@@ -334,17 +645,12 @@ public:
 		inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
 		inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
 		float det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
-
-		if (det == 0) {
-			// Handle this case
-			std::cout << "det(M) = 0 [This matrix doesn't have an inverse... returning identity matrix for graceful termination]" << std::endl;
-			return identity();
-		}
+		if (det == 0) return false;
 
 		det = 1.0 / det;
 		for (int i = 0; i < 16; i++)
 			inv[i] *= det;
-		return inv;
+		return true;
 	}
 
 	// Projection Matrix
@@ -401,10 +707,11 @@ public:
 		return look;
 	}
 
+	template<typename MathPolicy = PreciseMath>
 	static Matrix rotateAxis(Vec3& axis, float angle) {
 		Vec3 u = axis.normalize();
-		float c = cosf(angle);
-		float s = sinf(angle);
+		float c = 0.f, s = 0.f;
+		MathPolicy::sincos(angle, s, c);
 		float t = 1.0f - c;
 
 		return Matrix(
@@ -416,6 +723,846 @@ public:
 	}
 };
 
+// Scalar Kernels (reference implementation, always available)
+inline bool matrixInvertScalar(const Matrix& matrix, Matrix& out) { return matrix.invertScalar(out); }
+
+inline void matrixTransformPointsScalar(const Matrix& matrix, const Vec3* in, Vec3* out, int count) {
+	for (int i = 0; i < count; i++) out[i] = matrix.mulPointScalar(in[i]);
+}
+
+inline void matrixTransformVectorsScalar(const Matrix& matrix, const Vec3* in, Vec3* out, int count) {
+	for (int i = 0; i < count; i++) out[i] = matrix.mulVecScalar(in[i]);
+}
+
+#ifdef MYMATH_X86
+// SSE Kernels
+// The transforms issue their products and sums in the same order as the scalar code (no FMA), they
+// only differ from it where the compiler contracts the scalar code to FMA; invert uses 2x2
+// sub-determinants and agrees with the cofactor expansion up to rounding
+inline bool matrixInvertSSE(const Matrix& matrix, Matrix& out) {
+	__m128 r0 = _mm_loadu_ps(&matrix.m[0]);
+	__m128 r1 = _mm_loadu_ps(&matrix.m[4]);
+	__m128 r2 = _mm_loadu_ps(&matrix.m[8]);
+	__m128 r3 = _mm_loadu_ps(&matrix.m[12]);
+
+	// 2x2 sub-determinants of the top (s) and bottom (c) row pairs
+	// s = {s0, s1, s2, s3} and {s4, s5, s4, s5} for column pairs (01, 02, 03, 12) and (13, 23)
+	#define MYMATH_SUBDET(a, b, i0, i1, i2, i3, j0, j1, j2, j3) \
+		_mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(i3, i2, i1, i0)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(j3, j2, j1, j0))), \
+				   _mm_mul_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(i3, i2, i1, i0)), _mm_shuffle_ps(a, a, _MM_SHUFFLE(j3, j2, j1, j0))))
+	__m128 sA = MYMATH_SUBDET(r0, r1, 0, 0, 0, 1, 1, 2, 3, 2);
+	__m128 sB = MYMATH_SUBDET(r0, r1, 1, 2, 1, 2, 3, 3, 3, 3);
+	__m128 cA = MYMATH_SUBDET(r2, r3, 0, 0, 0, 1, 1, 2, 3, 2);
+	__m128 cB = MYMATH_SUBDET(r2, r3, 1, 2, 1, 2, 3, 3, 3, 3);
+	#undef MYMATH_SUBDET
+
+	// x_k = {c_k, c_k, s_k, s_k}
+	__m128 x0 = _mm_shuffle_ps(cA, sA, _MM_SHUFFLE(0, 0, 0, 0));
+	__m128 x1 = _mm_shuffle_ps(cA, sA, _MM_SHUFFLE(1, 1, 1, 1));
+	__m128 x2 = _mm_shuffle_ps(cA, sA, _MM_SHUFFLE(2, 2, 2, 2));
+	__m128 x3 = _mm_shuffle_ps(cA, sA, _MM_SHUFFLE(3, 3, 3, 3));
+	__m128 x4 = _mm_shuffle_ps(cB, sB, _MM_SHUFFLE(0, 0, 0, 0));
+	__m128 x5 = _mm_shuffle_ps(cB, sB, _MM_SHUFFLE(1, 1, 1, 1));
+
+	// Columns of the matrix reordered as {a1j, a0j, a3j, a2j}
+	__m128 t0 = _mm_unpacklo_ps(r1, r0);  // a10 a00 a11 a01
+	__m128 t1 = _mm_unpacklo_ps(r3, r2);  // a30 a20 a31 a21
+	__m128 t2 = _mm_unpackhi_ps(r1, r0);  // a12 a02 a13 a03
+	__m128 t3 = _mm_unpackhi_ps(r3, r2);  // a32 a22 a33 a23
+	__m128 col0 = _mm_movelh_ps(t0, t1);
+	__m128 col1 = _mm_movehl_ps(t1, t0);
+	__m128 col2 = _mm_movelh_ps(t2, t3);
+	__m128 col3 = _mm_movehl_ps(t3, t2);
+
+	// Adjugate rows, alternating signs are applied with a sign-bit xor
+	const __m128 signPNPN = _mm_castsi128_ps(_mm_set_epi32((int)0x80000000, 0, (int)0x80000000, 0));
+	const __m128 signNPNP = _mm_castsi128_ps(_mm_set_epi32(0, (int)0x80000000, 0, (int)0x80000000));
+	__m128 b0 = _mm_sub_ps(_mm_mul_ps(col1, x5), _mm_mul_ps(col2, x4));
+	b0 = _mm_xor_ps(_mm_add_ps(b0, _mm_mul_ps(col3, x3)), signPNPN);
+	__m128 b1 = _mm_sub_ps(_mm_mul_ps(col0, x5), _mm_mul_ps(col2, x2));
+	b1 = _mm_xor_ps(_mm_add_ps(b1, _mm_mul_ps(col3, x1)), signNPNP);
+	__m128 b2 = _mm_sub_ps(_mm_mul_ps(col0, x4), _mm_mul_ps(col1, x2));
+	b2 = _mm_xor_ps(_mm_add_ps(b2, _mm_mul_ps(col3, x0)), signPNPN);
+	__m128 b3 = _mm_sub_ps(_mm_mul_ps(col0, x3), _mm_mul_ps(col1, x1));
+	b3 = _mm_xor_ps(_mm_add_ps(b3, _mm_mul_ps(col2, x0)), signNPNP);
+
+	// det = first row of the matrix dotted with the first column of the adjugate
+	__m128 firstColumn = _mm_movelh_ps(_mm_unpacklo_ps(b0, b1), _mm_unpacklo_ps(b2, b3));
+	__m128 prod = _mm_mul_ps(r0, firstColumn);
+	prod = _mm_add_ps(prod, _mm_movehl_ps(prod, prod));
+	prod = _mm_add_ss(prod, _mm_shuffle_ps(prod, prod, _MM_SHUFFLE(1, 1, 1, 1)));
+	float det = _mm_cvtss_f32(prod);
+	if (det == 0) return false;
+
+	__m128 invDet = _mm_set1_ps(1.f / det);
+	_mm_storeu_ps(&out.m[0], _mm_mul_ps(b0, invDet));
+	_mm_storeu_ps(&out.m[4], _mm_mul_ps(b1, invDet));
+	_mm_storeu_ps(&out.m[8], _mm_mul_ps(b2, invDet));
+	_mm_storeu_ps(&out.m[12], _mm_mul_ps(b3, invDet));
+	return true;
+}
+
+// Batched Vec3 Transforms
+// Four packed Vec3s (x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3) are split into x/y/z lanes, transformed
+// with broadcast matrix entries and packed back, so the stream never leaves SIMD registers
+inline void loadVec3x4(const Vec3* in, __m128& x, __m128& y, __m128& z) {
+	const float* f = in[0].v;
+	__m128 a = _mm_loadu_ps(f);
+	__m128 b = _mm_loadu_ps(f + 4);
+	__m128 c = _mm_loadu_ps(f + 8);
+	__m128 t0 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));  // x2 y2 x3 y3
+	__m128 t1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));  // y0 z0 y1 z1
+	x = _mm_shuffle_ps(a, t0, _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm_shuffle_ps(t1, t0, _MM_SHUFFLE(3, 1, 2, 0));
+	z = _mm_shuffle_ps(t1, c, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+inline void storeVec3x4(Vec3* out, __m128 x, __m128 y, __m128 z) {
+	float* f = out[0].v;
+	__m128 xyLo = _mm_unpacklo_ps(x, y);  // x0 y0 x1 y1
+	__m128 xyHi = _mm_unpackhi_ps(x, y);  // x2 y2 x3 y3
+	__m128 zx = _mm_shuffle_ps(z, xyLo, _MM_SHUFFLE(2, 2, 0, 0));  // z0 z0 x1 x1
+	__m128 yz = _mm_shuffle_ps(xyLo, z, _MM_SHUFFLE(1, 1, 3, 3));  // y1 y1 z1 z1
+	__m128 zx2 = _mm_shuffle_ps(z, xyHi, _MM_SHUFFLE(2, 2, 2, 2));  // z2 z2 x3 x3
+	__m128 yz2 = _mm_shuffle_ps(xyHi, z, _MM_SHUFFLE(3, 3, 3, 3));  // y3 y3 z3 z3
+	_mm_storeu_ps(f, _mm_shuffle_ps(xyLo, zx, _MM_SHUFFLE(2, 0, 1, 0)));
+	_mm_storeu_ps(f + 4, _mm_shuffle_ps(yz, xyHi, _MM_SHUFFLE(1, 0, 2, 0)));
+	_mm_storeu_ps(f + 8, _mm_shuffle_ps(zx2, yz2, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+template<bool isPoint>
+inline void matrixTransformVec3SSE(const Matrix& matrix, const Vec3* in, Vec3* out, int count) {
+	__m128 m[12];
+	for (int i = 0; i < 12; i++) m[i] = _mm_set1_ps(matrix.m[i]);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 x, y, z;
+		loadVec3x4(in + i, x, y, z);
+		__m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0]), _mm_mul_ps(y, m[1])), _mm_mul_ps(z, m[2]));
+		__m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[4]), _mm_mul_ps(y, m[5])), _mm_mul_ps(z, m[6]));
+		__m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[8]), _mm_mul_ps(y, m[9])), _mm_mul_ps(z, m[10]));
+		if (isPoint) {
+			rx = _mm_add_ps(rx, m[3]);
+			ry = _mm_add_ps(ry, m[7]);
+			rz = _mm_add_ps(rz, m[11]);
+		}
+		storeVec3x4(out + i, rx, ry, rz);
+	}
+	for (; i < count; i++) out[i] = isPoint ? matrix.mulPointScalar(in[i]) : matrix.mulVecScalar(in[i]);
+}
+
+// AVX2 Kernels
+// Eight Vec3s per iteration, split with the SSE helpers and joined into 256-bit lanes
+template<bool isPoint>
+MYMATH_TARGET_AVX2 inline void matrixTransformVec3AVX2(const Matrix& matrix, const Vec3* in, Vec3* out, int count) {
+	__m256 m[12];
+	for (int i = 0; i < 12; i++) m[i] = _mm256_set1_ps(matrix.m[i]);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128 xLo, yLo, zLo, xHi, yHi, zHi;
+		loadVec3x4(in + i, xLo, yLo, zLo);
+		loadVec3x4(in + i + 4, xHi, yHi, zHi);
+		__m256 x = _mm256_insertf128_ps(_mm256_castps128_ps256(xLo), xHi, 1);
+		__m256 y = _mm256_insertf128_ps(_mm256_castps128_ps256(yLo), yHi, 1);
+		__m256 z = _mm256_insertf128_ps(_mm256_castps128_ps256(zLo), zHi, 1);
+		__m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m[0]), _mm256_mul_ps(y, m[1])), _mm256_mul_ps(z, m[2]));
+		__m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m[4]), _mm256_mul_ps(y, m[5])), _mm256_mul_ps(z, m[6]));
+		__m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m[8]), _mm256_mul_ps(y, m[9])), _mm256_mul_ps(z, m[10]));
+		if (isPoint) {
+			rx = _mm256_add_ps(rx, m[3]);
+			ry = _mm256_add_ps(ry, m[7]);
+			rz = _mm256_add_ps(rz, m[11]);
+		}
+		storeVec3x4(out + i, _mm256_castps256_ps128(rx), _mm256_castps256_ps128(ry), _mm256_castps256_ps128(rz));
+		storeVec3x4(out + i + 4, _mm256_extractf128_ps(rx, 1), _mm256_extractf128_ps(ry, 1), _mm256_extractf128_ps(rz, 1));
+	}
+	matrixTransformVec3SSE<isPoint>(matrix, in + i, out + i, count - i);
+}
+
+// CPU Feature Detection
+inline bool cpuSupportsAVX2() {
+	int info[4] = {};
+#if defined(_MSC_VER)
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx) return false;
+	if ((_xgetbv(0) & 0x6) != 0x6) return false;  // OS saves XMM and YMM state
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	unsigned int eax, ebx, ecx, edx;
+	if (__get_cpuid_max(0, nullptr) < 7) return false;
+	__cpuid(1, eax, ebx, ecx, edx);
+	bool osxsave = (ecx & (1u << 27)) != 0;
+	bool avx = (ecx & (1u << 28)) != 0;
+	if (!osxsave || !avx) return false;
+	unsigned int xcr0Low, xcr0High;
+	__asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+	if ((xcr0Low & 0x6) != 0x6) return false;  // OS saves XMM and YMM state
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	(void)info;
+	return (ebx & (1u << 5)) != 0;
+#endif
+}
+#endif
+
+inline SimdLevel detectSimdLevel() {
+#ifdef MYMATH_X86
+	return cpuSupportsAVX2() ? SimdAVX2 : SimdSSE;
+#else
+	return SimdScalar;
+#endif
+}
+
+inline MatrixKernels createMatrixKernels(SimdLevel level) {
+	MatrixKernels kernels = { SimdScalar, matrixInvertScalar, matrixTransformPointsScalar, matrixTransformVectorsScalar };
+#ifdef MYMATH_X86
+	if (level >= SimdSSE) {
+		kernels = { SimdSSE, matrixInvertSSE, matrixTransformVec3SSE<true>, matrixTransformVec3SSE<false> };
+	}
+	if (level >= SimdAVX2) {
+		kernels.level = SimdAVX2;
+		kernels.transformPoints = matrixTransformVec3AVX2<true>;
+		kernels.transformVectors = matrixTransformVec3AVX2<false>;
+	}
+#endif
+	return kernels;
+}
+
+// One table for the whole program, so setSimdLevel switches every translation unit
+inline MatrixKernels& matrixKernels() {
+	static MatrixKernels kernels = createMatrixKernels(detectSimdLevel());
+	return kernels;
+}
+
+// Batched Transforms (count elements from in to out, in and out may be the same array)
+inline void transformPoints(const Matrix& matrix, const Vec3* in, Vec3* out, int count) { matrixKernels().transformPoints(matrix, in, out, count); }
+inline void transformVectors(const Matrix& matrix, const Vec3* in, Vec3* out, int count) { matrixKernels().transformVectors(matrix, in, out, count); }
+
+// 8-Wide SoA Packets
+// Eight Vec3/Vec4s held as one register per component, so a loop over spheres, particles or
+// instance positions does the work of eight lanes per instruction. The lane width is fixed, the
+// backend is picked at compile time: one __m256 when the build targets AVX2 (/arch:AVX2), a pair
+// of __m128 on any other x86 build and a plain float[8] elsewhere. Packets with the AVX2 backend
+// need 32 byte alignment, keep them on the stack or in aligned storage.
+#if defined(MYMATH_X86) && defined(__AVX2__)
+#define MYMATH_PACKET_AVX2
+#endif
+
+// Floatx8 (eight float lanes, comparisons return a lane mask with all bits set where true)
+class Floatx8 {
+public:
+#if defined(MYMATH_PACKET_AVX2)
+	__m256 v;
+
+	Floatx8() : v(_mm256_setzero_ps()) {}
+	Floatx8(float s) : v(_mm256_set1_ps(s)) {}
+	Floatx8(__m256 _v) : v(_v) {}
+
+	static Floatx8 load(const float* f) { return _mm256_loadu_ps(f); }
+	void store(float* f) const { _mm256_storeu_ps(f, v); }
+
+	// Gathers f[indices[i] * stride] into lane i
+	static Floatx8 gather(const float* f, const int* indices, int stride) {
+		__m256i offsets = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)indices), _mm256_set1_epi32(stride));
+		return _mm256_i32gather_ps(f, offsets, 4);
+	}
+
+	Floatx8 operator+(const Floatx8& p) const { return _mm256_add_ps(v, p.v); }
+	Floatx8 operator-(const Floatx8& p) const { return _mm256_sub_ps(v, p.v); }
+	Floatx8 operator*(const Floatx8& p) const { return _mm256_mul_ps(v, p.v); }
+	Floatx8 operator/(const Floatx8& p) const { return _mm256_div_ps(v, p.v); }
+	Floatx8 operator-() const { return _mm256_xor_ps(v, _mm256_set1_ps(-0.f)); }
+
+	// Lane Masks
+	Floatx8 operator<(const Floatx8& p) const { return _mm256_cmp_ps(v, p.v, _CMP_LT_OQ); }
+	Floatx8 operator<=(const Floatx8& p) const { return _mm256_cmp_ps(v, p.v, _CMP_LE_OQ); }
+	Floatx8 operator>(const Floatx8& p) const { return _mm256_cmp_ps(v, p.v, _CMP_GT_OQ); }
+	Floatx8 operator>=(const Floatx8& p) const { return _mm256_cmp_ps(v, p.v, _CMP_GE_OQ); }
+	Floatx8 operator==(const Floatx8& p) const { return _mm256_cmp_ps(v, p.v, _CMP_EQ_OQ); }
+	Floatx8 operator!=(const Floatx8& p) const { return _mm256_cmp_ps(v, p.v, _CMP_NEQ_UQ); }
+	Floatx8 operator&(const Floatx8& p) const { return _mm256_and_ps(v, p.v); }
+	Floatx8 operator|(const Floatx8& p) const { return _mm256_or_ps(v, p.v); }
+	Floatx8 operator^(const Floatx8& p) const { return _mm256_xor_ps(v, p.v); }
+
+	// Bit i set when lane i of the mask is set
+	int mask() const { return _mm256_movemask_ps(v); }
+
+	Floatx8 sqrt() const { return _mm256_sqrt_ps(v); }
+	Floatx8 abs() const { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), v); }
+
+	Floatx8 max(const Floatx8& p) const { return _mm256_max_ps(v, p.v); }
+	Floatx8 min(const Floatx8& p) const { return _mm256_min_ps(v, p.v); }
+	// Lanes of a where this mask is set, b everywhere else
+	Floatx8 select(const Floatx8& a, const Floatx8& b) const { return _mm256_blendv_ps(b.v, a.v, v); }
+#elif defined(MYMATH_X86)
+	__m128 lo, hi;
+
+	Floatx8() : lo(_mm_setzero_ps()), hi(_mm_setzero_ps()) {}
+	Floatx8(float s) : lo(_mm_set1_ps(s)), hi(_mm_set1_ps(s)) {}
+	Floatx8(__m128 _lo, __m128 _hi) : lo(_lo), hi(_hi) {}
+
+	static Floatx8 load(const float* f) { return Floatx8(_mm_loadu_ps(f), _mm_loadu_ps(f + 4)); }
+	void store(float* f) const { _mm_storeu_ps(f, lo); _mm_storeu_ps(f + 4, hi); }
+
+	// Gathers f[indices[i] * stride] into lane i
+	static Floatx8 gather(const float* f, const int* indices, int stride) {
+		return Floatx8(_mm_setr_ps(f[indices[0] * stride], f[indices[1] * stride], f[indices[2] * stride], f[indices[3] * stride]),
+			_mm_setr_ps(f[indices[4] * stride], f[indices[5] * stride], f[indices[6] * stride], f[indices[7] * stride]));
+	}
+
+	Floatx8 operator+(const Floatx8& p) const { return Floatx8(_mm_add_ps(lo, p.lo), _mm_add_ps(hi, p.hi)); }
+	Floatx8 operator-(const Floatx8& p) const { return Floatx8(_mm_sub_ps(lo, p.lo), _mm_sub_ps(hi, p.hi)); }
+	Floatx8 operator*(const Floatx8& p) const { return Floatx8(_mm_mul_ps(lo, p.lo), _mm_mul_ps(hi, p.hi)); }
+	Floatx8 operator/(const Floatx8& p) const { return Floatx8(_mm_div_ps(lo, p.lo), _mm_div_ps(hi, p.hi)); }
+	Floatx8 operator-() const { __m128 sign = _mm_set1_ps(-0.f); return Floatx8(_mm_xor_ps(lo, sign), _mm_xor_ps(hi, sign)); }
+
+	// Lane Masks
+	Floatx8 operator<(const Floatx8& p) const { return Floatx8(_mm_cmplt_ps(lo, p.lo), _mm_cmplt_ps(hi, p.hi)); }
+	Floatx8 operator<=(const Floatx8& p) const { return Floatx8(_mm_cmple_ps(lo, p.lo), _mm_cmple_ps(hi, p.hi)); }
+	Floatx8 operator>(const Floatx8& p) const { return Floatx8(_mm_cmpgt_ps(lo, p.lo), _mm_cmpgt_ps(hi, p.hi)); }
+	Floatx8 operator>=(const Floatx8& p) const { return Floatx8(_mm_cmpge_ps(lo, p.lo), _mm_cmpge_ps(hi, p.hi)); }
+	Floatx8 operator==(const Floatx8& p) const { return Floatx8(_mm_cmpeq_ps(lo, p.lo), _mm_cmpeq_ps(hi, p.hi)); }
+	Floatx8 operator!=(const Floatx8& p) const { return Floatx8(_mm_cmpneq_ps(lo, p.lo), _mm_cmpneq_ps(hi, p.hi)); }
+	Floatx8 operator&(const Floatx8& p) const { return Floatx8(_mm_and_ps(lo, p.lo), _mm_and_ps(hi, p.hi)); }
+	Floatx8 operator|(const Floatx8& p) const { return Floatx8(_mm_or_ps(lo, p.lo), _mm_or_ps(hi, p.hi)); }
+	Floatx8 operator^(const Floatx8& p) const { return Floatx8(_mm_xor_ps(lo, p.lo), _mm_xor_ps(hi, p.hi)); }
+
+	// Bit i set when lane i of the mask is set
+	int mask() const { return _mm_movemask_ps(lo) | (_mm_movemask_ps(hi) << 4); }
+
+	Floatx8 sqrt() const { return Floatx8(_mm_sqrt_ps(lo), _mm_sqrt_ps(hi)); }
+	Floatx8 abs() const { __m128 sign = _mm_set1_ps(-0.f); return Floatx8(_mm_andnot_ps(sign, lo), _mm_andnot_ps(sign, hi)); }
+
+	Floatx8 max(const Floatx8& p) const { return Floatx8(_mm_max_ps(lo, p.lo), _mm_max_ps(hi, p.hi)); }
+	Floatx8 min(const Floatx8& p) const { return Floatx8(_mm_min_ps(lo, p.lo), _mm_min_ps(hi, p.hi)); }
+	// Lanes of a where this mask is set, b everywhere else (and/andnot, blendv needs SSE4.1)
+	Floatx8 select(const Floatx8& a, const Floatx8& b) const {
+		return Floatx8(_mm_or_ps(_mm_and_ps(lo, a.lo), _mm_andnot_ps(lo, b.lo)), _mm_or_ps(_mm_and_ps(hi, a.hi), _mm_andnot_ps(hi, b.hi)));
+	}
+#else
+	// Masks are stored as floats with every bit set (NaN) or cleared, same as the SIMD backends
+	float f[8];
+
+	Floatx8() { for (int i = 0; i < 8; i++) f[i] = 0.f; }
+	Floatx8(float s) { for (int i = 0; i < 8; i++) f[i] = s; }
+
+	static Floatx8 load(const float* p) { Floatx8 ret; memcpy(ret.f, p, sizeof(ret.f)); return ret; }
+	void store(float* p) const { memcpy(p, f, sizeof(f)); }
+
+	// Gathers p[indices[i] * stride] into lane i
+	static Floatx8 gather(const float* p, const int* indices, int stride) {
+		Floatx8 ret;
+		for (int i = 0; i < 8; i++) ret.f[i] = p[indices[i] * stride];
+		return ret;
+	}
+
+	Floatx8 operator+(const Floatx8& p) const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.f[i] = f[i] + p.f[i]; return ret; }
+	Floatx8 operator-(const Floatx8& p) const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.f[i] = f[i] - p.f[i]; return ret; }
+	Floatx8 operator*(const Floatx8& p) const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.f[i] = f[i] * p.f[i]; return ret; }
+	Floatx8 operator/(const Floatx8& p) const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.f[i] = f[i] / p.f[i]; return ret; }
+	Floatx8 operator-() const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.f[i] = -f[i]; return ret; }
+
+	// Lane Masks
+	Floatx8 operator<(const Floatx8& p) const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.setLane(i, f[i] < p.f[i]); return ret; }
+	Floatx8 operator<=(const Floatx8& p) const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.setLane(i, f[i] <= p.f[i]); return ret; }
+	Floatx8 operator>(const Floatx8& p) const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.setLane(i, f[i] > p.f[i]); return ret; }
+	Floatx8 operator>=(const Floatx8& p) const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.setLane(i, f[i] >= p.f[i]); return ret; }
+	Floatx8 operator==(const Floatx8& p) const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.setLane(i, f[i] == p.f[i]); return ret; }
+	Floatx8 operator!=(const Floatx8& p) const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.setLane(i, f[i] != p.f[i]); return ret; }
+	Floatx8 operator&(const Floatx8& p) const { return bitwise(p, 0); }
+	Floatx8 operator|(const Floatx8& p) const { return bitwise(p, 1); }
+	Floatx8 operator^(const Floatx8& p) const { return bitwise(p, 2); }
+
+	// Bit i set when lane i of the mask is set
+	int mask() const {
+		int ret = 0;
+		for (int i = 0; i < 8; i++) ret |= (int)(bits(i) >> 31) << i;
+		return ret;
+	}
+
+	Floatx8 sqrt() const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.f[i] = std::sqrt(f[i]); return ret; }
+	Floatx8 abs() const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.f[i] = std::fabs(f[i]); return ret; }
+
+	Floatx8 max(const Floatx8& p) const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.f[i] = f[i] > p.f[i] ? f[i] : p.f[i]; return ret; }
+	Floatx8 min(const Floatx8& p) const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.f[i] = f[i] < p.f[i] ? f[i] : p.f[i]; return ret; }
+	// Lanes of a where this mask is set, b everywhere else
+	Floatx8 select(const Floatx8& a, const Floatx8& b) const { Floatx8 ret; for (int i = 0; i < 8; i++) ret.f[i] = (bits(i) >> 31) ? a.f[i] : b.f[i]; return ret; }
+
+private:
+	unsigned int bits(int i) const { unsigned int u; memcpy(&u, &f[i], sizeof(u)); return u; }
+	void setLane(int i, bool set) { unsigned int u = set ? 0xFFFFFFFFu : 0u; memcpy(&f[i], &u, sizeof(u)); }
+	Floatx8 bitwise(const Floatx8& p, int op) const {
+		Floatx8 ret;
+		for (int i = 0; i < 8; i++) {
+			unsigned int a = bits(i), b = p.bits(i);
+			unsigned int u = op == 0 ? (a & b) : op == 1 ? (a | b) : (a ^ b);
+			memcpy(&ret.f[i], &u, sizeof(u));
+		}
+		return ret;
+	}
+
+public:
+#endif
+
+	// Mask Tests
+	bool any() const { return mask() != 0; }
+	bool all() const { return mask() == 0xFF; }
+
+	float lane(int index) const { float lanes[8]; store(lanes); return lanes[index]; }
+};
+
+inline Floatx8 Max(const Floatx8& a, const Floatx8& b) { return a.max(b); }
+inline Floatx8 Min(const Floatx8& a, const Floatx8& b) { return a.min(b); }
+inline Floatx8 Select(const Floatx8& mask, const Floatx8& a, const Floatx8& b) { return mask.select(a, b); }
+
+// Floatx4 (four float lanes, the same interface as Floatx8 on one __m128 for packets of four)
+class Floatx4 {
+public:
+#if defined(MYMATH_X86)
+	__m128 v;
+
+	Floatx4() : v(_mm_setzero_ps()) {}
+	Floatx4(float s) : v(_mm_set1_ps(s)) {}
+	Floatx4(__m128 _v) : v(_v) {}
+
+	static Floatx4 load(const float* f) { return _mm_loadu_ps(f); }
+	void store(float* f) const { _mm_storeu_ps(f, v); }
+
+	Floatx4 operator+(const Floatx4& p) const { return _mm_add_ps(v, p.v); }
+	Floatx4 operator-(const Floatx4& p) const { return _mm_sub_ps(v, p.v); }
+	Floatx4 operator*(const Floatx4& p) const { return _mm_mul_ps(v, p.v); }
+	Floatx4 operator/(const Floatx4& p) const { return _mm_div_ps(v, p.v); }
+	Floatx4 operator-() const { return _mm_xor_ps(v, _mm_set1_ps(-0.f)); }
+
+	// Lane Masks
+	Floatx4 operator<(const Floatx4& p) const { return _mm_cmplt_ps(v, p.v); }
+	Floatx4 operator<=(const Floatx4& p) const { return _mm_cmple_ps(v, p.v); }
+	Floatx4 operator>(const Floatx4& p) const { return _mm_cmpgt_ps(v, p.v); }
+	Floatx4 operator>=(const Floatx4& p) const { return _mm_cmpge_ps(v, p.v); }
+	Floatx4 operator==(const Floatx4& p) const { return _mm_cmpeq_ps(v, p.v); }
+	Floatx4 operator!=(const Floatx4& p) const { return _mm_cmpneq_ps(v, p.v); }
+	Floatx4 operator&(const Floatx4& p) const { return _mm_and_ps(v, p.v); }
+	Floatx4 operator|(const Floatx4& p) const { return _mm_or_ps(v, p.v); }
+	Floatx4 operator^(const Floatx4& p) const { return _mm_xor_ps(v, p.v); }
+
+	// Bit i set when lane i of the mask is set
+	int mask() const { return _mm_movemask_ps(v); }
+
+	Floatx4 sqrt() const { return _mm_sqrt_ps(v); }
+	Floatx4 abs() const { return _mm_andnot_ps(_mm_set1_ps(-0.f), v); }
+
+	Floatx4 max(const Floatx4& p) const { return _mm_max_ps(v, p.v); }
+	Floatx4 min(const Floatx4& p) const { return _mm_min_ps(v, p.v); }
+	// Lanes of a where this mask is set, b everywhere else
+	Floatx4 select(const Floatx4& a, const Floatx4& b) const { return _mm_or_ps(_mm_and_ps(v, a.v), _mm_andnot_ps(v, b.v)); }
+#else
+	// Masks are stored as floats with every bit set (NaN) or cleared, same as the SIMD backend
+	float f[4];
+
+	Floatx4() { for (int i = 0; i < 4; i++) f[i] = 0.f; }
+	Floatx4(float s) { for (int i = 0; i < 4; i++) f[i] = s; }
+
+	static Floatx4 load(const float* p) { Floatx4 ret; memcpy(ret.f, p, sizeof(ret.f)); return ret; }
+	void store(float* p) const { memcpy(p, f, sizeof(f)); }
+
+	Floatx4 operator+(const Floatx4& p) const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.f[i] = f[i] + p.f[i]; return ret; }
+	Floatx4 operator-(const Floatx4& p) const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.f[i] = f[i] - p.f[i]; return ret; }
+	Floatx4 operator*(const Floatx4& p) const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.f[i] = f[i] * p.f[i]; return ret; }
+	Floatx4 operator/(const Floatx4& p) const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.f[i] = f[i] / p.f[i]; return ret; }
+	Floatx4 operator-() const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.f[i] = -f[i]; return ret; }
+
+	// Lane Masks
+	Floatx4 operator<(const Floatx4& p) const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.setLane(i, f[i] < p.f[i]); return ret; }
+	Floatx4 operator<=(const Floatx4& p) const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.setLane(i, f[i] <= p.f[i]); return ret; }
+	Floatx4 operator>(const Floatx4& p) const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.setLane(i, f[i] > p.f[i]); return ret; }
+	Floatx4 operator>=(const Floatx4& p) const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.setLane(i, f[i] >= p.f[i]); return ret; }
+	Floatx4 operator==(const Floatx4& p) const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.setLane(i, f[i] == p.f[i]); return ret; }
+	Floatx4 operator!=(const Floatx4& p) const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.setLane(i, f[i] != p.f[i]); return ret; }
+	Floatx4 operator&(const Floatx4& p) const { return bitwise(p, 0); }
+	Floatx4 operator|(const Floatx4& p) const { return bitwise(p, 1); }
+	Floatx4 operator^(const Floatx4& p) const { return bitwise(p, 2); }
+
+	// Bit i set when lane i of the mask is set
+	int mask() const {
+		int ret = 0;
+		for (int i = 0; i < 4; i++) ret |= (int)(bits(i) >> 31) << i;
+		return ret;
+	}
+
+	Floatx4 sqrt() const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.f[i] = std::sqrt(f[i]); return ret; }
+	Floatx4 abs() const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.f[i] = std::fabs(f[i]); return ret; }
+
+	Floatx4 max(const Floatx4& p) const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.f[i] = f[i] > p.f[i] ? f[i] : p.f[i]; return ret; }
+	Floatx4 min(const Floatx4& p) const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.f[i] = f[i] < p.f[i] ? f[i] : p.f[i]; return ret; }
+	// Lanes of a where this mask is set, b everywhere else
+	Floatx4 select(const Floatx4& a, const Floatx4& b) const { Floatx4 ret; for (int i = 0; i < 4; i++) ret.f[i] = (bits(i) >> 31) ? a.f[i] : b.f[i]; return ret; }
+
+private:
+	unsigned int bits(int i) const { unsigned int u; memcpy(&u, &f[i], sizeof(u)); return u; }
+	void setLane(int i, bool set) { unsigned int u = set ? 0xFFFFFFFFu : 0u; memcpy(&f[i], &u, sizeof(u)); }
+	Floatx4 bitwise(const Floatx4& p, int op) const {
+		Floatx4 ret;
+		for (int i = 0; i < 4; i++) {
+			unsigned int a = bits(i), b = p.bits(i);
+			unsigned int u = op == 0 ? (a & b) : op == 1 ? (a | b) : (a ^ b);
+			memcpy(&ret.f[i], &u, sizeof(u));
+		}
+		return ret;
+	}
+
+public:
+#endif
+
+	// Mask Tests
+	bool any() const { return mask() != 0; }
+	bool all() const { return mask() == 0xF; }
+
+	float lane(int index) const { float lanes[4]; store(lanes); return lanes[index]; }
+};
+
+inline Floatx4 Max(const Floatx4& a, const Floatx4& b) { return a.max(b); }
+inline Floatx4 Min(const Floatx4& a, const Floatx4& b) { return a.min(b); }
+inline Floatx4 Select(const Floatx4& mask, const Floatx4& a, const Floatx4& b) { return mask.select(a, b); }
+
+// Vec3x8 Class (eight Vec3s, one Floatx8 per component)
+class Vec3x8 {
+public:
+	Floatx8 x, y, z;
+
+	// Constructors
+	Vec3x8() {}
+	Vec3x8(const Floatx8& _x, const Floatx8& _y, const Floatx8& _z) : x(_x), y(_y), z(_z) {}
+	Vec3x8(const Vec3& pVec) : x(pVec.x), y(pVec.y), z(pVec.z) {}
+
+	// Loads count (up to 8) consecutive Vec3s, missing lanes are zero
+	static Vec3x8 load(const Vec3* in, int count = 8) {
+		Vec3x8 ret;
+#if defined(MYMATH_X86)
+		if (count == 8) {
+			__m128 xLo, yLo, zLo, xHi, yHi, zHi;
+			loadVec3x4(in, xLo, yLo, zLo);
+			loadVec3x4(in + 4, xHi, yHi, zHi);
+#if defined(MYMATH_PACKET_AVX2)
+			ret.x = _mm256_set_m128(xHi, xLo);
+			ret.y = _mm256_set_m128(yHi, yLo);
+			ret.z = _mm256_set_m128(zHi, zLo);
+#else
+			ret.x = Floatx8(xLo, xHi);
+			ret.y = Floatx8(yLo, yHi);
+			ret.z = Floatx8(zLo, zHi);
+#endif
+			return ret;
+		}
+#endif
+		float lanes[3][8] = {};
+		for (int i = 0; i < count; i++) {
+			lanes[0][i] = in[i].x;
+			lanes[1][i] = in[i].y;
+			lanes[2][i] = in[i].z;
+		}
+		return Vec3x8(Floatx8::load(lanes[0]), Floatx8::load(lanes[1]), Floatx8::load(lanes[2]));
+	}
+
+	// Loads base[indices[i]] into lane i
+	static Vec3x8 gather(const Vec3* base, const int* indices) {
+		const float* f = base[0].v;
+		return Vec3x8(Floatx8::gather(f, indices, 3), Floatx8::gather(f + 1, indices, 3), Floatx8::gather(f + 2, indices, 3));
+	}
+
+	// Stores the first count (up to 8) lanes as consecutive Vec3s
+	void store(Vec3* out, int count = 8) const {
+#if defined(MYMATH_X86)
+		if (count == 8) {
+#if defined(MYMATH_PACKET_AVX2)
+			storeVec3x4(out, _mm256_castps256_ps128(x.v), _mm256_castps256_ps128(y.v), _mm256_castps256_ps128(z.v));
+			storeVec3x4(out + 4, _mm256_extractf128_ps(x.v, 1), _mm256_extractf128_ps(y.v, 1), _mm256_extractf128_ps(z.v, 1));
+#else
+			storeVec3x4(out, x.lo, y.lo, z.lo);
+			storeVec3x4(out + 4, x.hi, y.hi, z.hi);
+#endif
+			return;
+		}
+#endif
+		float lanes[3][8];
+		x.store(lanes[0]); y.store(lanes[1]); z.store(lanes[2]);
+		for (int i = 0; i < count; i++) out[i] = Vec3(lanes[0][i], lanes[1][i], lanes[2][i]);
+	}
+
+	Vec3 lane(int index) const { return Vec3(x.lane(index), y.lane(index), z.lane(index)); }
+
+	// Vec3x8 Operator Overloading
+	Vec3x8 operator+(const Vec3x8& p) const { return Vec3x8(x + p.x, y + p.y, z + p.z); }
+	Vec3x8 operator-(const Vec3x8& p) const { return Vec3x8(x - p.x, y - p.y, z - p.z); }
+	Vec3x8 operator*(const Vec3x8& p) const { return Vec3x8(x * p.x, y * p.y, z * p.z); }
+	Vec3x8 operator/(const Vec3x8& p) const { return Vec3x8(x / p.x, y / p.y, z / p.z); }
+	Vec3x8 operator*(const Floatx8& s) const { return Vec3x8(x * s, y * s, z * s); }
+	Vec3x8 operator/(const Floatx8& s) const { return Vec3x8(x / s, y / s, z / s); }
+	Vec3x8 operator-() const { return Vec3x8(-x, -y, -z); }
+
+	// Methods
+	Floatx8 lengthSquare() const { return x * x + y * y + z * z; }
+	Floatx8 length() const { return lengthSquare().sqrt(); }
+	Vec3x8 normalize() const { return *this * (Floatx8(1.f) / length()); }
+
+	Floatx8 Dot(const Vec3x8& p) const { return x * p.x + y * p.y + z * p.z; }
+	Vec3x8 Cross(const Vec3x8& p) const { return Vec3x8(y * p.z - z * p.y, z * p.x - x * p.z, x * p.y - y * p.x); }
+
+	Floatx8 Max() const { return ::Max(x, ::Max(y, z)); }
+	Floatx8 Min() const { return ::Min(x, ::Min(y, z)); }
+};
+
+inline Floatx8 Dot(const Vec3x8& v1, const Vec3x8& v2) { return v1.Dot(v2); }
+inline Vec3x8 Cross(const Vec3x8& v1, const Vec3x8& v2) { return v1.Cross(v2); }
+inline Vec3x8 Max(const Vec3x8& v1, const Vec3x8& v2) { return Vec3x8(Max(v1.x, v2.x), Max(v1.y, v2.y), Max(v1.z, v2.z)); }
+inline Vec3x8 Min(const Vec3x8& v1, const Vec3x8& v2) { return Vec3x8(Min(v1.x, v2.x), Min(v1.y, v2.y), Min(v1.z, v2.z)); }
+inline Vec3x8 Select(const Floatx8& mask, const Vec3x8& a, const Vec3x8& b) { return Vec3x8(Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z)); }
+
+// Vec4x8 Class (eight Vec4s, one Floatx8 per component)
+class Vec4x8 {
+public:
+	Floatx8 x, y, z, w;
+
+	// Constructors
+	Vec4x8() {}
+	Vec4x8(const Floatx8& _x, const Floatx8& _y, const Floatx8& _z, const Floatx8& _w) : x(_x), y(_y), z(_z), w(_w) {}
+	Vec4x8(const Vec3x8& xyz, const Floatx8& _w) : x(xyz.x), y(xyz.y), z(xyz.z), w(_w) {}
+	Vec4x8(const Vec4& pVec) : x(pVec.x), y(pVec.y), z(pVec.z), w(pVec.w) {}
+
+	// Loads count (up to 8) consecutive Vec4s, missing lanes are zero
+	static Vec4x8 load(const Vec4* in, int count = 8) {
+#if defined(MYMATH_X86)
+		if (count == 8) {
+			__m128 r[8];
+			for (int i = 0; i < 8; i++) r[i] = _mm_loadu_ps(in[i].v);
+			_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+			_MM_TRANSPOSE4_PS(r[4], r[5], r[6], r[7]);
+#if defined(MYMATH_PACKET_AVX2)
+			return Vec4x8(_mm256_set_m128(r[4], r[0]), _mm256_set_m128(r[5], r[1]), _mm256_set_m128(r[6], r[2]), _mm256_set_m128(r[7], r[3]));
+#else
+			return Vec4x8(Floatx8(r[0], r[4]), Floatx8(r[1], r[5]), Floatx8(r[2], r[6]), Floatx8(r[3], r[7]));
+#endif
+		}
+#endif
+		float lanes[4][8] = {};
+		for (int i = 0; i < count; i++)
+			for (int c = 0; c < 4; c++) lanes[c][i] = in[i].v[c];
+		return Vec4x8(Floatx8::load(lanes[0]), Floatx8::load(lanes[1]), Floatx8::load(lanes[2]), Floatx8::load(lanes[3]));
+	}
+
+	// Loads base[indices[i]] into lane i
+	static Vec4x8 gather(const Vec4* base, const int* indices) {
+		const float* f = base[0].v;
+		return Vec4x8(Floatx8::gather(f, indices, 4), Floatx8::gather(f + 1, indices, 4), Floatx8::gather(f + 2, indices, 4), Floatx8::gather(f + 3, indices, 4));
+	}
+
+	// Stores the first count (up to 8) lanes as consecutive Vec4s
+	void store(Vec4* out, int count = 8) const {
+		float lanes[4][8];
+		x.store(lanes[0]); y.store(lanes[1]); z.store(lanes[2]); w.store(lanes[3]);
+		for (int i = 0; i < count; i++) out[i] = Vec4(lanes[0][i], lanes[1][i], lanes[2][i], lanes[3][i]);
+	}
+
+	Vec4 lane(int index) const { return Vec4(x.lane(index), y.lane(index), z.lane(index), w.lane(index)); }
+	Vec3x8 xyz() const { return Vec3x8(x, y, z); }
+
+	// Vec4x8 Operator Overloading
+	Vec4x8 operator+(const Vec4x8& p) const { return Vec4x8(x + p.x, y + p.y, z + p.z, w + p.w); }
+	Vec4x8 operator-(const Vec4x8& p) const { return Vec4x8(x - p.x, y - p.y, z - p.z, w - p.w); }
+	Vec4x8 operator*(const Vec4x8& p) const { return Vec4x8(x * p.x, y * p.y, z * p.z, w * p.w); }
+	Vec4x8 operator/(const Vec4x8& p) const { return Vec4x8(x / p.x, y / p.y, z / p.z, w / p.w); }
+	Vec4x8 operator*(const Floatx8& s) const { return Vec4x8(x * s, y * s, z * s, w * s); }
+	Vec4x8 operator/(const Floatx8& s) const { return Vec4x8(x / s, y / s, z / s, w / s); }
+	Vec4x8 operator-() const { return Vec4x8(-x, -y, -z, -w); }
+
+	// Methods
+	Floatx8 lengthSquare() const { return x * x + y * y + z * z + w * w; }
+	Floatx8 length() const { return lengthSquare().sqrt(); }
+	Vec4x8 normalize() const { return *this * (Floatx8(1.f) / length()); }
+	Floatx8 Dot(const Vec4x8& p) const { return x * p.x + y * p.y + z * p.z + w * p.w; }
+
+	Floatx8 Max() const { return ::Max(::Max(x, y), ::Max(z, w)); }
+	Floatx8 Min() const { return ::Min(::Min(x, y), ::Min(z, w)); }
+};
+
+inline Floatx8 Dot(const Vec4x8& v1, const Vec4x8& v2) { return v1.Dot(v2); }
+inline Vec4x8 Max(const Vec4x8& v1, const Vec4x8& v2) { return Vec4x8(Max(v1.x, v2.x), Max(v1.y, v2.y), Max(v1.z, v2.z), Max(v1.w, v2.w)); }
+inline Vec4x8 Min(const Vec4x8& v1, const Vec4x8& v2) { return Vec4x8(Min(v1.x, v2.x), Min(v1.y, v2.y), Min(v1.z, v2.z), Min(v1.w, v2.w)); }
+inline Vec4x8 Select(const Floatx8& mask, const Vec4x8& a, const Vec4x8& b) { return Vec4x8(Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z), Select(mask, a.w, b.w)); }
+
+// Affine (3x4) Matrix Class
+// Same row layout as the top three rows of Matrix (translation in column 3), the bottom row is
+// implicitly {0, 0, 0, 1} so composing and inverting skip the work a 4x4 matrix spends on it
+class Affine {
+public:
+	// Union elements can be accessed in the same memory address, unlike structs
+	// (rows lets the SSE compose hand its results over in registers instead of through a float array)
+	union {
+		float a[3][4];
+		float m[12];
+#ifdef MYMATH_X86
+		__m128 rows[3];
+#endif
+	};
+
+	// Constructors
+	// Initialize to identity
+	constexpr Affine() : m{ 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f } {}
+
+	constexpr Affine(float f1, float f2, float f3, float f4, float f5, float f6,
+					 float f7, float f8, float f9, float f10, float f11, float f12)
+		: m{ f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12 } {}
+
+	// Conversions (the bottom row of the Matrix is assumed to be {0, 0, 0, 1})
+	explicit constexpr Affine(const Matrix& matrix)
+		: m{ matrix.m[0], matrix.m[1], matrix.m[2], matrix.m[3], matrix.m[4], matrix.m[5],
+			 matrix.m[6], matrix.m[7], matrix.m[8], matrix.m[9], matrix.m[10], matrix.m[11] } {}
+
+	constexpr Matrix toMatrix() const {
+		return Matrix(m[0], m[1], m[2], m[3],
+					  m[4], m[5], m[6], m[7],
+					  m[8], m[9], m[10], m[11],
+					  0.f, 0.f, 0.f, 1.f);
+	}
+
+	// Operator Overloading
+	constexpr float& operator[](const int index) { return m[index]; }
+
+	// Methods
+	// Affine & Vector Multiplication
+	constexpr Vec3 mulPoint(const Vec3& v) const {
+		return Vec3((v.x * m[0] + v.y * m[1] + v.z * m[2]) + m[3],
+					(v.x * m[4] + v.y * m[5] + v.z * m[6]) + m[7],
+					(v.x * m[8] + v.y * m[9] + v.z * m[10]) + m[11]);
+	}
+
+	constexpr Vec3 mulVec(const Vec3& v) const {
+		return Vec3((v.x * m[0] + v.y * m[1] + v.z * m[2]),
+					(v.x * m[4] + v.y * m[5] + v.z * m[6]),
+					(v.x * m[8] + v.y * m[9] + v.z * m[10]));
+	}
+
+	// Compose, same order as Matrix::mul (this is applied first, then the argument) with 36 multiplies instead of 64
+	constexpr Affine mul(const Affine& affine) const {
+#ifdef MYMATH_X86
+		if (!MYMATH_CONSTANT_EVALUATED()) return mulSSE(affine);
+#endif
+		Affine ret;
+		for (int i = 0; i < 3; i++) {
+			const float* r = &affine.m[i * 4];
+			ret.m[i * 4 + 0] = r[0] * m[0] + r[1] * m[4] + r[2] * m[8];
+			ret.m[i * 4 + 1] = r[0] * m[1] + r[1] * m[5] + r[2] * m[9];
+			ret.m[i * 4 + 2] = r[0] * m[2] + r[1] * m[6] + r[2] * m[10];
+			ret.m[i * 4 + 3] = r[0] * m[3] + r[1] * m[7] + r[2] * m[11] + r[3];
+		}
+		return ret;
+	}
+
+#ifdef MYMATH_X86
+	// Row i of the result is affine row i's x, y and z broadcast against this one's rows, plus its translation
+	// (the same products and sums as the scalar loop, no FMA)
+	Affine mulSSE(const Affine& affine) const {
+		const __m128 translation = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+		Affine ret;
+		ret.rows[0] = composeRowSSE(affine.rows[0], translation);
+		ret.rows[1] = composeRowSSE(affine.rows[1], translation);
+		ret.rows[2] = composeRowSSE(affine.rows[2], translation);
+		return ret;
+	}
+
+	__m128 composeRowSSE(__m128 row, __m128 translation) const {
+		__m128 res = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), rows[0]);
+		res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), rows[1]));
+		res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), rows[2]));
+		return _mm_add_ps(res, _mm_and_ps(row, translation));
+	}
+#endif
+
+	constexpr Affine operator*(const Affine& affine) const { return mul(affine); }
+
+	// Translation
+	constexpr Vec3 translation() const { return Vec3(m[3], m[7], m[11]); }
+
+	// Inverse of a rotation + translation (rotation part is orthonormal): transpose and rotate the translation back
+	constexpr Affine inverseRigid() const {
+		return inverseFromRows(Vec3(m[0], m[4], m[8]), Vec3(m[1], m[5], m[9]), Vec3(m[2], m[6], m[10]));
+	}
+
+	// Inverse of a translation + rotation + (non-uniform) scale: the columns are orthogonal, so each row of
+	// the inverse is a column divided by its squared length
+	Affine inverseTRS() const {
+		Vec3 c0(m[0], m[4], m[8]), c1(m[1], m[5], m[9]), c2(m[2], m[6], m[10]);
+		return inverseFromRows(c0 / c0.lengthSquare(), c1 / c1.lengthSquare(), c2 / c2.lengthSquare());
+	}
+
+	// Inverse of any invertible affine transform (3x3 adjugate), falls back to identity like Matrix::invert
+	Affine inverse() const {
+		Vec3 r0(m[0], m[1], m[2]), r1(m[4], m[5], m[6]), r2(m[8], m[9], m[10]);
+		Vec3 c0 = Cross(r1, r2), c1 = Cross(r2, r0), c2 = Cross(r0, r1);
+		float det = Dot(r0, c0);
+		if (det == 0) {
+			std::cout << "det(M) = 0 [This matrix doesn't have an inverse... returning identity matrix for graceful termination]" << std::endl;
+			return Affine();
+		}
+		det = 1.f / det;
+		c0 *= det; c1 *= det; c2 *= det;
+		return inverseFromRows(Vec3(c0.x, c1.x, c2.x), Vec3(c0.y, c1.y, c2.y), Vec3(c0.z, c1.z, c2.z));
+	}
+
+	// Normal Matrix (inverse transpose of the 3x3 part, no translation)
+	// Uses the cofactors without dividing by the determinant, normals have to be renormalized anyway
+	constexpr Affine normalMatrix() const {
+		Vec3 r0(m[0], m[1], m[2]), r1(m[4], m[5], m[6]), r2(m[8], m[9], m[10]);
+		Vec3 c0 = Cross(r1, r2), c1 = Cross(r2, r0), c2 = Cross(r0, r1);
+		return Affine(c0.x, c0.y, c0.z, 0.f,
+					  c1.x, c1.y, c1.z, 0.f,
+					  c2.x, c2.y, c2.z, 0.f);
+	}
+
+	// Builders (mirror the Matrix ones)
+	static constexpr Affine identity() { return Affine(); }
+
+	static constexpr Affine translate(const Vec3& v) {
+		Affine trans;
+		trans[3] = v.x; trans[7] = v.y; trans[11] = v.z;
+		return trans;
+	}
+
+	static constexpr Affine scale(const Vec3& v) {
+		Affine sc;
+		sc[0] = v.x; sc[5] = v.y; sc[10] = v.z;
+		return sc;
+	}
+
+	template<typename MathPolicy = PreciseMath>
+	static constexpr Affine rotateOnXAxis(const float theta) { return Affine(Matrix::rotateOnXAxis<MathPolicy>(theta)); }
+	template<typename MathPolicy = PreciseMath>
+	static constexpr Affine rotateOnYAxis(const float theta) { return Affine(Matrix::rotateOnYAxis<MathPolicy>(theta)); }
+	template<typename MathPolicy = PreciseMath>
+	static constexpr Affine rotateOnZAxis(const float theta) { return Affine(Matrix::rotateOnZAxis<MathPolicy>(theta)); }
+
+	// Translation, Rotation & Scale (see Matrix::fromTRS), defined after Quaternion
+	static constexpr Affine fromTRS(const Vec3& translation, const Quaternion& rotation, const Vec3& scale);
+
+	// Splits the transform into translation, rotation and scale, a mirroring transform gets a negative x scale
+	// Returns false (rotation left as identity) when an axis is scaled to zero
+	bool decompose(Vec3& translation, Quaternion& rotation, Vec3& scale) const;
+
+private:
+	// Inverse given the rows of the inverted 3x3 part, translation becomes -(inverse * t)
+	constexpr Affine inverseFromRows(const Vec3& r0, const Vec3& r1, const Vec3& r2) const {
+		Vec3 t = translation();
+		return Affine(r0.x, r0.y, r0.z, -Dot(r0, t),
+					  r1.x, r1.y, r1.z, -Dot(r1, t),
+					  r2.x, r2.y, r2.z, -Dot(r2, t));
+	}
+};
+
 // Spherical Coordinate Class
 class SphericalCoordinate {
 public:
@@ -432,32 +1579,50 @@ public:
 
 	// Methods
 	// Shading (Z-Up) - Convert from Cartesian
+	template<typename MathPolicy = PreciseMath>
 	SphericalCoordinate zUpFromCartesian(const Vec3& cartesian) {
 		if (cartesian.lengthSquare() == 0) return SphericalCoordinate();
-		theta = acos(cartesian.z / r);
-		phi = atan2f(cartesian.y, cartesian.x);
+		theta = MathPolicy::acos(cartesian.z / r);
+		phi = MathPolicy::atan2(cartesian.y, cartesian.x);
 		return SphericalCoordinate(phi, theta);
 	}
 
 	// Camera (Y-Up) - Convert from Cartesian
+	template<typename MathPolicy = PreciseMath>
 	SphericalCoordinate yUpFromCartesian(const Vec3& cartesian) {
 		if (cartesian.lengthSquare() == 0) return SphericalCoordinate();
-		theta = acos(cartesian.y / r);
-		phi = atan2f(cartesian.z, cartesian.x);
+		theta = MathPolicy::acos(cartesian.y / r);
+		phi = MathPolicy::atan2(cartesian.z, cartesian.x);
 		return SphericalCoordinate(phi, theta);
 	}
 
 	// Shading (Z-Up) - Convert to Cartesian
-	Vec3 zUpToCartesian() { return Vec3(r * sin(theta) * cos(phi), r * sin(theta) * sin(phi), r * cos(theta)); }
+	template<typename MathPolicy = PreciseMath>
+	Vec3 zUpToCartesian() {
+		float sinTheta = 0.f, cosTheta = 0.f, sinPhi = 0.f, cosPhi = 0.f;
+		MathPolicy::sincos(theta, sinTheta, cosTheta);
+		MathPolicy::sincos(phi, sinPhi, cosPhi);
+		return Vec3(r * sinTheta * cosPhi, r * sinTheta * sinPhi, r * cosTheta);
+	}
 
 	// Camera (Y-Up) - Convert to Cartesian
-	Vec3 yUpToCartesian() { return Vec3(r * sin(theta) * cos(phi), r * cos(theta), r * sin(theta) * sin(phi)); }
+	template<typename MathPolicy = PreciseMath>
+	Vec3 yUpToCartesian() {
+		float sinTheta = 0.f, cosTheta = 0.f, sinPhi = 0.f, cosPhi = 0.f;
+		MathPolicy::sincos(theta, sinTheta, cosTheta);
+		MathPolicy::sincos(phi, sinPhi, cosPhi);
+		return Vec3(r * sinTheta * cosPhi, r * cosTheta, r * sinTheta * sinPhi);
+	}
 
 	// Calculate theta and phi w.r.t. shading (z-up) and camera (y-up)
-	float zUpCalculateTheta(const Vec3& cartesian) const { return acos(cartesian.z / r); }
-	float yUpCalculateTheta(const Vec3& cartesian) const { return acos(cartesian.y / r); }
-	float zUpCalculatePhi(const Vec3& cartesian) const { return atan2f(cartesian.y, cartesian.x); }
-	float yUpCalculatePhi(const Vec3& cartesian)  const { return atan2f(cartesian.z, cartesian.x); }
+	template<typename MathPolicy = PreciseMath>
+	float zUpCalculateTheta(const Vec3& cartesian) const { return MathPolicy::acos(cartesian.z / r); }
+	template<typename MathPolicy = PreciseMath>
+	float yUpCalculateTheta(const Vec3& cartesian) const { return MathPolicy::acos(cartesian.y / r); }
+	template<typename MathPolicy = PreciseMath>
+	float zUpCalculatePhi(const Vec3& cartesian) const { return MathPolicy::atan2(cartesian.y, cartesian.x); }
+	template<typename MathPolicy = PreciseMath>
+	float yUpCalculatePhi(const Vec3& cartesian)  const { return MathPolicy::atan2(cartesian.z, cartesian.x); }
 };
 
 // Quaternion Class
@@ -472,12 +1637,12 @@ public:
 	};
 
 	// Constructors
-	Quaternion() : a(0.f), b(0.f), c(0.f), d(0.f) {}
-	Quaternion(float _d, float _a, float _b, float _c) : a(_a), b(_b), c(_c), d(_d) {}
+	constexpr Quaternion() : a(0.f), b(0.f), c(0.f), d(0.f) {}
+	constexpr Quaternion(float _d, float _a, float _b, float _c) : a(_a), b(_b), c(_c), d(_d) {}
 
 	// Operator Overloading
 	// Unary Negate
-	Quaternion operator-() { return Quaternion(-a, -b, -c, -d); }
+	constexpr Quaternion operator-() const { return Quaternion(-d, -a, -b, -c); }
 
 	// Methods
 	// Magnitude
@@ -487,21 +1652,20 @@ public:
 	Quaternion normalize() {
 		float mag = sqrt(SQ(a) + SQ(b) + SQ(c) + SQ(d));
 		mag = 1.f / mag;
-		return Quaternion(a * mag, b * mag, c * mag, d * mag);
+		return Quaternion(d * mag, a * mag, b * mag, c * mag);
 	}
 
 	// Conjugate
-	Quaternion conjugate() { return Quaternion(-a, -b, -c, d); }
+	constexpr Quaternion conjugate() const { return Quaternion(d, -a, -b, -c); }
 
-	// Inverse
+	// Inverse (conjugate over the squared magnitude)
 	Quaternion inverse() {
-		float mag = sqrt(SQ(a) + SQ(b) + SQ(c) + SQ(d));
-		mag = 1.f / mag;
+		float inverseSquare = 1.f / (SQ(a) + SQ(b) + SQ(c) + SQ(d));
 		Quaternion conj = conjugate();
-		return Quaternion(conj.a * mag, conj.b * mag, conj.c * mag, conj.d * mag);
+		return Quaternion(conj.d * inverseSquare, conj.a * inverseSquare, conj.b * inverseSquare, conj.c * inverseSquare);
 	}
 
-	Quaternion operator*(Quaternion q1) {
+	constexpr Quaternion operator*(Quaternion q1) const {
 		Quaternion v;
 		v.a = ((d * q1.a) + (a * q1.d) + (b * q1.c) - (c * q1.b));
 		v.b = ((d * q1.b) - (a * q1.c) + (b * q1.d) + (c * q1.a));
@@ -511,16 +1675,16 @@ public:
 	}
 
 	// Multiply
-	Quaternion multiply(const Quaternion& q2) {
-		return Quaternion(((d * q2.a) + (a * q2.d) + (b * q2.c) - (c * q2.b)),
+	constexpr Quaternion multiply(const Quaternion& q2) const {
+		return Quaternion(((d * q2.d) - (a * q2.a) - (b * q2.b) - (c * q2.c)),
+						  ((d * q2.a) + (a * q2.d) + (b * q2.c) - (c * q2.b)),
 						  ((d * q2.b) - (a * q2.c) + (b * q2.d) + (c * q2.a)),
-						  ((d * q2.c) + (a * q2.b) - (b * q2.a) + (c * q2.d)),
-						  ((d * q2.d) - (a * q2.a) - (b * q2.b) - (c * q2.c)));
+						  ((d * q2.c) + (a * q2.b) - (b * q2.a) + (c * q2.d)));
 	}
 
 	// Construct a Quaternion from axis-angle
 	Quaternion fromAxisAngle(const Vec3& pVec, const float theta) {
-		return Quaternion(pVec.x * sin(theta / 2), pVec.y * sin(theta / 2), pVec.z * sin(theta / 2), cos(theta / 2));
+		return Quaternion(cos(theta / 2), pVec.x * sin(theta / 2), pVec.y * sin(theta / 2), pVec.z * sin(theta / 2));
 	}
 
 	void rotateAboutAxis(Vec3 pt, float angle, Vec3 axis) {
@@ -538,7 +1702,7 @@ public:
 	}
 
 	// Quaternion to Matrix
-	Matrix toMatrix() const {
+	constexpr Matrix toMatrix() const {
 		Matrix m;
 		float aa = a * a, ab = a * b, ac = a * c;
 		float bb = b * b, bc = b * c, cc = c * c;
@@ -551,10 +1715,34 @@ public:
 		return m;
 	}
 
+	// Rotation matrix (orthonormal 3x3 part) to Quaternion
+	// Solves for the largest component first so the divisor never gets close to zero
+	static Quaternion fromMatrix(const Affine& r) {
+		const float* m = r.m;
+		float trace = m[0] + m[5] + m[10];
+		if (trace > 0.f) {
+			float s = 0.5f / sqrtf(trace + 1.f);
+			return Quaternion(0.25f / s, (m[9] - m[6]) * s, (m[2] - m[8]) * s, (m[4] - m[1]) * s);
+		}
+		if (m[0] > m[5] && m[0] > m[10]) {
+			float s = 0.5f / sqrtf(1.f + m[0] - m[5] - m[10]);
+			return Quaternion((m[9] - m[6]) * s, 0.25f / s, (m[1] + m[4]) * s, (m[2] + m[8]) * s);
+		}
+		if (m[5] > m[10]) {
+			float s = 0.5f / sqrtf(1.f + m[5] - m[0] - m[10]);
+			return Quaternion((m[2] - m[8]) * s, (m[1] + m[4]) * s, 0.25f / s, (m[6] + m[9]) * s);
+		}
+		float s = 0.5f / sqrtf(1.f + m[10] - m[0] - m[5]);
+		return Quaternion((m[4] - m[1]) * s, (m[2] + m[8]) * s, (m[6] + m[9]) * s, 0.25f / s);
+	}
+
+	static Quaternion fromMatrix(const Matrix& m) { return fromMatrix(Affine(m)); }
+
 	// Dot Product
-	float Dot(const Quaternion& q) const { return d * q.d + a * q.a + b * q.b + c * q.c; }
+	constexpr float Dot(const Quaternion& q) const { return d * q.d + a * q.a + b * q.b + c * q.c; }
 
 	// Spherical Linear Interpolation
+	template<typename MathPolicy = PreciseMath>
 	static Quaternion slerp(Quaternion q1, Quaternion q2, float t) {
 		Quaternion qr;
 		float dp = q1.a * q2.a + q1.b * q2.b + q1.c * q2.c + q1.d * q2.d;
@@ -562,12 +1750,12 @@ public:
 		Quaternion q11 = (dp < 0) ? -q1 : q1;
 		dp = (dp > 0) ? dp : -dp;
 
-		float theta = acosf(clamp(dp, -1.0f, 1.0f));
+		float theta = MathPolicy::acos(clamp(dp, -1.0f, 1.0f));
 		if (theta == 0) return q1;
 
-		float d = sinf(theta);
-		float a = sinf((1 - t) * theta);
-		float b = sinf(t * theta);
+		float d = MathPolicy::sin(theta);
+		float a = MathPolicy::sin((1 - t) * theta);
+		float b = MathPolicy::sin(t * theta);
 		float coeff1 = a / d;
 		float coeff2 = b / d;
 
@@ -576,20 +1764,257 @@ public:
 		qr.c = coeff1 * q11.c + coeff2 * q2.c;
 		qr.d = coeff1 * q11.d + coeff2 * q2.d;
 
-		qr.normalize();
-		return qr;
+		return qr.normalize();
 	}
 };
 
-float Dot(const Quaternion& q1, const Quaternion& q2) { return q1.d * q2.d + q1.a * q2.a + q1.b * q2.b + q1.c * q2.c; }
+constexpr float Dot(const Quaternion& q1, const Quaternion& q2) { return q1.d * q2.d + q1.a * q2.a + q1.b * q2.b + q1.c * q2.c; }
 
-Quaternion multiply(const Quaternion& q1, const Quaternion& q2) {
+constexpr Quaternion multiply(const Quaternion& q1, const Quaternion& q2) {
 	return Quaternion((q1.d * q2.d - q1.a * q2.a - q1.b * q2.b - q1.c * q2.c),
 					  (q1.d * q2.a + q1.a * q2.d + q1.b * q2.c - q1.c * q2.b),
 					  (q1.d * q2.b - q1.a * q2.c + q1.b * q2.d + q1.c * q2.a),
 					  (q1.d * q2.c + q1.a * q2.b - q1.b * q2.a + q1.c * q2.d));
 }
 
+// Translation, Rotation & Scale (declared in Affine and Matrix)
+// Column c of the rotation is scaled by scale[c], translation goes straight into the last column
+constexpr Affine Affine::fromTRS(const Vec3& translation, const Quaternion& rotation, const Vec3& scale) {
+	float aa = rotation.a * rotation.a, ab = rotation.a * rotation.b, ac = rotation.a * rotation.c;
+	float bb = rotation.b * rotation.b, bc = rotation.b * rotation.c, cc = rotation.c * rotation.c;
+	float da = rotation.d * rotation.a, db = rotation.d * rotation.b, dc = rotation.d * rotation.c;
+
+	return Affine((1.f - 2.f * (bb + cc)) * scale.x, 2.f * (ab - dc) * scale.y, 2.f * (ac + db) * scale.z, translation.x,
+				  2.f * (ab + dc) * scale.x, (1.f - 2.f * (aa + cc)) * scale.y, 2.f * (bc - da) * scale.z, translation.y,
+				  2.f * (ac - db) * scale.x, 2.f * (bc + da) * scale.y, (1.f - 2.f * (aa + bb)) * scale.z, translation.z);
+}
+
+constexpr Matrix Matrix::fromTRS(const Vec3& translation, const Quaternion& rotation, const Vec3& scale) {
+	return Affine::fromTRS(translation, rotation, scale).toMatrix();
+}
+
+// Decomposition (declared in Affine and Matrix)
+// Scale is the length of each column, dividing it out leaves the rotation
+inline bool Affine::decompose(Vec3& translation, Quaternion& rotation, Vec3& scale) const {
+	Vec3 c0(m[0], m[4], m[8]), c1(m[1], m[5], m[9]), c2(m[2], m[6], m[10]);
+	translation = Vec3(m[3], m[7], m[11]);
+	scale = Vec3(c0.length(), c1.length(), c2.length());
+	if (Dot(c0, Cross(c1, c2)) < 0.f) scale.x = -scale.x;
+
+	if (scale.x == 0.f || scale.y == 0.f || scale.z == 0.f) {
+		rotation = Quaternion(1.f, 0.f, 0.f, 0.f);
+		return false;
+	}
+	c0 /= scale.x; c1 /= scale.y; c2 /= scale.z;
+	rotation = Quaternion::fromMatrix(Affine(c0.x, c1.x, c2.x, 0.f,
+											 c0.y, c1.y, c2.y, 0.f,
+											 c0.z, c1.z, c2.z, 0.f)).normalize();
+	return true;
+}
+
+inline bool Matrix::decompose(Vec3& translation, Quaternion& rotation, Vec3& scale) const {
+	return Affine(*this).decompose(translation, rotation, scale);
+}
+
+// Batched Quaternion Interpolation
+// Interpolates whole rotation tracks (e.g. every bone of a skeleton between two keyframes) in one call
+// Nlerp: lerp along the shorter arc and renormalize, the rotation error grows with the angle between the keys
+//        (~2e-5 rad for keys 10 degrees apart, up to 0.14 rad for keys on opposite sides)
+// Slerp: sin(t * theta) / sin(theta) from Eberly's "A Fast and Accurate Estimate for SLERP" (8 terms), no
+//        acos/sin/divide, rotation error < 2e-5 rad over the whole range and |q| within 3e-5 of 1
+enum QuaternionInterpolation { QuaternionNlerp, QuaternionSlerp };
+
+struct QuaternionKernels {
+	void (*interpolate)(const Quaternion* from, const Quaternion* to, Quaternion* out, int count, float t, QuaternionInterpolation mode);
+};
+
+// Eberly's coefficients u_i = 1 / (i * (2i + 1)), v_i = i / (2i + 1), the last pair scaled by 1 + mu
+static const float slerpU[8] = { 1.f / (1 * 3), 1.f / (2 * 5), 1.f / (3 * 7), 1.f / (4 * 9), 1.f / (5 * 11), 1.f / (6 * 13), 1.f / (7 * 15), 1.85298109240830f / (8 * 17) };
+static const float slerpV[8] = { 1.f / 3, 2.f / 5, 3.f / 7, 4.f / 9, 5.f / 11, 6.f / 13, 7.f / 15, 1.85298109240830f * 8 / 17 };
+
+inline void quaternionInterpolateScalar(const Quaternion* from, const Quaternion* to, Quaternion* out, int count, float t, QuaternionInterpolation mode) {
+	for (int i = 0; i < count; i++) {
+		// Shorter arc: flip the start key when the keys are on opposite hemispheres
+		float dp = Dot(from[i], to[i]);
+		Quaternion q1 = (dp < 0) ? -from[i] : from[i];
+		dp = fabsf(dp);
+
+		float c1, c2;
+		if (mode == QuaternionSlerp) {
+			float xm1 = dp - 1.f, d = 1.f - t;
+			float rT = 1.f, rD = 1.f;
+			for (int k = 7; k >= 0; k--) {
+				rT = 1.f + (slerpU[k] * t * t - slerpV[k]) * xm1 * rT;
+				rD = 1.f + (slerpU[k] * d * d - slerpV[k]) * xm1 * rD;
+			}
+			c1 = d * rD;
+			c2 = t * rT;
+		} else {
+			c1 = 1.f - t;
+			c2 = t;
+		}
+
+		Quaternion r(c1 * q1.d + c2 * to[i].d, c1 * q1.a + c2 * to[i].a, c1 * q1.b + c2 * to[i].b, c1 * q1.c + c2 * to[i].c);
+		out[i] = (mode == QuaternionSlerp) ? r : r.normalize();
+	}
+}
+
+#ifdef MYMATH_X86
+// Quaternions are transposed into a/b/c/d lanes (SoA), four per SSE register or eight per AVX2 register
+// Blends four quaternions already in lanes, each lane by its own t, the result replaces the to lanes (also used by
+// decoders that build the lanes themselves, e.g. compressed animation keys)
+inline void quaternionBlendLanesSSE(__m128 a1, __m128 b1, __m128 c1, __m128 d1, __m128& a2, __m128& b2, __m128& c2, __m128& d2, __m128 tt, QuaternionInterpolation mode) {
+	const __m128 signMask = _mm_set1_ps(-0.f);
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 dd = _mm_sub_ps(one, tt);
+
+	__m128 dp = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a1, a2), _mm_mul_ps(b1, b2)), _mm_add_ps(_mm_mul_ps(c1, c2), _mm_mul_ps(d1, d2)));
+	__m128 sign = _mm_and_ps(dp, signMask);
+	a1 = _mm_xor_ps(a1, sign); b1 = _mm_xor_ps(b1, sign); c1 = _mm_xor_ps(c1, sign); d1 = _mm_xor_ps(d1, sign);
+
+	__m128 w1 = dd, w2 = tt;
+	if (mode == QuaternionSlerp) {
+		const __m128 t2 = _mm_mul_ps(tt, tt), dd2 = _mm_mul_ps(dd, dd);
+		__m128 xm1 = _mm_sub_ps(_mm_andnot_ps(signMask, dp), one);
+		__m128 rT = one, rD = one;
+		for (int k = 7; k >= 0; k--) {
+			__m128 u = _mm_set1_ps(slerpU[k]), v = _mm_set1_ps(slerpV[k]);
+			rT = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(u, t2), v), xm1), rT));
+			rD = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(u, dd2), v), xm1), rD));
+		}
+		w1 = _mm_mul_ps(dd, rD);
+		w2 = _mm_mul_ps(tt, rT);
+	}
+
+	__m128 ra = _mm_add_ps(_mm_mul_ps(w1, a1), _mm_mul_ps(w2, a2));
+	__m128 rb = _mm_add_ps(_mm_mul_ps(w1, b1), _mm_mul_ps(w2, b2));
+	__m128 rc = _mm_add_ps(_mm_mul_ps(w1, c1), _mm_mul_ps(w2, c2));
+	__m128 rd = _mm_add_ps(_mm_mul_ps(w1, d1), _mm_mul_ps(w2, d2));
+	if (mode == QuaternionNlerp) {
+		__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ra, ra), _mm_mul_ps(rb, rb)), _mm_add_ps(_mm_mul_ps(rc, rc), _mm_mul_ps(rd, rd))));
+		__m128 inv = _mm_div_ps(one, len);
+		ra = _mm_mul_ps(ra, inv); rb = _mm_mul_ps(rb, inv); rc = _mm_mul_ps(rc, inv); rd = _mm_mul_ps(rd, inv);
+	}
+	a2 = ra; b2 = rb; c2 = rc; d2 = rd;
+}
+
+inline void quaternionInterpolateSSE(const Quaternion* from, const Quaternion* to, Quaternion* out, int count, float t, QuaternionInterpolation mode) {
+	const __m128 tt = _mm_set1_ps(t);
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 a1 = _mm_loadu_ps(from[i].q), b1 = _mm_loadu_ps(from[i + 1].q), c1 = _mm_loadu_ps(from[i + 2].q), d1 = _mm_loadu_ps(from[i + 3].q);
+		__m128 a2 = _mm_loadu_ps(to[i].q), b2 = _mm_loadu_ps(to[i + 1].q), c2 = _mm_loadu_ps(to[i + 2].q), d2 = _mm_loadu_ps(to[i + 3].q);
+		_MM_TRANSPOSE4_PS(a1, b1, c1, d1);
+		_MM_TRANSPOSE4_PS(a2, b2, c2, d2);
+		quaternionBlendLanesSSE(a1, b1, c1, d1, a2, b2, c2, d2, tt, mode);
+		_MM_TRANSPOSE4_PS(a2, b2, c2, d2);
+		_mm_storeu_ps(out[i].q, a2);
+		_mm_storeu_ps(out[i + 1].q, b2);
+		_mm_storeu_ps(out[i + 2].q, c2);
+		_mm_storeu_ps(out[i + 3].q, d2);
+	}
+	quaternionInterpolateScalar(from + i, to + i, out + i, count - i, t, mode);
+}
+
+// 4x4 transpose within each 128-bit half, turns {q0|q4}, {q1|q5}, {q2|q6}, {q3|q7} into a/b/c/d lanes and back
+#define MYMATH_TRANSPOSE4_256(r0, r1, r2, r3) { \
+	__m256 t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpacklo_ps(r2, r3); \
+	__m256 t2 = _mm256_unpackhi_ps(r0, r1), t3 = _mm256_unpackhi_ps(r2, r3); \
+	r0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0)); \
+	r1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2)); \
+	r2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0)); \
+	r3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2)); }
+
+MYMATH_TARGET_AVX2 inline __m256 loadQuaternionPair(const Quaternion* q, int offset) {
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(q[offset].q)), _mm_loadu_ps(q[offset + 4].q), 1);
+}
+
+MYMATH_TARGET_AVX2 inline void storeQuaternionPair(Quaternion* q, int offset, __m256 v) {
+	_mm_storeu_ps(q[offset].q, _mm256_castps256_ps128(v));
+	_mm_storeu_ps(q[offset + 4].q, _mm256_extractf128_ps(v, 1));
+}
+
+MYMATH_TARGET_AVX2 inline void quaternionBlendLanesAVX2(__m256 a1, __m256 b1, __m256 c1, __m256 d1, __m256& a2, __m256& b2, __m256& c2, __m256& d2, __m256 tt, QuaternionInterpolation mode) {
+	const __m256 signMask = _mm256_set1_ps(-0.f);
+	const __m256 one = _mm256_set1_ps(1.f);
+	const __m256 dd = _mm256_sub_ps(one, tt);
+
+	__m256 dp = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a1, a2), _mm256_mul_ps(b1, b2)), _mm256_add_ps(_mm256_mul_ps(c1, c2), _mm256_mul_ps(d1, d2)));
+	__m256 sign = _mm256_and_ps(dp, signMask);
+	a1 = _mm256_xor_ps(a1, sign); b1 = _mm256_xor_ps(b1, sign); c1 = _mm256_xor_ps(c1, sign); d1 = _mm256_xor_ps(d1, sign);
+
+	__m256 w1 = dd, w2 = tt;
+	if (mode == QuaternionSlerp) {
+		const __m256 t2 = _mm256_mul_ps(tt, tt), dd2 = _mm256_mul_ps(dd, dd);
+		__m256 xm1 = _mm256_sub_ps(_mm256_andnot_ps(signMask, dp), one);
+		__m256 rT = one, rD = one;
+		for (int k = 7; k >= 0; k--) {
+			__m256 u = _mm256_set1_ps(slerpU[k]), v = _mm256_set1_ps(slerpV[k]);
+			rT = _mm256_add_ps(one, _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(u, t2), v), xm1), rT));
+			rD = _mm256_add_ps(one, _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(u, dd2), v), xm1), rD));
+		}
+		w1 = _mm256_mul_ps(dd, rD);
+		w2 = _mm256_mul_ps(tt, rT);
+	}
+
+	__m256 ra = _mm256_add_ps(_mm256_mul_ps(w1, a1), _mm256_mul_ps(w2, a2));
+	__m256 rb = _mm256_add_ps(_mm256_mul_ps(w1, b1), _mm256_mul_ps(w2, b2));
+	__m256 rc = _mm256_add_ps(_mm256_mul_ps(w1, c1), _mm256_mul_ps(w2, c2));
+	__m256 rd = _mm256_add_ps(_mm256_mul_ps(w1, d1), _mm256_mul_ps(w2, d2));
+	if (mode == QuaternionNlerp) {
+		__m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ra, ra), _mm256_mul_ps(rb, rb)), _mm256_add_ps(_mm256_mul_ps(rc, rc), _mm256_mul_ps(rd, rd))));
+		__m256 inv = _mm256_div_ps(one, len);
+		ra = _mm256_mul_ps(ra, inv); rb = _mm256_mul_ps(rb, inv); rc = _mm256_mul_ps(rc, inv); rd = _mm256_mul_ps(rd, inv);
+	}
+	a2 = ra; b2 = rb; c2 = rc; d2 = rd;
+}
+
+MYMATH_TARGET_AVX2 inline void quaternionInterpolateAVX2(const Quaternion* from, const Quaternion* to, Quaternion* out, int count, float t, QuaternionInterpolation mode) {
+	const __m256 tt = _mm256_set1_ps(t);
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 a1 = loadQuaternionPair(from + i, 0), b1 = loadQuaternionPair(from + i, 1), c1 = loadQuaternionPair(from + i, 2), d1 = loadQuaternionPair(from + i, 3);
+		__m256 a2 = loadQuaternionPair(to + i, 0), b2 = loadQuaternionPair(to + i, 1), c2 = loadQuaternionPair(to + i, 2), d2 = loadQuaternionPair(to + i, 3);
+		MYMATH_TRANSPOSE4_256(a1, b1, c1, d1);
+		MYMATH_TRANSPOSE4_256(a2, b2, c2, d2);
+		quaternionBlendLanesAVX2(a1, b1, c1, d1, a2, b2, c2, d2, tt, mode);
+		MYMATH_TRANSPOSE4_256(a2, b2, c2, d2);
+		storeQuaternionPair(out + i, 0, a2);
+		storeQuaternionPair(out + i, 1, b2);
+		storeQuaternionPair(out + i, 2, c2);
+		storeQuaternionPair(out + i, 3, d2);
+	}
+	quaternionInterpolateSSE(from + i, to + i, out + i, count - i, t, mode);
+}
+#endif
+
+inline QuaternionKernels createQuaternionKernels(SimdLevel level) {
+	QuaternionKernels kernels = { quaternionInterpolateScalar };
+#ifdef MYMATH_X86
+	if (level >= SimdSSE) kernels.interpolate = quaternionInterpolateSSE;
+	if (level >= SimdAVX2) kernels.interpolate = quaternionInterpolateAVX2;
+#endif
+	return kernels;
+}
+
+inline QuaternionKernels& quaternionKernels() {
+	static QuaternionKernels kernels = createQuaternionKernels(detectSimdLevel());
+	return kernels;
+}
+
+// Interpolate count quaternion pairs with the same t (in and out may be the same array)
+inline void interpolateQuaternions(const Quaternion* from, const Quaternion* to, Quaternion* out, int count, float t, QuaternionInterpolation mode = QuaternionSlerp) {
+	quaternionKernels().interpolate(from, to, out, count, t, mode);
+}
+
+// Force a SIMD level (e.g. SimdScalar to compare against the reference), clamped to what the CPU supports
+inline SimdLevel setSimdLevel(SimdLevel level) {
+	level = std::min<SimdLevel>(level, detectSimdLevel());
+	matrixKernels() = createMatrixKernels(level);
+	quaternionKernels() = createQuaternionKernels(level);
+	return level;
+}
+
 // Colour Class
 class Colour {
 public:
@@ -606,6 +2031,12 @@ public:
 	Colour(unsigned char _r, unsigned char _g, unsigned char _b) : r(_r / 255.f), g(_g / 255.f), b(_b / 255.f), a(1.f) {}
 	Colour(unsigned char _r, unsigned char _g, unsigned char _b, unsigned char _a) : r(_r / 255.f), g(_g / 255.f), b(_b / 255.f), a(_a) {}
 
+#if defined(MYMATH_EXPRESSION_TEMPLATES)
+	// Evaluate an expression (see Expression Templates)
+	template<typename E, typename = typename std::enable_if<IsExprOf<E, Colour>::value>::type>
+	Colour(const E& e) : r(e.component(0)), g(e.component(1)), b(e.component(2)), a(e.component(3)) {}
+	float component(int i) const { return c[i]; }
+#else
 	// Operator Overloading
 	Colour operator+(const Colour& colour) const { return Colour(r + colour.r, g + colour.g, b + colour.b, a + colour.a); }
 	Colour operator-(const Colour& colour) const { return Colour(r - colour.r, g - colour.g, b - colour.b, a - colour.a); }
@@ -613,19 +2044,17 @@ public:
 	Colour operator*(const float scalar) const { return Colour(r * scalar, g * scalar, b * scalar, a * scalar); }
 	Colour operator/(const Colour& colour) const { return Colour(r / colour.r, g / colour.g, b / colour.b, a / colour.a); }
 	Colour operator/(const float scalar) const { return Colour(r / scalar, g / scalar, b / scalar, a / scalar); }
+#endif
 };
 
 // Triangle Class
 class Triangle {
 public:
-	// Union elements can be accessed in the same memory address, unlike structs
-	union {
-		Vec4 v[3];
-		struct { Vec4 v0, v1, v2; };
-	};
+	// Plain array, an anonymous struct of Vec4s (types with constructors) inside a union only builds on MSVC
+	Vec4 v[3];
 
 	// Constructor
-	Triangle(const Vec4& _v0, const Vec4& _v1, const Vec4& _v2) : v0(_v0), v1(_v1), v2(_v2) {}
+	Triangle(const Vec4& _v0, const Vec4& _v1, const Vec4& _v2) : v{ _v0, _v1, _v2 } {}
 };
 
 // Edge Function
@@ -675,31 +2104,226 @@ public:
 };
 
 // Bezier Curve
+// Binomial-weighted control points are precomputed on load, so a sample is one Horner pass in s = t / (1 - t)
+// (or (1 - t) / t past the midpoint, keeping |s| <= 1) instead of n + 1 binomials and two pows per point.
+// Weights are kept in double, the old int factorials overflowed from degree 13.
+// Uniform batches of low degree curves use forward differencing (n adds per point) seeded from the power basis,
+// and an arc-length table maps distance to t for constant speed traversal.
 class BezierCurve {
 public:
+	// Highest degree sampled with forward differencing, the power basis cancels too much beyond it
+	static const int maxForwardDifferenceDegree = 8;
+
 	std::vector<Vec3> controlPoints;
-	int factorial(int n) {
-		if (n == 0 || n == 1) return 1;
-		return n * factorial(n - 1);
-	}
+	std::vector<double> weighted;    // xyz of C(n, i) * P[i]
+	std::vector<double> powerBasis;  // xyz of c[k] with P(t) = sum c[k] * t^k (degree <= maxForwardDifferenceDegree)
+	std::vector<float> arcLengths;   // Length from t = 0 to t = i / (arcLengths.size() - 1)
 
-	int findBinomialCoefficient(int n, int i) {
-		return factorial(n) / (factorial(i) * factorial(n - i));
+	static double binomialCoefficient(int n, int i) {
+		double ret = 1.0;
+		for (int k = 1; k <= i; k++) ret = ret * (n - i + k) / k;
+		return ret;
 	}
 
-	void loadControlPoints(std::vector<Vec3>& _controlPoints) {
+	// Precomputes the weights and builds the arc-length table (see buildArcLengthTable)
+	void loadControlPoints(const std::vector<Vec3>& _controlPoints, int arcLengthSegments = 256) {
 		controlPoints = _controlPoints;
+		int n = degree();
+		weighted.resize(3 * (n + 1));
+		for (int i = 0; i <= n; i++) {
+			double w = binomialCoefficient(n, i);
+			weighted[3 * i] = w * controlPoints[i].x;
+			weighted[3 * i + 1] = w * controlPoints[i].y;
+			weighted[3 * i + 2] = w * controlPoints[i].z;
+		}
+
+		// c[k] = C(n, k) * sum_i (-1)^(k - i) * C(k, i) * P[i]
+		powerBasis.clear();
+		if (n <= maxForwardDifferenceDegree) {
+			powerBasis.assign(3 * (n + 1), 0.0);
+			for (int k = 0; k <= n; k++) {
+				double* c = &powerBasis[3 * k];
+				for (int i = 0; i <= k; i++) {
+					double w = binomialCoefficient(k, i) * (((k - i) & 1) ? -1.0 : 1.0);
+					c[0] += w * controlPoints[i].x;
+					c[1] += w * controlPoints[i].y;
+					c[2] += w * controlPoints[i].z;
+				}
+				double nk = binomialCoefficient(n, k);
+				c[0] *= nk; c[1] *= nk; c[2] *= nk;
+			}
+		}
+		buildArcLengthTable(arcLengthSegments);
 	}
 
-	Vec3 evaluateT(float t) {
-		int n = controlPoints.size() - 1;  // n = degree
-		Vec3 result;
+	int degree() const { return (int)controlPoints.size() - 1; }
+
+	// Point at t in [0, 1]
+	// P(t) = (1 - t)^n * sum C(n, i) * P[i] * s^i with s = t / (1 - t), mirrored for t > 0.5
+	Vec3 evaluateT(float t) const {
+		int n = degree();
+		if (n < 0) return Vec3();
+		bool mirrored = t > 0.5f;
+		double u = mirrored ? t : 1.0 - t;
+		double s = mirrored ? (1.0 - t) / t : t / (1.0 - t);
+		double x = 0.0, y = 0.0, z = 0.0, scale = 1.0;
+		for (int k = 0; k <= n; k++) {
+			const double* w = &weighted[3 * (mirrored ? k : n - k)];
+			x = x * s + w[0]; y = y * s + w[1]; z = z * s + w[2];
+			scale *= u;
+		}
+		scale /= u;  // (1 - t)^n (or t^n), the loop ran n + 1 times
+		return Vec3((float)(x * scale), (float)(y * scale), (float)(z * scale));
+	}
 
-		for (int i = 0; i <= n; i++) {
-			int binomialCoefficient = findBinomialCoefficient(n, i);
-			float bernsteinBasis = binomialCoefficient * pow((1.f - t), (n - i)) * pow(t, i);
-			result += controlPoints[i] * bernsteinBasis;
+	// Tangent (dP/dt) at t in [0, 1], n times the degree n - 1 curve of the control point differences
+	Vec3 derivativeT(float t) const {
+		int n = degree();
+		if (n < 1) return Vec3();
+		Vec3 ret;
+		float u = 1.f - t, b = powf(u, (float)(n - 1)), s = u > 0.f ? t / u : 0.f;
+		if (u > 0.f) {
+			for (int i = 0; i < n; i++) {
+				ret += (controlPoints[i + 1] - controlPoints[i]) * (float)(b * binomialCoefficient(n - 1, i));
+				b *= s;
+			}
+		}
+		else ret = controlPoints[n] - controlPoints[n - 1];
+		return ret * (float)n;
+	}
+
+	// Points at count arbitrary parameters
+	void evaluate(const float* t, Vec3* out, int count) const {
+		for (int i = 0; i < count; i++) out[i] = evaluateT(t[i]);
+	}
+
+	// count points at uniform steps of t from 0 to 1 (both ends included)
+	// Forward differencing: the k-th difference at t = 0 is sum_j c[j] * h^j * k! * S(j, k) (S = Stirling numbers
+	// of the second kind), after that every point costs n adds
+	void sample(Vec3* out, int count) const {
+		int n = degree();
+		if (count <= 0 || n < 0) return;
+		if (count == 1 || powerBasis.empty()) {
+			for (int i = 0; i < count; i++) out[i] = evaluateT(count == 1 ? 0.f : (float)i / (count - 1));
+			return;
+		}
+
+		double h = 1.0 / (count - 1);
+		double stirling[maxForwardDifferenceDegree + 1][maxForwardDifferenceDegree + 1] = {};
+		stirling[0][0] = 1.0;
+		for (int j = 1; j <= n; j++)
+			for (int k = 1; k <= j; k++) stirling[j][k] = k * stirling[j - 1][k] + stirling[j - 1][k - 1];
+
+		double d[3 * (maxForwardDifferenceDegree + 1)] = {};
+		double factorial = 1.0;
+		for (int k = 0; k <= n; k++) {
+			if (k > 0) factorial *= k;
+			double hj = 1.0;
+			for (int j = 0; j <= n; j++, hj *= h) {
+				if (j < k) continue;
+				double f = hj * factorial * stirling[j][k];
+				for (int a = 0; a < 3; a++) d[3 * k + a] += powerBasis[3 * j + a] * f;
+			}
+		}
+
+		for (int i = 0; i < count; i++) {
+			out[i] = Vec3((float)d[0], (float)d[1], (float)d[2]);
+			for (int k = 0; k < n; k++)
+				for (int a = 0; a < 3; a++) d[3 * k + a] += d[3 * (k + 1) + a];
 		}
-		return result;
+		out[count - 1] = controlPoints[n];
 	}
-};
\ No newline at end of file
+
+	// Arc-Length Parameterisation
+	// Chord lengths over segments uniform steps of t, accurate while the steps are short compared to the curvature
+	void buildArcLengthTable(int segments) {
+		arcLengths.clear();
+		if (segments < 1 || controlPoints.empty()) return;
+		std::vector<Vec3> points(segments + 1);
+		sample(&points[0], segments + 1);
+		arcLengths.resize(segments + 1);
+		arcLengths[0] = 0.f;
+		for (int i = 1; i <= segments; i++) arcLengths[i] = arcLengths[i - 1] + (points[i] - points[i - 1]).length();
+	}
+
+	float length() const { return arcLengths.empty() ? 0.f : arcLengths.back(); }
+
+	// Parameter t where the curve has covered distance (clamped to [0, length()])
+	float tFromDistance(float distance) const {
+		if (arcLengths.size() < 2 || distance <= 0.f) return 0.f;
+		if (distance >= arcLengths.back()) return 1.f;
+		int i = (int)(std::upper_bound(arcLengths.begin(), arcLengths.end(), distance) - arcLengths.begin()) - 1;
+		return segmentT(i, distance);
+	}
+
+	// Point at a fraction u in [0, 1] of the curve length, moves at constant speed as u changes linearly
+	Vec3 evaluateUniform(float u) const { return evaluateT(tFromDistance(u * length())); }
+
+	// count points evenly spaced along the curve (both ends included), walks the table once instead of searching it per point
+	void sampleUniform(Vec3* out, int count) const {
+		if (count <= 0) return;
+		if (count == 1 || arcLengths.size() < 2) {
+			for (int i = 0; i < count; i++) out[i] = evaluateT(count == 1 ? 0.f : (float)i / (count - 1));
+			return;
+		}
+		int segments = (int)arcLengths.size() - 1;
+		float step = arcLengths.back() / (count - 1);
+		int seg = 0;
+		for (int i = 0; i < count; i++) {
+			float distance = i * step;
+			while (seg < segments - 1 && arcLengths[seg + 1] < distance) seg++;
+			out[i] = evaluateT(std::min<float>(segmentT(seg, distance), 1.f));
+		}
+	}
+
+private:
+	// t inside table segment i for a distance between arcLengths[i] and arcLengths[i + 1]
+	float segmentT(int i, float distance) const {
+		float span = arcLengths[i + 1] - arcLengths[i];
+		float f = span > 0.f ? (distance - arcLengths[i]) / span : 0.f;
+		return (i + f) / (arcLengths.size() - 1);
+	}
+};
+
+// Compile-Time Checks
+// The constexpr builders evaluated by the compiler: if a runtime-only call slips into one of them (or the constant
+// evaluated switch stops working on a compiler) the build stops here instead of the transforms quietly moving to
+// runtime
+namespace MyMathCompileTimeChecks {
+	constexpr bool near(float value, float expected, float tolerance = 1e-6f) {
+		return (value > expected ? value - expected : expected - value) <= tolerance;
+	}
+
+	constexpr bool near(const Vec3& value, const Vec3& expected, float tolerance = 1e-6f) {
+		return near(value.x, expected.x, tolerance) && near(value.y, expected.y, tolerance) && near(value.z, expected.z, tolerance);
+	}
+
+	constexpr bool near(const Matrix& value, const Matrix& expected, float tolerance = 1e-6f) {
+		for (int i = 0; i < 16; i++)
+			if (!near(value.m[i], expected.m[i], tolerance)) return false;
+		return true;
+	}
+
+	// Trigonometry and square root
+	static_assert(constexprSin(0.f) == 0.f && constexprCos(0.f) == 1.f, "constexprSin/constexprCos at 0");
+	static_assert(near(constexprSin(M_PI / 6), 0.5f) && near(constexprCos(M_PI / 3), 0.5f), "constexprSin/constexprCos at pi/6, pi/3");
+	static_assert(near(constexprSin(-7.f), -0.6569866f) && near(constexprCos(100.f), 0.8623189f), "constexprSin/constexprCos range reduction");
+	static_assert(constexprSqrt(4.f) == 2.f && constexprSqrt(0.f) == 0.f && constexprSqrt(-1.f) == 0.f, "constexprSqrt exact cases");
+	static_assert(near(constexprSqrt(2.f), 1.4142135f) && near(constexprSqrt(1e-4f), 1e-2f, 1e-9f), "constexprSqrt");
+
+	// Builders
+	constexpr Matrix moved = Matrix::translate(Vec3(1.f, 2.f, 3.f));
+	constexpr Matrix scaled = Matrix::scale(Vec3(2.f, 3.f, 4.f));
+	static_assert(moved.m[3] == 1.f && moved.m[7] == 2.f && moved.m[11] == 3.f && moved.m[0] == 1.f && moved.m[15] == 1.f, "Matrix::translate");
+	static_assert(scaled.m[0] == 2.f && scaled.m[5] == 3.f && scaled.m[10] == 4.f && scaled.m[15] == 1.f && scaled.m[3] == 0.f, "Matrix::scale");
+	static_assert(near(Matrix::rotateOnXAxis(M_PI / 2).mulVec(Vec3(0.f, 1.f, 0.f)), Vec3(0.f, 0.f, -1.f)), "Matrix::rotateOnXAxis");
+	static_assert(near(Matrix::rotateOnYAxis(M_PI / 2).mulVec(Vec3(0.f, 0.f, 1.f)), Vec3(-1.f, 0.f, 0.f)), "Matrix::rotateOnYAxis");
+	static_assert(near(Matrix::rotateOnZAxis(M_PI / 2).mulVec(Vec3(1.f, 0.f, 0.f)), Vec3(0.f, -1.f, 0.f)), "Matrix::rotateOnZAxis");
+
+	// Products (the left matrix is applied first) and transpose
+	static_assert(near((moved * scaled).mulPoint(Vec3(0.f, 0.f, 0.f)), Vec3(2.f, 6.f, 12.f)), "Matrix::mul order");
+	static_assert(near((scaled * moved).mulPoint(Vec3(0.f, 0.f, 0.f)), Vec3(1.f, 2.f, 3.f)), "Matrix::mul order");
+	static_assert(near(Matrix::identity() * moved, moved) && near(moved * Matrix::identity(), moved), "Matrix::mul identity");
+	static_assert(moved.transpose().m[12] == 1.f && moved.transpose().m[13] == 2.f && moved.transpose().m[14] == 3.f, "Matrix::transpose");
+	static_assert(near(moved.transpose().transpose(), moved) && near((moved * scaled).transpose(), scaled.transpose() * moved.transpose()), "Matrix::transpose");
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "AnimatedModel.h"
 #include "Collision.h"
 #include "Core.h"
+#include "HitboxRig.h"
 
 enum NPCState {
 	NPCAttack,
@@ -30,7 +31,7 @@ std::string getNPCAnimationByState(NPCState npcstate) {
 class NPC {
 private:
 	AnimationInstance animationInstance;
-	BoundingSphere hitbox;
+	HitboxRig hitboxes;
 	NPCState npcstate;
 
 	int health{ 5000 };
@@ -53,7 +54,7 @@ public:
 		animatedModel.load(core, psos, textures, shaders, filename);  // "Models/TRex.gem"
 		animationInstance.initialize(&animatedModel.animation, 0);
 		npcstate = NPCWalk;
-		hitbox.radius = 2.f;
+		hitboxes = animatedModel.hitboxes;		// Posed by every animate
 	}
 
 	void takeDamage(int damage) {
@@ -65,21 +66,32 @@ public:
 		}
 	}
 
+	// Posed hitboxes for melee, nullptr once dead so nothing lands on the body
+	const HitboxRig* getHitboxes() const { return isAlive ? &hitboxes : nullptr; }
+
+	// Nearest hitbox capsule along the ray (bullets), hit.bone tells which limb was hit
+	bool raycast(const Ray& ray, RigHit& hit, float tMax = FLT_MAX) const {
+		if (!isAlive) return false;
+		return hitboxes.raycast(ray, hit, tMax);
+	}
+
 	void attack(Character* character, int damage) {
 		if (!isAttacking) return;
 		npcstate = NPCRoar;
-		if (collisionSphereSphere(character->hitbox, this->hitbox)) {
+		if (hitboxes.overlap(character->hitbox) >= 0) {
 			npcstate = NPCRoar;
 			character->takeDamage(damage);
 		}
 	}
 
-	void animate(float dt) {
+	// Hitboxes follow the pose and the place the NPC is drawn at, so world has to be the one given to draw
+	void animate(float dt, const Matrix& world) {
 		updateAnimation(dt);
+		hitboxes.update(animationInstance.matrices, world);
 		resetAnimationTime();
 	}
 
-	void draw(Core* core, TextureManager* textures, PSOManager* psos, ShaderManager* shaders, Matrix& vp, Matrix& w) {
+	void draw(Core* core, TextureManager* textures, PSOManager* psos, ShaderManager* shaders, Matrix& vp, const Matrix& w) {
 		if (!isAlive && animationInstance.animationFinished()) return;
 		animatedModel.draw(core, &animationInstance, textures, psos, shaders, vp, w);
 	}
@@ -0,0 +1,363 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Collision.h"
+#include "ConvexHull.h"
+#include "MyMath.h"
+
+// Narrowphase
+// Turns the pair list of a broadphase (SpatialHash or DynamicAABBTree) into contacts for a resolver. Every pair keeps
+// an entry in a cache keyed by its two shape ids for as long as the broadphase keeps reporting it. A pair whose
+// shapes have not changed since the last frame reuses its contact as is. A pair that moved starts from what the
+// entry remembers: the last SAT axis for boxes, the GJK direction and support vertices for capsules against boxes.
+// What is remembered only picks where the search starts, the answer is always proven on the shapes of this frame.
+// Pairs are processed in chunks on every core and the touching ones are written to one flat contact array in pair
+// order
+
+enum ShapeType {
+	ShapeSphere,
+	ShapeCapsule,
+	ShapeAABB,
+	ShapeOBB
+};
+
+// One collider, only the member named by type is used
+struct Shape {
+	ShapeType type;
+	BoundingSphere sphere;
+	Capsule capsule;
+	AABB box;
+	OBB obb;
+
+	static Shape fromSphere(const BoundingSphere& sphere) { Shape shape; shape.type = ShapeSphere; shape.sphere = sphere; return shape; }
+	static Shape fromCapsule(const Capsule& capsule) { Shape shape; shape.type = ShapeCapsule; shape.capsule = capsule; return shape; }
+	static Shape fromAABB(const AABB& box) { Shape shape; shape.type = ShapeAABB; shape.box = box; return shape; }
+	static Shape fromOBB(const OBB& obb) { Shape shape; shape.type = ShapeOBB; shape.obb = obb; return shape; }
+
+	// Same type and the same bits in the member it uses
+	bool same(const Shape& other) const {
+		if (type != other.type) return false;
+		switch (type) {
+			case ShapeSphere: return memcmp(&sphere, &other.sphere, sizeof(sphere)) == 0;
+			case ShapeCapsule: return memcmp(&capsule, &other.capsule, sizeof(capsule)) == 0;
+			case ShapeAABB: return memcmp(&box, &other.box, sizeof(box)) == 0;
+			default: return memcmp(&obb, &other.obb, sizeof(obb)) == 0;
+		}
+	}
+
+	OBB toOBB() const { return type == ShapeAABB ? OBB(box) : obb; }
+
+	ConvexShape toConvex() const {
+		switch (type) {
+			case ShapeSphere: return ConvexShape::fromSphere(sphere);
+			case ShapeCapsule: return ConvexShape::fromCapsule(capsule);
+			case ShapeAABB: return ConvexShape::fromAABB(box);
+			default: return ConvexShape::fromOBB(obb);
+		}
+	}
+};
+
+// Contact Generation
+// One deepest point pair per shape pair, normal from a towards b as in ConvexContact
+
+// Spheres around two points (also the closest points of capsule cores)
+static bool contactPoints(const Vec3& centreA, float radiusA, const Vec3& centreB, float radiusB, ConvexContact& contact) {
+	Vec3 d = centreB - centreA;
+	float reach = radiusA + radiusB, lengthSquare = d.lengthSquare();
+	if (lengthSquare > reach * reach) return false;
+	float length = sqrtf(lengthSquare);
+	contact.normal = length > 0.f ? d / length : Vec3(0.f, 1.f, 0.f);
+	contact.depth = reach - length;
+	contact.pointA = centreA + contact.normal * radiusA;
+	contact.pointB = centreB - contact.normal * radiusB;
+	return true;
+}
+
+// A centre inside the box is pushed out through the nearest face
+static bool contactSphereObb(const BoundingSphere& sphere, const OBB& obb, ConvexContact& contact) {
+	Vec3 local = obb.toLocal(sphere.centre);
+	Vec3 q = Max(-obb.extent, Min(local, obb.extent));
+	if ((q - local).lengthSquare() > 0.f) {
+		Vec3 closest = obb.centre + obb.axis[0] * q.x + obb.axis[1] * q.y + obb.axis[2] * q.z;
+		if (!contactPoints(sphere.centre, sphere.radius, closest, 0.f, contact)) return false;
+		contact.pointB = closest;
+		return true;
+	}
+	int axis = 0;
+	float inside = FLT_MAX;
+	for (int i = 0; i < 3; i++) {
+		float distance = obb.extent.v[i] - fabsf(local.v[i]);
+		if (distance < inside) { inside = distance; axis = i; }
+	}
+	contact.normal = local.v[axis] >= 0.f ? -obb.axis[axis] : obb.axis[axis];
+	contact.depth = sphere.radius + inside;
+	contact.pointA = sphere.centre + contact.normal * sphere.radius;
+	contact.pointB = sphere.centre - contact.normal * inside;
+	return true;
+}
+
+// Least push along the world axes, the points are on the two faces it separates, centred on the overlap box
+static bool contactAabbAabb(const AABB& a, const AABB& b, ConvexContact& contact) {
+	Vec3 low = Max(a.min, b.min), high = Min(a.max, b.max);
+	if (low.x > high.x || low.y > high.y || low.z > high.z) return false;
+	int axis = 0;
+	float sign = 1.f;
+	contact.depth = FLT_MAX;
+	for (int i = 0; i < 3; i++) {
+		float up = a.max.v[i] - b.min.v[i], down = b.max.v[i] - a.min.v[i];
+		if (up < contact.depth) { contact.depth = up; axis = i; sign = 1.f; }
+		if (down < contact.depth) { contact.depth = down; axis = i; sign = -1.f; }
+	}
+	contact.normal = Vec3(0.f, 0.f, 0.f);
+	contact.normal.v[axis] = sign;
+	contact.pointA = contact.pointB = (low + high) * 0.5f;
+	contact.pointA.v[axis] = sign > 0.f ? a.max.v[axis] : a.min.v[axis];
+	contact.pointB.v[axis] = sign > 0.f ? b.min.v[axis] : b.max.v[axis];
+	return true;
+}
+
+// Least penetration over the 15 SAT axes of collisionObbObb (0-2 faces of a, 3-5 faces of b, then the edge pairs).
+// axis is the pair's last separating or contact axis and is tested first, a resting pair separated by the same
+// axis as last frame costs one projection. Edge axes need 5% less depth than the best face axis to win, so a
+// resting box does not flip between a face and a nearly parallel edge
+static bool contactObbObb(const OBB& a, const OBB& b, int& axis, ConvexContact& contact) {
+	Vec3 d = b.centre - a.centre;
+	auto axisAt = [&](int k) { return k < 3 ? a.axis[k] : k < 6 ? b.axis[k - 3] : Cross(a.axis[(k - 6) / 3], b.axis[(k - 6) % 3]); };
+	auto overlapOn = [&](const Vec3& n) {
+		float ra = a.extent.x * fabsf(Dot(a.axis[0], n)) + a.extent.y * fabsf(Dot(a.axis[1], n)) + a.extent.z * fabsf(Dot(a.axis[2], n));
+		float rb = b.extent.x * fabsf(Dot(b.axis[0], n)) + b.extent.y * fabsf(Dot(b.axis[1], n)) + b.extent.z * fabsf(Dot(b.axis[2], n));
+		return ra + rb - fabsf(Dot(d, n));
+	};
+
+	if (axis >= 0 && axis < 15) {
+		Vec3 n = axisAt(axis);
+		float length = n.length();
+		if (length > 1e-3f && overlapOn(n / length) < 0.f) return false;
+	}
+
+	int best = -1;
+	float bestDepth = FLT_MAX;
+	Vec3 bestAxis;
+	for (int k = 0; k < 15; k++) {
+		Vec3 n = axisAt(k);
+		if (k >= 6) {
+			float length = n.length();
+			if (length <= 1e-3f) continue;		// Parallel edges, the face axes cover them
+			n = n / length;
+		}
+		float depth = overlapOn(n);
+		if (depth < 0.f) {
+			axis = k;
+			return false;
+		}
+		if (k < 6 ? depth < bestDepth : depth < bestDepth * 0.95f) {
+			best = k;
+			bestDepth = depth;
+			bestAxis = n;
+		}
+	}
+	axis = best;
+
+	contact.normal = Dot(bestAxis, d) >= 0.f ? bestAxis : -bestAxis;
+	contact.depth = bestDepth;
+	contact.pointA = a.centre;
+	contact.pointB = b.centre;
+	for (int i = 0; i < 3; i++) {
+		contact.pointA += a.axis[i] * (Dot(a.axis[i], contact.normal) >= 0.f ? a.extent.v[i] : -a.extent.v[i]);
+		contact.pointB -= b.axis[i] * (Dot(b.axis[i], contact.normal) >= 0.f ? b.extent.v[i] : -b.extent.v[i]);
+	}
+	return true;
+}
+
+// Output of the narrowphase, one per touching pair
+struct Contact {
+	int a, b;			// Shape ids as listed in the pair
+	Vec3 normal;		// From a towards b, moving b by normal * depth separates the pair
+	float depth;
+	Vec3 point;			// Halfway between the deepest points of the two shapes
+	float impulse;		// What the resolver left here last frame for this pair (0 for a new contact), kept by update
+};
+
+class Narrowphase {
+public:
+	std::vector<Contact> contacts;		// Touching pairs of the last update, in pair order
+
+	// shapes is indexed by the ids in pairs (any struct with ints a and b, like SpatialHash::Pair). Shapes compared
+	// to the last update decide which pairs can keep their contact. threads 0 uses every core
+	template<typename Pair>
+	void update(const Shape* shapes, int shapeCount, const std::vector<Pair>& pairs, int threads = 0) {
+		frame++;
+		storeImpulses();
+		evict();
+
+		// Which shapes changed since the last update
+		int known = std::min<int>(shapeCount, (int)previous.size());
+		moved.resize(shapeCount);
+		previous.resize(shapeCount);
+		for (int i = 0; i < shapeCount; i++) {
+			moved[i] = i >= known || !shapes[i].same(previous[i]);
+			if (moved[i]) previous[i] = shapes[i];
+		}
+
+		// Entries are found or created serially, the pairs then only touch their own entry
+		pairEntries.resize(pairs.size());
+		for (size_t i = 0; i < pairs.size(); i++) {
+			unsigned long long key = pairKey(pairs[i].a, pairs[i].b);
+			auto found = lookup.find(key);
+			int entry;
+			if (found != lookup.end()) entry = found->second;
+			else {
+				entry = (int)entries.size();
+				entries.push_back(Entry());
+				entries[entry].key = key;
+				lookup[key] = entry;
+			}
+			Entry& e = entries[entry];
+			e.reusable = e.frame == frame - 1 && e.a == pairs[i].a && !moved[pairs[i].a] && !moved[pairs[i].b];
+			e.a = pairs[i].a;
+			e.b = pairs[i].b;
+			e.frame = frame;
+			pairEntries[i] = entry;
+		}
+
+		int pairCount = (int)pairs.size();
+		int chunkCount = (pairCount + chunkSize - 1) / chunkSize;
+		int workers = threads > 0 ? threads : (int)std::max<unsigned int>(1, std::thread::hardware_concurrency());
+		workers = std::min<int>(workers, chunkCount);
+		std::atomic<int> nextChunk(0);
+		auto work = [&] {
+			for (int chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+				int end = std::min<int>(pairCount, (chunk + 1) * chunkSize);
+				for (int i = chunk * chunkSize; i < end; i++) {
+					Entry& e = entries[pairEntries[i]];
+					if (!e.reusable) e.touching = collide(shapes[e.a], shapes[e.b], e);
+				}
+			}
+		};
+		if (workers > 1) {
+			std::vector<std::future<void>> tasks;
+			for (int i = 1; i < workers; i++) tasks.push_back(std::async(std::launch::async, work));
+			work();
+			for (std::future<void>& task : tasks) task.get();
+		}
+		else work();
+
+		contacts.clear();
+		contactEntries.clear();
+		for (int i = 0; i < pairCount; i++) {
+			const Entry& e = entries[pairEntries[i]];
+			if (!e.touching) continue;
+			Contact contact;
+			contact.a = e.a;
+			contact.b = e.b;
+			contact.normal = e.contact.normal;
+			contact.depth = e.contact.depth;
+			contact.point = (e.contact.pointA + e.contact.pointB) * 0.5f;
+			contact.impulse = e.impulse;
+			contacts.push_back(contact);
+			contactEntries.push_back(pairEntries[i]);
+		}
+	}
+
+	// Pairs remembered, the ones listed by the last two updates
+	int cachedPairs() const { return (int)entries.size(); }
+
+	// Contact between two shapes with a fresh cache, the dispatch used by update
+	static bool collide(const Shape& a, const Shape& b, ConvexContact& contact) {
+		Entry e;
+		bool touching = collide(a, b, e);
+		contact = e.contact;
+		return touching;
+	}
+
+private:
+	static const int chunkSize = 64;
+
+	struct Entry {
+		unsigned long long key = 0;
+		int a = -1, b = -1;
+		int frame = -2;				// Last update that listed the pair
+		int axis = -1;				// SAT axis for box pairs
+		GJKCache gjk;				// For pairs solved by GJK
+		ConvexContact contact;
+		float impulse = 0.f;
+		bool touching = false;
+		bool reusable = false;		// Listed last frame and neither shape changed since
+	};
+
+	std::vector<Entry> entries;
+	std::unordered_map<unsigned long long, int> lookup;
+	std::vector<int> pairEntries;
+	std::vector<int> contactEntries;
+	std::vector<Shape> previous;
+	std::vector<char> moved;
+	int frame = 0;
+
+	static unsigned long long pairKey(int a, int b) {
+		if (a > b) std::swap(a, b);
+		return ((unsigned long long)(unsigned int)a << 32) | (unsigned int)b;
+	}
+
+	// Resolver output of the last contacts goes back to their entries, and a contact that stops touching starts
+	// from 0 again
+	void storeImpulses() {
+		for (size_t i = 0; i < contacts.size(); i++) entries[contactEntries[i]].impulse = contacts[i].impulse;
+		for (Entry& e : entries)
+			if (!e.touching) e.impulse = 0.f;
+	}
+
+	// Drops the entries of pairs the last update did not list
+	void evict() {
+		for (size_t i = 0; i < entries.size();) {
+			if (entries[i].frame >= frame - 1) { i++; continue; }
+			lookup.erase(entries[i].key);
+			if (i + 1 < entries.size()) {
+				entries[i] = entries.back();
+				lookup[entries[i].key] = (int)i;
+			}
+			entries.pop_back();
+		}
+		contacts.clear();
+		contactEntries.clear();
+	}
+
+	// Dispatch on the type pair, b is swapped to come first when its type sorts lower and the normal flipped back
+	static bool collide(const Shape& a, const Shape& b, Entry& e) {
+		if (b.type < a.type) {
+			if (!collideOrdered(b, a, e)) return false;
+			e.contact.normal = -e.contact.normal;
+			std::swap(e.contact.pointA, e.contact.pointB);
+			return true;
+		}
+		return collideOrdered(a, b, e);
+	}
+
+	static bool collideOrdered(const Shape& a, const Shape& b, Entry& e) {
+		ConvexContact& contact = e.contact;
+		switch (a.type) {
+			case ShapeSphere:
+				switch (b.type) {
+					case ShapeSphere: return contactPoints(a.sphere.centre, a.sphere.radius, b.sphere.centre, b.sphere.radius, contact);
+					case ShapeCapsule: return contactPoints(a.sphere.centre, a.sphere.radius, b.capsule.closestPoint(a.sphere.centre), b.capsule.radius, contact);
+					default: return contactSphereObb(a.sphere, b.toOBB(), contact);
+				}
+			case ShapeCapsule:
+				if (b.type == ShapeCapsule) {
+					Vec3 pointA, pointB;
+					closestPointsSegments(a.capsule.a, a.capsule.b, b.capsule.a, b.capsule.b, pointA, pointB);
+					return contactPoints(pointA, a.capsule.radius, pointB, b.capsule.radius, contact);
+				}
+				return gjkPenetration(a.toConvex(), b.toConvex(), contact, &e.gjk);
+			default:
+				if (a.type == ShapeAABB && b.type == ShapeAABB) return contactAabbAabb(a.box, b.box, contact);
+				return contactObbObb(a.toOBB(), b.toOBB(), e.axis, contact);
+		}
+	}
+};
\ No newline at end of file
@@ -15,27 +15,17 @@ public:
 	std::vector<STATIC_VERTEX> vertices;
 	std::vector<unsigned int> indices;
 
-	STATIC_VERTEX addVertex(Vec3 p, Vec3 n, float tu, float tv) {
-		STATIC_VERTEX v;
-		Frame frame;
-		frame.fromVector(n);
-
-		v.pos = p;
-		v.normal = n;
-		v.tangent = frame.u;
-		v.tu = tu;
-		v.tv = tv;
-		return v;
-	}
-
 	void initialize(Core* core, PSOManager* psos, ShaderManager* shaders) {
-		vertices.push_back(addVertex(Vec3(-1.f, 0.f, -1.f), Vec3(0.f, 1.f, 0.f), 0.f, 0.f));
-		vertices.push_back(addVertex(Vec3(1.f, 0.f, -1.f), Vec3(0.f, 1.f, 0.f), 1.f, 0.f));
-		vertices.push_back(addVertex(Vec3(-1.f, 0.f, 1.f), Vec3(0.f, 1.f, 0.f), 0.f, 1.f));
-		vertices.push_back(addVertex(Vec3(1.f, 0.f, 1.f), Vec3(0.f, 1.f, 0.f), 1.f, 1.f));
+		// Quad geometry is known at compile time, the tangent is what Frame::fromVector gives for +y
+		static constexpr STATIC_VERTEX quad[4] = {
+			{ Vec3(-1.f, 0.f, -1.f), Vec3(0.f, 1.f, 0.f), Vec3(0.f, 0.f, -1.f), 0.f, 0.f },
+			{ Vec3(1.f, 0.f, -1.f), Vec3(0.f, 1.f, 0.f), Vec3(0.f, 0.f, -1.f), 1.f, 0.f },
+			{ Vec3(-1.f, 0.f, 1.f), Vec3(0.f, 1.f, 0.f), Vec3(0.f, 0.f, -1.f), 0.f, 1.f },
+			{ Vec3(1.f, 0.f, 1.f), Vec3(0.f, 1.f, 0.f), Vec3(0.f, 0.f, -1.f), 1.f, 1.f } };
+		static constexpr unsigned int quadIndices[6] = { 2, 1, 0, 1, 2, 3 };
 
-		indices.push_back(2); indices.push_back(1); indices.push_back(0);
-		indices.push_back(1); indices.push_back(2); indices.push_back(3);
+		vertices.assign(quad, quad + 4);
+		indices.assign(quadIndices, quadIndices + 6);
 
 		mesh.initialize(core, vertices, indices);
 		shaders->loadShader(core, "Plane", "VertexShaderStatic.txt", "PixelShader.txt");
@@ -43,7 +33,7 @@ public:
 		psos->createPSO(core, "PlanePSO", shaders->getShader(shadername)->vertexShader, shaders->getShader(shadername)->pixelShader, VertexLayoutCache::getStaticLayout());
 	}
 
-	void draw(Core* core, PSOManager* psos, ShaderManager* shaders, Matrix& vp, Matrix& w) {
+	void draw(Core* core, PSOManager* psos, ShaderManager* shaders, Matrix& vp, const Matrix& w) {
 		psos->bind(core, "PlanePSO");
 		shaders->updateConstantVertexShaderBuffer("Plane", "staticMeshBuffer", "W", &w);
 		shaders->updateConstantVertexShaderBuffer("Plane", "staticMeshBuffer", "VP", &vp);
@@ -57,7 +57,7 @@ public:
 		hr = constantBuffer->Map(0, &readRange, (void**)&buffer);
 	}
 
-	void update(std::string name, void* data) {
+	void update(std::string name, const void* data) {
 		ConstantBufferVariable cbVariable = constantBufferData[name];
 		unsigned int offset = offsetIndex * cbSizeInBytes;
 		memcpy(&buffer[offset + cbVariable.offset], data, cbVariable.size);
@@ -167,7 +167,7 @@ public:
 		}
 	}
 
-	void updateConstantBuffer(std::string constantBufferName, std::string variableName, void* data, std::vector<ConstantBuffer>& buffers) {
+	void updateConstantBuffer(std::string constantBufferName, std::string variableName, const void* data, std::vector<ConstantBuffer>& buffers) {
 		for (int i = 0; i < buffers.size(); i++) {
 			if (buffers[i].name == constantBufferName) {
 				buffers[i].update(variableName, data);
@@ -176,7 +176,7 @@ public:
 		}
 	}
 
-	void updateConstantPixelShaderBuffer(std::string constantBufferName, std::string variableName, void* data) {
+	void updateConstantPixelShaderBuffer(std::string constantBufferName, std::string variableName, const void* data) {
 		updateConstantBuffer(constantBufferName, variableName, data, psConstantBuffers);
 	}
 
@@ -187,7 +187,7 @@ public:
 		core->getCommandList()->SetGraphicsRootDescriptorTable(2, handle);
 	}
 	
-	void updateConstantVertexShaderBuffer(std::string constantBufferName, std::string variableName, void* data) {
+	void updateConstantVertexShaderBuffer(std::string constantBufferName, std::string variableName, const void* data) {
 		updateConstantBuffer(constantBufferName, variableName, data, vsConstantBuffers);
 	}
 
@@ -244,7 +244,7 @@ public:
 	}
 
 	// Update Constant PixelShader Buffer
-	void updateConstantPixelShaderBuffer(std::string shadername, std::string constantBufferName, std::string variableName, void* data) {
+	void updateConstantPixelShaderBuffer(std::string shadername, std::string constantBufferName, std::string variableName, const void* data) {
 		shaders[shadername].updateConstantPixelShaderBuffer(constantBufferName, variableName, data);
 	}
 
@@ -253,7 +253,7 @@ public:
 	}
 
 	// Update Constant VertexShader Buffer
-	void updateConstantVertexShaderBuffer(std::string shadername, std::string constantBufferName, std::string variableName, void* data) {
+	void updateConstantVertexShaderBuffer(std::string shadername, std::string constantBufferName, std::string variableName, const void* data) {
 		shaders[shadername].updateConstantVertexShaderBuffer(constantBufferName, variableName, data);
 	}
 };
\ No newline at end of file
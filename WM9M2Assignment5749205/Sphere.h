@@ -29,15 +29,16 @@ public:
 		return v;
 	}
 
+	template<typename MathPolicy = PreciseMath>
 	void initialize(Core* core, PSOManager* psos, TextureManager* textures, ShaderManager* shaders, int rings, int segments, float radius) {
 		for (int lat = 0; lat <= rings; lat++) {
 			float theta = lat * M_PI / rings;
-			float sinTheta = sinf(theta);
-			float cosTheta = cosf(theta);
+			float sinTheta = 0.f, cosTheta = 0.f;
+			MathPolicy::sincos(theta, sinTheta, cosTheta);
 			for (int lon = 0; lon <= segments; lon++) {
 				float phi = lon * 2.0f * M_PI / segments;
-				float sinPhi = sinf(phi);
-				float cosPhi = cosf(phi);
+				float sinPhi = 0.f, cosPhi = 0.f;
+				MathPolicy::sincos(phi, sinPhi, cosPhi);
 				Vec3 position(radius * sinTheta * cosPhi, radius * cosTheta, radius * sinTheta * sinPhi);
 				Vec3 normal = position.normalize();
 				float tu = 1.0f - (float)lon / segments;
@@ -65,7 +66,7 @@ public:
 		psos->createPSO(core, "SpherePSO", shaders->getShader(shadername)->vertexShader, shaders->getShader(shadername)->pixelShader, VertexLayoutCache::getStaticLayout());
 	}
 
-	void draw(Core* core, PSOManager* psos, TextureManager* textures, ShaderManager* shaders, Matrix& vp, Matrix& w) {
+	void draw(Core* core, PSOManager* psos, TextureManager* textures, ShaderManager* shaders, Matrix& vp, const Matrix& w) {
 		std::cout << "Models/Textures/citrus_orchard_road_puresky.png" << ' ' << textures->find("SkyboxTexture") << '\n';
 		psos->bind(core, "SpherePSO");
 		shaders->updateConstantVertexShaderBuffer("Sphere", "staticMeshBuffer", "W", &w);
@@ -2,16 +2,37 @@
 
 #include <vector>
 
+#include "ConvexHull.h"
 #include "Core.h"
 #include "GEMLoader.h"
 #include "Mesh.h"
+#include "MeshCollider.h"
 #include "PSOManager.h"
 #include "Shaders.h"
 #include "Texture.h"
 
+// Query data a static model can build from its vertices at load (bits of queryData). Nothing is built by default,
+// only models that are raycast or collided pay for it
+enum ModelQueryData {
+	ModelBoundsData = 1,		// bounds: box and sphere for broadphase and culling
+	ModelColliderData = 2,		// collider: triangle BVH for raycasts
+	ModelHullData = 4			// hull: convex hull for GJK queries
+};
+
+// Builds the query data selected by queryData
+inline void buildModelQueryData(int queryData, const std::vector<GEMLoader::GEMMesh>& gemmeshes, ModelBounds& bounds, MeshCollider& collider, ConvexHull& hull) {
+	if (queryData & ModelBoundsData) bounds.compute(gemmeshes);
+	if (queryData & ModelColliderData) collider.build(gemmeshes);
+	if (queryData & ModelHullData) hull.build(gemmeshes);
+}
+
 class StaticModel {
 public:
 	std::vector<Mesh*> meshes;
+	MeshCollider collider;		// Model space triangles for raycasts
+	ModelBounds bounds;
+	ConvexHull hull;			// Model space, for GJK queries (ConvexShape::fromHull with the world matrix)
+	int queryData = 0;			// ModelQueryData bits to build (set before load)
 
 	std::vector<std::string> albedoFilenames;
 	std::vector<std::string> normalFilenames;
@@ -24,6 +45,7 @@ public:
 		GEMLoader::GEMModelLoader loader;
 		std::vector<GEMLoader::GEMMesh> gemmeshes;
 		loader.load(filename, gemmeshes);
+		buildModelQueryData(queryData, gemmeshes, bounds, collider, hull);
 
 		for (int i = 0; i < gemmeshes.size(); i++) {
 			Mesh* mesh = new Mesh();
@@ -51,7 +73,7 @@ public:
 		psos->createPSO(core, psoname, shaders->getShader(shadername)->vertexShader, shaders->getShader(shadername)->pixelShader, VertexLayoutCache::getStaticLayout());
 	}
 
-	void draw(Core* core, PSOManager* psos, TextureManager* textures, ShaderManager* shaders, Matrix& vp, Matrix& w) {
+	void draw(Core* core, PSOManager* psos, TextureManager* textures, ShaderManager* shaders, Matrix& vp, const Matrix& w) {
 		psos->bind(core, psoname);
 		shaders->updateConstantVertexShaderBuffer(shadername, "staticMeshBuffer", "W", &w);
 		shaders->updateConstantVertexShaderBuffer(shadername, "staticMeshBuffer", "VP", &vp);
@@ -75,6 +97,10 @@ class StaticInstancedModel {
 public:
 	std::vector<Mesh*> meshes;
 	std::vector<INSTANCE_DATA> instances;
+	MeshCollider collider;		// Shared by every instance, see MeshCollider::raycastInstances
+	ModelBounds bounds;			// Of one instance in model space
+	ConvexHull hull;			// Of one instance in model space
+	int queryData = 0;			// ModelQueryData bits to build (set before load)
 
 	std::vector<std::string> albedoFilenames;
 	std::vector<std::string> normalFilenames;
@@ -88,6 +114,7 @@ public:
 		std::vector<GEMLoader::GEMMesh> gemmeshes;
 		loader.load(filename, gemmeshes);
 		instances = worlds;
+		buildModelQueryData(queryData, gemmeshes, bounds, collider, hull);
 
 		for (int i = 0; i < gemmeshes.size(); i++) {
 			Mesh* mesh = new Mesh();
@@ -52,6 +52,7 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 	sphere.initialize(&core, &psos, &textures, &shaders, 32, 32, 100.f);
 
 	StaticModel acacia;
+	acacia.queryData = ModelColliderData;
 	acacia.load(&core, &psos, &textures, &shaders, "Models/banana2.gem");
 
 	StaticInstancedModel instancedTree;
@@ -59,6 +60,10 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 
 	std::vector<INSTANCE_DATA> instances;
 	std::vector<INSTANCE_DATA> instancesGrass;
+
+	// Instances are turned half way round Y. The grid offset used to go through the scale and the turn as well
+	// (translate * scale * rotate), so it is passed to fromTRS already flipped on x and z and scaled
+	constexpr Quaternion halfTurnY(0.f, 0.f, 1.f, 0.f);
 	
 	for (int i = 1; i <= 24; i+=3) {
 		for (int j = 1; j <= 24; j+=3) {
@@ -67,45 +72,20 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 			INSTANCE_DATA insQ3;
 			INSTANCE_DATA insQ4;
 			
-			insQ1.world = Matrix::translate(Vec3((float)i * 100.f, -65.f, (float)j * 100.f)) * Matrix::scale(Vec3(0.03f, 0.03f, 0.03f)) * Matrix::rotateOnYAxis(M_PI);
+			insQ1.world = Matrix::fromTRS(Vec3(-(float)i * 100.f, -65.f, -(float)j * 100.f) * 0.03f, halfTurnY, Vec3(0.03f, 0.03f, 0.03f));
 			instances.push_back(insQ1);
 
-			insQ2.world = Matrix::translate(Vec3(-(float)i * 100.f, -65.f, (float)j * 100.f)) * Matrix::scale(Vec3(0.03f, 0.03f, 0.03f)) * Matrix::rotateOnYAxis(M_PI);
+			insQ2.world = Matrix::fromTRS(Vec3((float)i * 100.f, -65.f, -(float)j * 100.f) * 0.03f, halfTurnY, Vec3(0.03f, 0.03f, 0.03f));
 			instances.push_back(insQ2);
 
-			insQ3.world = Matrix::translate(Vec3((float)i * 100.f, -65.f, -(float)j * 100.f)) * Matrix::scale(Vec3(0.03f, 0.03f, 0.03f)) * Matrix::rotateOnYAxis(M_PI);
+			insQ3.world = Matrix::fromTRS(Vec3(-(float)i * 100.f, -65.f, (float)j * 100.f) * 0.03f, halfTurnY, Vec3(0.03f, 0.03f, 0.03f));
 			instances.push_back(insQ3);
 
-			insQ4.world = Matrix::translate(Vec3(-(float)i * 100.f, -65.f, -(float)j * 100.f)) * Matrix::scale(Vec3(0.03f, 0.03f, 0.03f)) * Matrix::rotateOnYAxis(M_PI);
+			insQ4.world = Matrix::fromTRS(Vec3((float)i * 100.f, -65.f, (float)j * 100.f) * 0.03f, halfTurnY, Vec3(0.03f, 0.03f, 0.03f));
 			instances.push_back(insQ4);
 		}
 	}
 
-	AABB bananaTreeAABB;
-	std::vector<AABB> bananaTreeAABBs;
-	bananaTreeAABB.min = Vec3(-100.f, -300.f, -100.f);
-	bananaTreeAABB.max = Vec3(100.f, 300.f, 100.f);
-
-	for (int i = 0; i < instances.size(); i++) {
-		AABB tree;
-		Vec3 treeCorners[8] = {
-			Vec3(bananaTreeAABB.min.x, bananaTreeAABB.min.y, bananaTreeAABB.min.z),
-			Vec3(bananaTreeAABB.max.x, bananaTreeAABB.min.y, bananaTreeAABB.min.z),
-			Vec3(bananaTreeAABB.min.x, bananaTreeAABB.max.y, bananaTreeAABB.min.z),
-			Vec3(bananaTreeAABB.min.x, bananaTreeAABB.min.y, bananaTreeAABB.max.z),
-			Vec3(bananaTreeAABB.max.x, bananaTreeAABB.max.y, bananaTreeAABB.min.z),
-			Vec3(bananaTreeAABB.max.x, bananaTreeAABB.min.y, bananaTreeAABB.max.z),
-			Vec3(bananaTreeAABB.min.x, bananaTreeAABB.max.y, bananaTreeAABB.max.z),
-			Vec3(bananaTreeAABB.max.x, bananaTreeAABB.max.y, bananaTreeAABB.max.z)
-		};
-
-		for (int j = 0; j < 8; j++) {
-			Vec3 aabbWorld = instances[i].world.mulPoint(treeCorners[j]);
-			tree.extend(aabbWorld);
-		}
-		bananaTreeAABBs.push_back(tree);
-	}
-
 	for (int i = 1; i <= 136; i++) {
 		for (int j = 1; j <= 136; j++) {
 			if (i * 100 % 200 == 0 || j * 100 % 200) continue;
@@ -114,24 +94,36 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 			INSTANCE_DATA insGrassQ3;
 			INSTANCE_DATA insGrassQ4;
 			
-			insGrassQ1.world = Matrix::translate(Vec3((float)i * 50.f, -300.f, (float)j * 50.f)) * Matrix::scale(Vec3(0.01f, 0.01f, 0.01f)) * Matrix::rotateOnYAxis(M_PI);
+			insGrassQ1.world = Matrix::fromTRS(Vec3(-(float)i * 50.f, -300.f, -(float)j * 50.f) * 0.01f, halfTurnY, Vec3(0.01f, 0.01f, 0.01f));
 			instancesGrass.push_back(insGrassQ1);
 			
-			insGrassQ2.world = Matrix::translate(Vec3(-(float)i * 50.f, -300.f, (float)j * 50.f)) * Matrix::scale(Vec3(0.01f, 0.01f, 0.01f)) * Matrix::rotateOnYAxis(M_PI);
+			insGrassQ2.world = Matrix::fromTRS(Vec3((float)i * 50.f, -300.f, -(float)j * 50.f) * 0.01f, halfTurnY, Vec3(0.01f, 0.01f, 0.01f));
 			instancesGrass.push_back(insGrassQ2);
 
-			insGrassQ3.world = Matrix::translate(Vec3((float)i * 50.f, -300.f, -(float)j * 50.f)) * Matrix::scale(Vec3(0.01f, 0.01f, 0.01f)) * Matrix::rotateOnYAxis(M_PI);
+			insGrassQ3.world = Matrix::fromTRS(Vec3(-(float)i * 50.f, -300.f, (float)j * 50.f) * 0.01f, halfTurnY, Vec3(0.01f, 0.01f, 0.01f));
 			instancesGrass.push_back(insGrassQ3);
 
-			insGrassQ4.world = Matrix::translate(Vec3(-(float)i * 50.f, -300.f, -(float)j * 50.f)) * Matrix::scale(Vec3(0.01f, 0.01f, 0.01f)) * Matrix::rotateOnYAxis(M_PI);
+			insGrassQ4.world = Matrix::fromTRS(Vec3((float)i * 50.f, -300.f, (float)j * 50.f) * 0.01f, halfTurnY, Vec3(0.01f, 0.01f, 0.01f));
 			instancesGrass.push_back(insGrassQ4);
 		}
 	}
 
+	instancedTree.queryData = ModelBoundsData | ModelColliderData;
 	instancedTree.load(&core, &psos, &textures, &shaders, "Models/banana2.gem", instances);
+
+	// World boxes of the trees from the model's own bounds
+	// INSTANCE_DATA only holds the world matrix, so the instances can be read as a Matrix array
+	std::vector<AABB> bananaTreeAABBs(instances.size());
+	transformAABBs(instancedTree.bounds.box, &instances[0].world, &bananaTreeAABBs[0], (int)instances.size());
+
+	// Static scene BVH over the tree boxes, the player slides against it and bullets stop at it
+	BVH bananaTreeBVH;
+	bananaTreeBVH.build(bananaTreeAABBs);
+
 	instancedGrass.load(&core, &psos, &textures, &shaders, "Models/grass_008.gem", instancesGrass);
 
 	StaticModel truck;
+	truck.queryData = ModelColliderData;
 	truck.load(&core, &psos, &textures, &shaders, "Models/Truck_02b.gem");
 
 	AnimatedModel trex;
@@ -145,6 +137,30 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 	NPC npc;
 	npc.initialize(&core, &psos, &textures, &shaders, "Models/TRex.gem");
 
+	// Static world matrices are constant expressions, folded at compile time instead of rebuilt every frame
+	constexpr Matrix planeWorld = Matrix::identity();
+	constexpr Matrix sphereWorld = Matrix::identity() * Matrix::rotateOnYAxis(M_PI);
+	constexpr Matrix acaciaWorld = Matrix::scale(Vec3(0.02f, 0.02f, 0.02f)) * Matrix::translate(Vec3(-5.f, 1.f, 0.f)) * Matrix::rotateOnYAxis(M_PI);
+	constexpr Matrix truckWorld = Matrix::translate(Vec3(-10.f, -2.f, 0.f)) * Matrix::rotateOnYAxis(M_PI / 4);
+	constexpr Matrix trexWorld = Matrix::translate(Vec3(0.f, -160.f, -2000.f)) * Matrix::scale(Vec3(0.01f, 0.01f, 0.01f)) * Matrix::rotateOnYAxis(M_PI);
+	constexpr Matrix trexWorld2 = Matrix::translate(Vec3(110.f, -160.f, -1000.f)) * Matrix::scale(Vec3(0.01f, 0.01f, 0.01f)) * Matrix::rotateOnYAxis(M_PI);
+	// Where each folded world puts the model origin and its x axis (the checks fail the build if one stops folding)
+	static_assert(MyMathCompileTimeChecks::near(planeWorld, Matrix::identity()), "planeWorld");
+	static_assert(MyMathCompileTimeChecks::near(sphereWorld.mulVec(Vec3(1.f, 0.f, 0.f)), Vec3(-1.f, 0.f, 0.f)), "sphereWorld");
+	static_assert(MyMathCompileTimeChecks::near(acaciaWorld.mulPoint(Vec3(0.f, 0.f, 0.f)), Vec3(5.f, 1.f, 0.f), 1e-5f), "acaciaWorld");
+	static_assert(MyMathCompileTimeChecks::near(acaciaWorld.mulVec(Vec3(1.f, 0.f, 0.f)), Vec3(-0.02f, 0.f, 0.f)), "acaciaWorld");
+	static_assert(MyMathCompileTimeChecks::near(truckWorld.mulPoint(Vec3(0.f, 0.f, 0.f)), Vec3(-7.0710678f, -2.f, -7.0710678f), 1e-5f), "truckWorld");
+	static_assert(MyMathCompileTimeChecks::near(truckWorld.mulVec(Vec3(1.f, 0.f, 0.f)), Vec3(0.7071068f, 0.f, 0.7071068f)), "truckWorld");
+	static_assert(MyMathCompileTimeChecks::near(trexWorld.mulPoint(Vec3(0.f, 0.f, 0.f)), Vec3(0.f, -1.6f, 20.f), 1e-5f), "trexWorld");
+	static_assert(MyMathCompileTimeChecks::near(trexWorld2.mulPoint(Vec3(0.f, 0.f, 0.f)), Vec3(-1.1f, -1.6f, 10.f), 1e-5f), "trexWorld2");
+	static_assert(MyMathCompileTimeChecks::near(trexWorld2.mulVec(Vec3(1.f, 0.f, 0.f)), Vec3(-0.01f, 0.f, 0.f)), "trexWorld2");
+
+	// Bullets go into model space through the inverse worlds and stop at the nearest triangle of the truck or a tree
+	const Matrix acaciaInverse = acaciaWorld.invert();
+	const Matrix truckInverse = truckWorld.invert();
+	std::vector<Matrix> bananaTreeInverses(instances.size());
+	for (size_t i = 0; i < instances.size(); i++) bananaTreeInverses[i] = instances[i].world.invert();
+
 	Timer timer;
 	float time = 0.f;
 
@@ -166,25 +182,33 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 		if (window.keys[VK_LEFT]) camera.rotateY(0.8f * dt);
 		if (window.keys[VK_RIGHT]) camera.rotateY(-0.8f * dt);
 
+		// Posed before the player acts, so shots and melee test the pose drawn this frame
+		npc.animate(dt, trexWorld2);
+
 		// Player Control
-		character.movePlayer(&camera, &window, dt);
+		character.movePlayer(&camera, &window, dt, &bananaTreeBVH);
 		if (window.keys['I'] == 1) character.inspectWeapon();
-		if (window.keys['M'] == 1) character.meleeAttack();
+		if (window.keys['M'] == 1 && character.meleeAttack(npc.getHitboxes()) >= 0) npc.takeDamage(character.getMeleeDamage());
 		if (window.keys['P'] == 1) character.putawayWeapon();
 		if (window.keys['O'] == 1) character.selectWeapon();
 		if (window.keys['R'] == 1) character.reload();
 		if (window.keys[VK_SPACE] == 1) character.toggleAlternateFireMode();
-		if (window.keys['F'] == 1) character.shoot();
+		if (window.keys['F'] == 1 && character.shoot()) {
+			// The nearest static triangle stops the bullet (the tree BVH picks the trees it can reach), the NPC only
+			// takes it when it is nearer
+			Ray shot(camera.position, camera.dir);
+			float tMax = FLT_MAX;
+			TriangleHit surface;
+			if (instancedTree.collider.raycastInstances(shot, bananaTreeBVH, &bananaTreeInverses[0], surface, tMax)) tMax = surface.t;
+			if (acacia.collider.raycast(shot, acaciaInverse, surface, tMax)) tMax = surface.t;
+			if (truck.collider.raycast(shot, truckInverse, surface, tMax)) tMax = surface.t;
+			RigHit hit;
+			if (npc.raycast(shot, hit, tMax)) npc.takeDamage(character.getBulletDamage());
+		}
 		character.animate(dt);
 
-		Matrix planeWorld = Matrix::identity();
 		Matrix cubeWorld = Matrix::translate(Vec3(-5.f, 0.f, 0.f)) * Matrix::rotateOnYAxis(M_PI);
-		Matrix sphereWorld = Matrix::identity() * Matrix::rotateOnYAxis(M_PI);
-		Matrix acaciaWorld = Matrix::scale(Vec3(0.02f, 0.02f, 0.02f)) * Matrix::translate(Vec3(-5.f, 1.f, 0.f)) * Matrix::rotateOnYAxis(M_PI);
-		Matrix truckWorld = Matrix::translate(Vec3(-10.f, -2.f, 0.f)) * Matrix::rotateOnYAxis(M_PI / 4);
-		Matrix trexWorld = Matrix::translate(Vec3(0.f, -160.f, -2000.f)) * Matrix::scale(Vec3(0.01f, 0.01f, 0.01f)) * Matrix::rotateOnYAxis(M_PI);
-		Matrix trexWorld2 = Matrix::translate(Vec3(110.f, -160.f, -1000.f)) * Matrix::scale(Vec3(0.01f, 0.01f, 0.01f)) * Matrix::rotateOnYAxis(M_PI);
-		Matrix characterWorld = Matrix::scale(Vec3(0.3f, 0.3f, 0.3f)) * Matrix::rotateOnYAxis(M_PI) * Matrix::translate(Vec3(0.f, 1.f, 0.f)) * camera.view.invert();
+		Matrix characterWorld = Matrix::scale(Vec3(0.3f, 0.3f, 0.3f)) * Matrix::rotateOnYAxis(M_PI) * Matrix::translate(Vec3(0.f, 1.f, 0.f)) * camera.viewInverse();
 
 		core.beginRenderPass();
 
@@ -200,7 +224,6 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 		if (animatedInstance.animationFinished() == true) animatedInstance.resetAnimationTime();
 		trex.draw(&core, &animatedInstance, &textures, &psos, &shaders, vp, trexWorld);
 
-		npc.animate(dt);
 		npc.draw(&core, &textures, &psos, &shaders, vp, trexWorld2);
 		
 		character.draw(&core, &textures, &psos, &shaders, vp, characterWorld);